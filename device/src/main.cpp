@@ -4,8 +4,13 @@
 #include <AudioFileSourceHTTPStream.h>
 #include <AudioGeneratorMP3.h>
 #include <AudioOutputI2S.h>
+#include <Preferences.h>
 #include "esp_camera.h"
 #include "pins_layout.h"
+#include "NoiseFloor.h"
+#include "SoundMeter.h"
+#include "PirEdges.h"
+#include "SleepWake.h"
 
 //=== User-configurable ===
 const char* ssid     = "yuuu";
@@ -14,7 +19,13 @@ const char* songURL  = "http://ice1.somafm.com/groovesalad-128-mp3";
 const float  gain    = 0.2;
 
 // sensor thresholds & timings
-const int   SOUND_THRESHOLD         = 2000;
+const int   SOUND_THRESHOLD         = 2000;   // until the noise floor is learned
+const int   SOUND_DEV_GAIN          = 4;      // trip level, in floor deviations
+const int   SOUND_MIN_MARGIN        = 100;
+const unsigned long NOISE_SAVE_MS   = 15UL * 60 * 1000;
+const int   METER_BURST             = 16;     // mic reads per loop pass for the level meter
+const size_t METER_BYTES            = 16 * 1024;  // ~2 h of per-second levels
+const size_t METER_BATCH            = 300;    // records per /levels response
 const unsigned long SOUND_DETECT_MS = 5000;   // 5s continuous
 const unsigned long MOTION_WINDOW_MS= 10000;  // 10s rolling window
 const int   MOTION_THRESHOLD        = 3;      // 3 distinct PIR trips
@@ -46,24 +57,40 @@ bool buttonState       = LOW;
 unsigned long lastDebounceTime = 0;
 const unsigned long DEBOUNCE_DELAY = 50;
 
-// --- motion detection (rolling window) ---
-bool  lastPirState     = LOW;
-int   motionCount      = 0;
-unsigned long motionWindowStart = 0;
-bool  motionWake       = false;
+// --- motion (rolling window) -> cry (continuous sound) -> lullaby ---
+PirEdges pirEdges;                 // PIR rises/falls, queued by the GPIO ISR
+struct DeviceTiming {
+  static const uint32_t HOLD_MS            = 0;
+  static const uint8_t  RISES              = MOTION_THRESHOLD;
+  static const uint32_t RISE_WINDOW_MS     = MOTION_WINDOW_MS;
+  static const uint32_t LISTEN_MS          = 0;  // listen until a cry
+  static const uint32_t CRY_MS             = SOUND_DETECT_MS;
+  static const int      MAX_LULLABIES      = ::MAX_LULLABIES;
+  static const bool     DEAF_WHILE_PLAYING = true;
+};
+typedef SleepWake<DeviceTiming> Nursery;
+Nursery nursery;
 
-// --- cry detection (continuous) ---
-bool  cryAbove         = false;
-unsigned long cryStartTime = 0;
+// --- adaptive sound threshold ---
+NoiseFloor  soundFloor;
+Preferences noisePrefs;
+DcTracker   micDcTrack(6);  // per sample
+int   micDc            = 2048;
+int   soundThreshold   = SOUND_THRESHOLD;
 
-// --- lullaby tracking ---
-int   lullabyCount     = 0;
+// --- sound-level telemetry ---
+SoundMeter soundMeter;
+uint8_t    meterStore[METER_BYTES];
 
 // Forward declarations
 void sendWarningToApp();
 void sendVibrateCommand();
 void sendTestFeedback(const char* msg);
 void resetAll();
+int  readSound();
+void sampleSoundLevel(unsigned long now);
+void handleLevels();
+void reportMotion();
 
 void setup() {
   Serial.begin(115200);
@@ -72,10 +99,19 @@ void setup() {
   analogSetAttenuation(ADC_11db);
   pinMode(MIC_PIN, INPUT);
   pinMode(PIR_PIN, INPUT);
+  pirEdges.begin(PIR_PIN);
   pinMode(ONOFF_PIN, INPUT_PULLUP);
   pinMode(ALERT_LED_PIN, OUTPUT);
   digitalWrite(ALERT_LED_PIN, LOW);
 
+  // learned noise floor survives reboots
+  noisePrefs.begin("noise", false);
+  soundFloor.begin();
+  soundFloor.restore(noisePrefs.getUInt("floor", 0));
+  micDc = noisePrefs.getInt("dc", micDc);
+  micDcTrack.restore(micDc);
+  soundMeter.begin(meterStore, sizeof(meterStore));
+
   // WiFi
   WiFi.begin(ssid, password);
   WiFi.setSleep(false);
@@ -95,6 +131,7 @@ void setup() {
     server.send(200, "text/plain", "Test mode OFF");
     Serial.println("==> Test mode DISABLED");
   });
+  server.on("/levels", handleLevels);
   server.begin();
   Serial.println("HTTP server started");
 
@@ -114,12 +151,14 @@ void loop() {
 
   // handle incoming HTTP commands
   server.handleClient();
+  sampleSoundLevel(now);
 
   // Test Mode: report motion & sound immediately
   if (testMode) {
+    pirEdges.clear();  // test mode reports the live level
     bool pir    = digitalRead(PIR_PIN);
-    int  soundV = analogRead(MIC_PIN);
-    bool soundH = (soundV > SOUND_THRESHOLD);
+    int  soundV = readSound();
+    bool soundH = (soundV > soundThreshold);
     if (pir) {
       sendTestFeedback("motion detected");
     }
@@ -145,50 +184,34 @@ void loop() {
   }
   lastButtonReading = reading;
 
-  if (!deviceActive) { delay(10); return; }
+  if (!deviceActive) { pirEdges.clear(); delay(10); return; }
 
   //--- PIR motion detection ---
-  bool pir = digitalRead(PIR_PIN);
-  bool rose = (pir==HIGH && lastPirState==LOW);
-  lastPirState = pir;
-  if (pir) {
-    if (motionWindowStart==0 || now-motionWindowStart>MOTION_WINDOW_MS) {
-      motionWindowStart = now; motionCount = 0;
-    }
-    if (rose) {
-      motionCount++;
-      Serial.printf(" PIR edge #%d\n", motionCount);
-      if (motionCount>=MOTION_THRESHOLD) {
-        motionWake = true;
-        Serial.println(" >> MOTION: waking");
-      }
-    }
-  } else if (motionWindowStart && now-motionWindowStart>MOTION_WINDOW_MS) {
-    motionWindowStart=0; motionCount=0;
+  // every rise counts, at its own time, however long the last pass took
+  PirEdge edge;
+  while (pirEdges.pop(edge)) {
+    if (nursery.pir(edge.high, edge.ms()) == Nursery::WOKE) reportMotion();
   }
+  now = millis();
+  if (nursery.pir(pirEdges.level(), now) == Nursery::WOKE) reportMotion();
 
   //--- cry detection (only if waking and not playing) ---
-  if (motionWake && !mp3->isRunning()) {
-    int soundV = analogRead(MIC_PIN);
-    bool soundH = (soundV > SOUND_THRESHOLD);
-    Serial.printf(" Sound=%d\n", soundV);
-    if (soundH) {
-      if (!cryAbove) { cryAbove=true; cryStartTime=now; }
-      else if (now-cryStartTime>=SOUND_DETECT_MS) {
-        Serial.println(" >> CRY detected");
-        sendWarningToApp();
-        if (lullabyCount<MAX_LULLABIES) {
-          lullabyCount++;
-          Serial.printf(" Playing lullaby #%d\n", lullabyCount);
-          mp3->begin(file, out);
-          digitalWrite(ALERT_LED_PIN, HIGH);
-        } else {
-          Serial.println(" Max lullabies reached → vibrate");
-          sendVibrateCommand();
-        }
-        cryAbove=false; motionWake=false; motionWindowStart=0;
+  if (nursery.listening()) {
+    bool playing = mp3->isRunning();
+    bool soundH  = !playing && readSound() > soundThreshold;
+    Nursery::Action a = nursery.cry(soundH, now, playing);
+    if (a == Nursery::SOOTHE || a == Nursery::ESCALATE) {
+      Serial.println(" >> CRY detected");
+      sendWarningToApp();
+      if (a == Nursery::SOOTHE) {
+        Serial.printf(" Playing lullaby #%d\n", nursery.lullabies());
+        mp3->begin(file, out);
+        digitalWrite(ALERT_LED_PIN, HIGH);
+      } else {
+        Serial.println(" Max lullabies reached → vibrate");
+        sendVibrateCommand();
       }
-    } else cryAbove=false;
+    }
   }
 
   //--- playback loop ---
@@ -204,6 +227,56 @@ void loop() {
   delay(10);
 }
 
+// one mic read for the threshold compare; sampleSoundLevel() keeps the
+// threshold itself up to date
+int readSound() {
+  return analogRead(MIC_PIN);
+}
+
+// a short burst of mic reads per loop pass is plenty for per-second levels,
+// and it teaches the DC and the noise floor the quiet room, not just the
+// cries heard while listening. The DC follows every read; the floor takes
+// one per pass, the rate its step is tuned for. A lullaby playing isn't the
+// room: neither learns from it.
+void sampleSoundLevel(unsigned long now) {
+  bool learn = !mp3->isRunning();
+  int  v     = micDc;
+  for (int i = 0; i < METER_BURST; i++) {
+    v = analogRead(MIC_PIN);
+    soundMeter.add(v, micDc);
+    if (learn) micDc = micDcTrack.update(v);
+  }
+  if (learn) soundFloor.update(abs(v - micDc));
+  soundMeter.poll(now);
+
+  int margin = SOUND_DEV_GAIN * (int)soundFloor.floor();
+  soundThreshold = micDc + (margin > SOUND_MIN_MARGIN ? margin : SOUND_MIN_MARGIN);
+
+  static unsigned long lastSave = 0;
+  static uint32_t savedFloor = soundFloor.floor();
+  if (now - lastSave >= NOISE_SAVE_MS) {
+    lastSave = now;
+    uint32_t f = soundFloor.floor();
+    if ((f > savedFloor ? f - savedFloor : savedFloor - f) > savedFloor / 8) {
+      noisePrefs.putUInt("floor", f);
+      noisePrefs.putInt("dc", micDc);
+      savedFloor = f;
+    }
+  }
+}
+
+// GET /levels?since=<seq>: next batch of per-second Leq/peak records
+void handleLevels() {
+  static char json[METER_BATCH * 16 + 128];
+  uint32_t since = server.hasArg("since") ? server.arg("since").toInt() : 0;
+  size_t   len   = soundMeter.writeJson(json, sizeof(json), since, METER_BATCH);
+  if (!len) {
+    server.send(500, "text/plain", "level batch too large");
+    return;
+  }
+  server.send(200, "application/json", json);
+}
+
 // send a warning to parents' app (push or HTTP)
 void sendWarningToApp() {
   Serial.println("[APP] Warning: baby crying!");
@@ -216,6 +289,13 @@ void sendVibrateCommand() {
   // TODO: HTTP call
 }
 
+// once per wake-up, not per PIR edge: the edge queue's health rides along
+void reportMotion() {
+  PirEdges::Stats ps = pirEdges.stats();
+  Serial.printf(" >> MOTION: waking (edge %u ms queued, %u overflows, ISR max %u cyc)\n",
+                ps.lastLatencyUs / 1000, ps.overflows, ps.isrMaxCycles);
+}
+
 // send feedback in test mode
 void sendTestFeedback(const char* msg) {
   Serial.printf("[TEST] %s\n", msg);
@@ -224,8 +304,7 @@ void sendTestFeedback(const char* msg) {
 
 // reset all states when turning off
 void resetAll() {
-  motionCount=0; motionWindowStart=0; motionWake=false;
-  cryAbove=false; lullabyCount=0;
+  nursery.reset();
   if (mp3->isRunning()) mp3->stop();
   digitalWrite(ALERT_LED_PIN, LOW);
 }
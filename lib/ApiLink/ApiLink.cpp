@@ -0,0 +1,109 @@
+#include "ApiLink.h"
+
+void ApiLink::begin(const char* host) {
+  host_ = host;
+  http_.setReuse(true);
+}
+
+void ApiLink::header(const String& name, const String& value) {
+  if (extraCount_ >= 2) return;
+  extra_[extraCount_][0] = name;
+  extra_[extraCount_][1] = value;
+  extraCount_++;
+}
+
+// Whether the call can go out on the open connection.
+bool ApiLink::warm() {
+  if (!client_.connected()) return false;
+  if (idleMs_ && millis() - lastUseMs_ >= idleMs_) {
+    client_.stop();  // the server will have closed it by now
+    stats_.expired++;
+    return false;
+  }
+  return true;
+}
+
+bool ApiLink::open(const String& path, const char* type) {
+  if (!http_.begin(client_, String("https://") + host_ + path)) return false;
+  if (token_.length()) http_.addHeader("Authorization", "Bearer " + token_);
+  if (type) http_.addHeader("Content-Type", type);
+  for (int i = 0; i < extraCount_; i++) http_.addHeader(extra_[i][0], extra_[i][1]);
+  return true;
+}
+
+int ApiLink::done(int code, bool warm, uint32_t startMs, String* response) {
+  if (response) *response = code > 0 ? http_.getString() : String();
+  http_.end();  // keeps the socket unless the server asked to close
+  lastUseMs_  = millis();
+  uint32_t ms = lastUseMs_ - startMs;
+  stats_.lastMs = ms;
+  if (ms > stats_.maxMs) stats_.maxMs = ms;
+  if (code < 0) stats_.failures++;
+  else if (warm) stats_.reuseMs += ms;
+  else {
+    stats_.connects++;
+    stats_.connectMs += ms;
+  }
+  return code;
+}
+
+// A reused socket the server has closed fails on send or on the first
+// read; a read timeout may mean the request got through, so it is not sent
+// again.
+static bool dropped(int code) {
+  return code < 0 && code != HTTPC_ERROR_READ_TIMEOUT;
+}
+
+int ApiLink::call(const char* method, const String& path, const char* type,
+                  const uint8_t* body, size_t len, String* response) {
+  stats_.calls++;
+  uint32_t start = millis();  // a retry's time is the call's
+  int      code;
+  for (int attempt = 0;; attempt++) {
+    bool reused = warm();
+    if (!open(path, type)) {
+      code = HTTPC_ERROR_CONNECTION_REFUSED;
+      stats_.failures++;
+      break;
+    }
+    code = http_.sendRequest(method, (uint8_t*)body, len);
+    if (!(reused && dropped(code)) || attempt) {
+      code = done(code, reused, start, response);
+      break;
+    }
+    http_.end();
+    client_.stop();
+    stats_.retries++;
+  }
+  extraCount_ = 0;
+  return code;
+}
+
+int ApiLink::call(const char* method, const String& path, const char* type, Stream* body, size_t len) {
+  stats_.calls++;
+  uint32_t start = millis();
+  int      code;
+  for (int attempt = 0;; attempt++) {
+    bool reused = warm();
+    if (!open(path, type)) {
+      code = HTTPC_ERROR_CONNECTION_REFUSED;
+      stats_.failures++;
+      break;
+    }
+    code = http_.sendRequest(method, body, len);
+    if (!(reused && dropped(code) && body->available() == (int)len) || attempt) {
+      code = done(code, reused, start, nullptr);
+      break;
+    }
+    http_.end();
+    client_.stop();
+    stats_.retries++;
+  }
+  extraCount_ = 0;
+  return code;
+}
+
+void ApiLink::close() {
+  http_.end();
+  client_.stop();
+}
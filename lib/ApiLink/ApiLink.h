@@ -0,0 +1,72 @@
+#pragma once
+// One keep-alive HTTPS connection to the cloud API, shared by every call.
+//
+// Each call used to open its own WiFiClientSecure, paying a TCP connect
+// and a full TLS handshake (hundreds of ms on the nursery Wi-Fi) for a few
+// hundred bytes. Here the client and HTTPClient live as long as the link,
+// with reuse on, so a call goes out on the open connection when the server
+// kept it. A connection idle for longer than the server keeps them (see
+// setIdleMs()) is closed before the call instead of being found dead. One
+// the server dropped anyway shows up as a failed send on the reused socket:
+// the call is retried once on a fresh connection, so callers never see it.
+// A Stream body is only retried if none of it had been read.
+//
+// Every call is timed, split by whether it had to connect first, so the
+// handshake cost shows in the stats. Connections are TlsClient's: the
+// server is verified against setCA() and sessions resume from the cache.
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include "TlsClient.h"
+
+class ApiLink {
+public:
+  struct Stats {
+    uint32_t calls;        // requests made, retries not counted twice
+    uint32_t connects;     // calls that opened a connection (TCP + TLS)
+    uint32_t expired;      // idle connections closed before a call
+    uint32_t retries;      // reused connections found dropped, sent again
+    uint32_t failures;     // calls that got no HTTP status, in neither of
+                           // the counts and times above
+    uint32_t connectMs;    // total time of calls that connected...
+    uint32_t reuseMs;      // ...and of calls on an open connection
+    uint32_t lastMs, maxMs;
+  };
+
+  void begin(const char* host);
+  // The CA that signed the server's certificate, PEM; no calls without it.
+  void setCA(const char* pem) { client_.setCA(pem); }
+  // TLS sessions are kept in `cache`, RTC memory to resume across sleep.
+  void setSessionCache(TlsClient::Cache* cache) { client_.setCache(cache); }
+  // The server's keep-alive timeout, or a little under; 0 if unknown.
+  void setIdleMs(uint32_t ms) { idleMs_ = ms; }
+  void setToken(const String& token) { token_ = token; }
+  // Extra header for the next call only.
+  void header(const String& name, const String& value);
+
+  // `method` `path` on the API host. With `response`, the body is read
+  // into it. Returns the HTTP status, or a negative HTTPClient error.
+  int call(const char* method, const String& path, const char* type = nullptr,
+           const uint8_t* body = nullptr, size_t len = 0, String* response = nullptr);
+  int call(const char* method, const String& path, const char* type, Stream* body, size_t len);
+
+  // Drop the connection, e.g. before Wi-Fi goes down.
+  void close();
+
+  const Stats&            stats()    const { return stats_; }
+  const TlsClient::Stats& tlsStats() const { return client_.tlsStats(); }
+
+private:
+  bool warm();
+  bool open(const String& path, const char* type);
+  int  done(int code, bool warm, uint32_t startMs, String* response);
+
+  TlsClient        client_;
+  HTTPClient       http_;
+  String           host_;
+  String           token_;
+  String           extra_[2][2];   // name, value
+  int              extraCount_ = 0;
+  uint32_t         idleMs_     = 0;
+  uint32_t         lastUseMs_  = 0;   // end of the last call
+  Stats            stats_      = {};
+};
@@ -0,0 +1,228 @@
+#include "TlsClient.h"
+#include <stddef.h>
+#include <string.h>
+
+static const uint32_t MAGIC = 0x544C5343;  // "TLSC"
+
+// CRC-32 (IEEE), bitwise: only rewritten after a handshake
+static uint32_t crc32(uint32_t crc, const void* data, size_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+// the header and the session bytes in use
+static uint32_t cacheCrc(const TlsClient::Cache* c) {
+  size_t len = c->len <= TlsClient::SESSION_MAX ? c->len : 0;
+  return crc32(crc32(0, c, offsetof(TlsClient::Cache, session)), c->session, len);
+}
+
+// FNV-1a
+static uint32_t hostHash(const char* s) {
+  uint32_t h = 2166136261u;
+  while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+  return h;
+}
+
+void TlsClient::setCache(Cache* cache) {
+  cache_ = cache;
+  if (cache->magic == MAGIC && cache->len <= SESSION_MAX && cache->crc == cacheCrc(cache)) return;
+  memset(cache, 0, offsetof(Cache, session));
+  cache->magic = MAGIC;
+  seal();
+}
+
+void TlsClient::forget() {
+  if (!cache_) return;
+  cache_->len = 0;
+  seal();
+}
+
+bool TlsClient::cached(uint32_t host) const {
+  return cache_ && cache_->len && cache_->host == host;
+}
+
+void TlsClient::seal() {
+  cache_->crc = cacheCrc(cache_);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+  if (!ca_) {
+    stats_.failures++;
+    return 0;
+  }
+  uint32_t h       = hostHash(host);
+  bool     offered = cached(h);
+  if (cache_ && !offered) {
+    cache_->host = h;   // a session for another host is no use here
+    cache_->len  = 0;
+  }
+  bool     resumed = false;
+  uint32_t start   = millis();
+  int      ok      = handshake(host, port, timeoutMs, resumed);
+  uint32_t ms      = millis() - start;
+  if (cache_) seal();
+  if (!ok) {
+    stats_.failures++;
+    return 0;
+  }
+  if (resumed) {
+    stats_.resumed++;
+    stats_.resumedMs += ms;
+  } else {
+    stats_.full++;
+    stats_.fullMs += ms;
+    if (offered) stats_.refused++;
+  }
+  return 1;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+  return connect(ip.toString().c_str(), port, timeoutMs);
+}
+
+#ifdef ESP_PLATFORM
+// The sim has its own handshake(), in tools/sim/tls.cpp.
+#include <errno.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/error.h>
+
+// AES-GCM and SHA on the crypto blocks, P-256 first; see the header.
+static const int CIPHERSUITES[] = {
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+  0
+};
+static const mbedtls_ecp_group_id CURVES[] = {
+  MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_CURVE25519, MBEDTLS_ECP_DP_SECP384R1, MBEDTLS_ECP_DP_NONE
+};
+
+// Wait until the socket can do what mbedtls asked for, or `ms` pass.
+static bool waitFor(int fd, bool write, int32_t ms) {
+  if (ms <= 0) return false;
+  fd_set set;
+  FD_ZERO(&set);
+  FD_SET(fd, &set);
+  struct timeval tv = { ms / 1000, (ms % 1000) * 1000 };
+  return select(fd + 1, write ? nullptr : &set, write ? &set : nullptr, nullptr, &tv) > 0;
+}
+
+static int tcpConnect(const char* host, uint16_t port, int32_t ms) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip)) return -1;
+  int fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0) return -1;
+  struct sockaddr_in addr = {};
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = (uint32_t)ip;
+  addr.sin_port        = htons(port);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  int res = lwip_connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+  if (res < 0 && errno == EINPROGRESS && waitFor(fd, true, ms)) {
+    int       err = 0;
+    socklen_t len = sizeof(err);
+    res = getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0 ? 0 : -1;
+  }
+  if (res < 0) {
+    lwip_close(fd);
+    return -1;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;   // left non-blocking, as WiFiClientSecure's I/O expects
+}
+
+int TlsClient::handshake(const char* host, uint16_t port, int32_t timeoutMs, bool& resumed) {
+  sslclient_context* c = sslclient;
+  int32_t  ms    = timeoutMs > 0 ? timeoutMs : (int32_t)c->handshake_timeout;
+  uint32_t start = millis();
+  int      ret;
+
+  c->socket = tcpConnect(host, port, ms);
+  if (c->socket < 0) {
+    log_e("connect to %s:%u failed", host, port);
+    return 0;
+  }
+
+  // as start_ssl_client(), so that stop() frees it all the same way
+  mbedtls_entropy_init(&c->entropy_ctx);
+  mbedtls_ssl_session offer, got;
+  mbedtls_ssl_session_init(&offer);
+  mbedtls_ssl_session_init(&got);
+  bool offering = false;
+
+  if ((ret = mbedtls_ctr_drbg_seed(&c->drbg_ctx, mbedtls_entropy_func, &c->entropy_ctx, nullptr, 0)) ||
+      (ret = mbedtls_ssl_config_defaults(&c->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                         MBEDTLS_SSL_PRESET_DEFAULT))) {
+    goto fail;
+  }
+  mbedtls_x509_crt_init(&c->ca_cert);
+  if ((ret = mbedtls_x509_crt_parse(&c->ca_cert, (const unsigned char*)ca_, strlen(ca_) + 1))) goto fail;
+  mbedtls_ssl_conf_ca_chain(&c->ssl_conf, &c->ca_cert, nullptr);
+  mbedtls_ssl_conf_authmode(&c->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  mbedtls_ssl_conf_ciphersuites(&c->ssl_conf, CIPHERSUITES);
+  mbedtls_ssl_conf_curves(&c->ssl_conf, CURVES);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&c->ssl_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  mbedtls_ssl_conf_rng(&c->ssl_conf, mbedtls_ctr_drbg_random, &c->drbg_ctx);
+  if ((ret = mbedtls_ssl_setup(&c->ssl_ctx, &c->ssl_conf)) ||
+      (ret = mbedtls_ssl_set_hostname(&c->ssl_ctx, host))) {
+    goto fail;
+  }
+  if (cache_ && cache_->len) {
+    offering = mbedtls_ssl_session_load(&offer, cache_->session, cache_->len) == 0 &&
+               mbedtls_ssl_set_session(&c->ssl_ctx, &offer) == 0;
+    if (!offering) cache_->len = 0;   // saved by a build with another TLS config
+  }
+  mbedtls_ssl_set_bio(&c->ssl_ctx, &c->socket, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+  // select() instead of start_ssl_client()'s 2-tick polling: each flight
+  // is picked up as soon as it lands
+  while ((ret = mbedtls_ssl_handshake(&c->ssl_ctx)) != 0) {
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) goto fail;
+    if (!waitFor(c->socket, ret == MBEDTLS_ERR_SSL_WANT_WRITE, ms - (int32_t)(millis() - start))) {
+      ret = MBEDTLS_ERR_SSL_TIMEOUT;
+      goto fail;
+    }
+  }
+
+  // a resumed session keeps its master secret, a full handshake makes a new one
+  if (mbedtls_ssl_get_session(&c->ssl_ctx, &got) == 0) {
+    resumed = offering && memcmp(got.master, offer.master, sizeof(got.master)) == 0;
+    size_t len = 0;
+    if (cache_) {
+      cache_->len = mbedtls_ssl_session_save(&got, cache_->session, SESSION_MAX, &len) == 0 ? len : 0;
+    }
+  }
+  mbedtls_ssl_session_free(&offer);
+  mbedtls_ssl_session_free(&got);
+  _connected = true;
+  _lastError = 0;
+  return 1;
+
+fail:
+  {
+    char msg[96];
+    mbedtls_strerror(ret, msg, sizeof(msg));
+    log_e("TLS to %s: -0x%04x %s", host, -ret, msg);
+  }
+  if (offering && cache_) cache_->len = 0;   // don't offer it again if it was the cause
+  mbedtls_ssl_session_free(&offer);
+  mbedtls_ssl_session_free(&got);
+  _lastError = ret;
+  stop();
+  return 0;
+}
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+// WiFiClientSecure that verifies the server and resumes TLS sessions.
+//
+// The stock client either skips verification (setInsecure) or checks the
+// CA, and in both cases runs a full handshake on every connect: ECDHE key
+// exchange plus certificate chain verification, two round trips and a few
+// hundred ms of big-number maths on the ESP32. This one does the handshake
+// itself so that it can:
+//
+//  - verify the server against a CA given as PEM (loaded from flash by the
+//    caller), and refuse to connect without one;
+//  - offer the last session (ID and ticket) back to the server, which
+//    resumes it in one round trip with symmetric crypto only. Sessions
+//    live in a Cache the caller places in RTC memory, so they survive
+//    light and deep sleep and resets; a power cycle starts over;
+//  - offer only suites the S3 accelerates: AES-GCM first (AES block),
+//    SHA-256/384 (SHA block), ECDHE on P-256 first (bignum-heavy, helped by
+//    the RSA/MPI block; the S3 has no ECC engine), CBC last. ChaCha20 runs
+//    in software and is not offered.
+//
+// After the handshake it is a WiFiClientSecure like any other.
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+class TlsClient : public WiFiClientSecure {
+public:
+  static const size_t SESSION_MAX = 2048;  // a serialized session, peer cert included
+
+  struct Cache {
+    uint32_t magic;
+    uint32_t host;                  // hash of the host name it is for
+    uint16_t len;                   // 0: none
+    uint8_t  session[SESSION_MAX];
+    uint32_t crc;
+  };
+
+  struct Stats {
+    uint32_t full;       // full handshakes, refused sessions included
+    uint32_t resumed;    // sessions the server took back
+    uint32_t refused;    // sessions offered but not resumed: a full one instead
+    uint32_t failures;   // connects that failed (TCP, handshake or verification)
+    uint32_t fullMs, resumedMs;   // total handshake time, TCP connect included
+  };
+
+  // PEM, kept by pointer. Without one every connect fails.
+  void setCA(const char* pem) { ca_ = pem; }
+  // Adopt `cache`, keeping its session if it checks out.
+  void setCache(Cache* cache);
+  // Drop the cached session, e.g. after the server's cert changed.
+  void forget();
+
+  int connect(const char* host, uint16_t port) override { return connect(host, port, 0); }
+  int connect(const char* host, uint16_t port, int32_t timeoutMs) override;
+  int connect(IPAddress ip, uint16_t port) override { return connect(ip, port, 0); }
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) override;
+
+  const Stats& tlsStats() const { return stats_; }
+
+private:
+  // Platform part: TCP connect and handshake, offering the cached session
+  // if there is one, then the new session saved to the cache. 1 when
+  // connected, with `resumed` set if the server took the session back.
+  int handshake(const char* host, uint16_t port, int32_t timeoutMs, bool& resumed);
+
+  bool cached(uint32_t host) const;
+  void seal();
+
+  const char* ca_    = nullptr;
+  Cache*      cache_ = nullptr;
+  Stats       stats_ = {};
+};
@@ -0,0 +1,172 @@
+#include "BreathRate.h"
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+static inline uint32_t cycleNow() { return esp_cpu_get_ccount(); }
+#else
+#include <chrono>
+static inline uint32_t cycleNow() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// the autocorrelation peak nearest the shortest lag within this share of
+// the best one wins, so a breath is not read as every other breath
+static const float HARMONIC_SHARE = 0.8f;
+
+void BreathRate::begin(const BreathRateConfig& cfg, uint16_t* store) {
+  cfg_   = cfg;
+  store_ = store;
+  if (cfg_.hop < 1) cfg_.hop = 1;
+  if (cfg_.minBpm < 1) cfg_.minBpm = 1;
+  if (cfg_.maxBpm <= cfg_.minBpm) cfg_.maxBpm = cfg_.minBpm + 1;
+  total_     = 0;
+  maxCycles_ = 0;
+  restart();
+}
+
+void BreathRate::setRegion(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  cfg_.x = x;
+  cfg_.y = y;
+  cfg_.w = w;
+  cfg_.h = h;
+  restart();
+}
+
+void BreathRate::restart() {
+  frames_   = 0;
+  clean_    = 0;
+  hopCount_ = 0;
+  est_      = { WARMING, 0, 0, total_ };
+}
+
+bool BreathRate::add(const uint8_t* gray, int w, int h, int stride) {
+  if (!store_) return false;
+  uint32_t start = cycleNow();
+
+  // region clipped to the frame, at least one pixel per cell
+  int x0 = cfg_.x < w ? cfg_.x : w - 1;
+  int y0 = cfg_.y < h ? cfg_.y : h - 1;
+  int rw = cfg_.w < w - x0 ? cfg_.w : w - x0;
+  int rh = cfg_.h < h - y0 ? cfg_.h : h - y0;
+  if (rw < CELLS_X) rw = w - x0 < CELLS_X ? w - x0 : CELLS_X;
+  if (rh < CELLS_Y) rh = h - y0 < CELLS_Y ? h - y0 : CELLS_Y;
+
+  uint16_t* row  = store_ + (size_t)(frames_ % WINDOW) * CELLS;
+  const uint16_t* prev = frames_ ? store_ + (size_t)((frames_ - 1) % WINDOW) * CELLS : nullptr;
+  uint32_t step = 0;
+  for (int cy = 0; cy < CELLS_Y; cy++) {
+    int ya = y0 + cy * rh / CELLS_Y, yb = y0 + (cy + 1) * rh / CELLS_Y;
+    if (yb <= ya) yb = ya + 1;
+    for (int cx = 0; cx < CELLS_X; cx++) {
+      int xa = x0 + cx * rw / CELLS_X, xb = x0 + (cx + 1) * rw / CELLS_X;
+      if (xb <= xa) xb = xa + 1;
+      uint32_t sum = 0;
+      for (int y = ya; y < yb; y++) {
+        const uint8_t* p = gray + (size_t)y * stride;
+        for (int x = xa; x < xb; x++) sum += p[x];
+      }
+      // mean in 1/16 grey levels
+      uint16_t m = (uint16_t)(sum * 16 / ((yb - ya) * (xb - xa)));
+      int c = cy * CELLS_X + cx;
+      if (prev) step += abs((int)m - (int)prev[c]);
+      row[c] = m;
+    }
+  }
+  frames_++;
+  total_++;
+  clean_ = prev && step > (uint32_t)cfg_.moveLevel * 16 * CELLS ? 0 : clean_ + 1;
+  addCycles_ = cycleNow() - start;
+
+  if (++hopCount_ < cfg_.hop) return false;
+  hopCount_ = 0;
+  start = cycleNow();
+  solve();
+  lastCycles_ = cycleNow() - start;
+  if (lastCycles_ > maxCycles_) maxCycles_ = lastCycles_;
+  return true;
+}
+
+void BreathRate::solve() {
+  est_.frame   = total_;
+  est_.bpmX10  = 0;
+  est_.quality = 0;
+  if (frames_ < (uint32_t)WINDOW) {
+    est_.state = WARMING;
+    return;
+  }
+  if (clean_ < (uint32_t)WINDOW) {
+    est_.state = MOVING;
+    return;
+  }
+  est_.state = UNCERTAIN;
+
+  const float period = (float)cfg_.periodMs;
+  int minLag = (int)(60000.0f / (cfg_.maxBpm * period));
+  int maxLag = (int)(60000.0f / (cfg_.minBpm * period) + 0.999f);
+  if (minLag < 2) minLag = 2;
+  if (maxLag > MAX_LAG) maxLag = MAX_LAG;
+  if (maxLag <= minLag) return;
+
+  // summed autocorrelation of the detrended cell series, lags 0..maxLag+1
+  memset(acc_, 0, sizeof(acc_));
+  const int   n    = WINDOW;
+  const int   head = frames_ % WINDOW;  // oldest row
+  const float mid  = (n - 1) * 0.5f;
+  const float cc   = (float)n * ((float)n * n - 1) / 12.0f;  // sum of (t - mid)^2
+  for (int c = 0; c < CELLS; c++) {
+    float sum = 0, sumC = 0;
+    for (int t = 0; t < n; t++) {
+      float v = store_[(size_t)((head + t) % WINDOW) * CELLS + c];
+      series_[t] = v;
+      sum  += v;
+      sumC += (t - mid) * v;
+    }
+    float mean = sum / n, slope = sumC / cc;
+    for (int t = 0; t < n; t++) series_[t] -= mean + slope * (t - mid);
+    for (int l = 0; l <= maxLag + 1; l++) {
+      float r = 0;
+      for (int t = 0; t + l < n; t++) r += series_[t] * series_[t + l];
+      acc_[l] += r;
+    }
+  }
+  if (acc_[0] <= 0) return;
+
+  // unbiased, normalised: 1 at lag 0
+  float norm[MAX_LAG + 2];
+  for (int l = 0; l <= maxLag + 1; l++) norm[l] = acc_[l] / acc_[0] * n / (n - l);
+
+  float best = 0;
+  for (int l = minLag; l <= maxLag; l++) {
+    if (norm[l] > norm[l - 1] && norm[l] >= norm[l + 1] && norm[l] > best) best = norm[l];
+  }
+  if (best <= 0) return;
+  int lag = 0;
+  for (int l = minLag; l <= maxLag && !lag; l++) {
+    if (norm[l] > norm[l - 1] && norm[l] >= norm[l + 1] && norm[l] >= best * HARMONIC_SHARE) lag = l;
+  }
+
+  float q = norm[lag] * 256.0f;
+  est_.quality = q > 255 ? 255 : (uint8_t)q;
+  if (est_.quality < cfg_.minQuality) return;
+
+  // parabola through the peak and its neighbours
+  float a = norm[lag - 1], b = norm[lag], c = norm[lag + 1];
+  float den = a - 2 * b + c;
+  float exact = lag + (den < 0 ? 0.5f * (a - c) / den : 0.0f);
+  est_.bpmX10 = (uint16_t)(600000.0f / (exact * period) + 0.5f);
+  est_.state  = BREATHING;
+}
+
+const char* BreathRate::stateName(State s) {
+  switch (s) {
+    case WARMING:   return "warming";
+    case MOVING:    return "moving";
+    case UNCERTAIN: return "uncertain";
+    case BREATHING: return "breathing";
+  }
+  return "?";
+}
@@ -0,0 +1,86 @@
+#pragma once
+// Breathing rate from video micro-motion.
+//
+// The crib region of each small grey frame (FrameDiff's 80x60) is split
+// into an 8x8 grid of cells and each cell's mean brightness is kept over a
+// sliding window of WINDOW frames. A chest or blanket rising and falling
+// moves edges across the cells, so their means swing with the breathing
+// period. Every `hop` frames each cell's series is detrended (linear fit,
+// which absorbs lighting drift) and autocorrelated, the autocorrelations
+// are summed across cells (cells with more movement weigh more, and their
+// phases do not matter), and the strongest peak between maxBpm and minBpm
+// gives the period, refined by a parabolic fit. Frames with gross motion
+// (the baby turning, a hand in the crib) taint the window: no rate is
+// given until WINDOW clean frames have passed.
+//
+// Memory is fixed: the cell history lives in a caller-supplied buffer of
+// STORE_BYTES (PSRAM on the device), and the cost of an estimate is
+// bounded by CELLS x WINDOW x (max lag) multiply-adds.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+struct BreathRateConfig {
+  uint32_t periodMs   = 250;  // frame spacing
+  // crib region, in pixels of the frames passed to add()
+  uint16_t x = 20, y = 15, w = 40, h = 30;
+  uint16_t minBpm     = 10;
+  uint16_t maxBpm     = 80;
+  int      hop        = 4;    // frames between estimates
+  uint8_t  minQuality = 77;   // Q8 normalised autocorrelation peak, ~0.3
+  uint8_t  moveLevel  = 2;    // mean cell change between frames (grey levels) that is gross motion
+};
+
+class BreathRate {
+public:
+  static const int    CELLS_X = 8;
+  static const int    CELLS_Y = 8;
+  static const int    CELLS   = CELLS_X * CELLS_Y;
+  static const int    WINDOW  = 128;  // 32 s at 4 fps
+  static const int    MAX_LAG = WINDOW / 2;
+  static const size_t STORE_BYTES = (size_t)WINDOW * CELLS * sizeof(uint16_t);
+
+  enum State : uint8_t { WARMING, MOVING, UNCERTAIN, BREATHING };
+
+  struct Estimate {
+    State    state;
+    uint16_t bpmX10;   // breaths per minute x 10, 0 unless BREATHING
+    uint8_t  quality;  // Q8 peak height of the summed autocorrelation
+    uint32_t frame;    // frames added when it was made
+  };
+
+  // `store` holds STORE_BYTES; the estimator is inert without it.
+  void begin(const BreathRateConfig& cfg, uint16_t* store);
+
+  // Move the crib region; the window starts over.
+  void setRegion(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+  // One grey frame. True when it produced a new estimate.
+  bool add(const uint8_t* gray, int w, int h, int stride);
+
+  const Estimate&         estimate()    const { return est_; }
+  const BreathRateConfig& config()      const { return cfg_; }
+  uint32_t                lastCycles()  const { return lastCycles_; }  // per estimate
+  uint32_t                maxCycles()   const { return maxCycles_; }
+  uint32_t                addCycles()   const { return addCycles_; }   // per frame
+
+  static const char* stateName(State s);
+
+private:
+  void restart();
+  void solve();
+
+  BreathRateConfig cfg_;
+  uint16_t* store_   = nullptr;  // WINDOW rows of CELLS cell means, oldest overwritten
+  uint32_t  frames_  = 0;        // frames since the window restarted
+  uint32_t  total_   = 0;        // frames since begin()
+  uint32_t  clean_   = 0;        // frames since the last gross motion
+  int       hopCount_ = 0;
+  Estimate  est_     = { WARMING, 0, 0, 0 };
+  uint32_t  lastCycles_ = 0;
+  uint32_t  maxCycles_  = 0;
+  uint32_t  addCycles_  = 0;
+  float     series_[WINDOW];
+  float     acc_[MAX_LAG + 2];
+};
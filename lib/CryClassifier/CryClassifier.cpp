@@ -0,0 +1,137 @@
+#include "CryClassifier.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+static inline uint32_t cycleNow() { return esp_cpu_get_ccount(); }
+#else
+#include <chrono>
+static inline uint32_t cycleNow() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static const int L1_OUT = CryClassifier::T - CryClassifier::K + 1;   // 30
+static const int P1_OUT = L1_OUT / 2;                               // 15
+static const int L2_OUT = P1_OUT - CryClassifier::K + 1;            // 13
+
+static const size_t W1_LEN = CryClassifier::C1 * CryClassifier::N_IN * CryClassifier::K;
+static const size_t W2_LEN = CryClassifier::C2 * CryClassifier::C1 * CryClassifier::K;
+static const size_t WF_LEN = CryClassifier::N_LABELS * CryClassifier::C2;
+static const size_t BIAS_LEN = CryClassifier::C1 + CryClassifier::C2 + CryClassifier::N_LABELS;
+static const size_t HEADER_LEN = 4 + 1 + 7;
+
+enum { E_IN, E_W1, E_O1, E_W2, E_O2, E_WF, E_OF };
+
+// x * 2^-shift with round-to-nearest; negative shift scales up
+static inline int32_t shiftRound(int64_t x, int shift) {
+  if (shift <= 0) return (int32_t)(x << -shift);
+  return (int32_t)((x + ((int64_t)1 << (shift - 1))) >> shift);
+}
+
+static inline int8_t sat8(int32_t x) {
+  return (int8_t)(x > 127 ? 127 : x < -128 ? -128 : x);
+}
+
+size_t CryClassifier::arenaSize() {
+  return BIAS_LEN * sizeof(int32_t) + W1_LEN + W2_LEN + WF_LEN
+       + T * N_IN + P1_OUT * C1 + L2_OUT * C2;
+}
+
+bool CryClassifier::load(const uint8_t* blob, size_t len, uint8_t* arena) {
+  size_t need = HEADER_LEN + W1_LEN + W2_LEN + WF_LEN + BIAS_LEN * sizeof(int32_t);
+  if (!blob || !arena || len != need || memcmp(blob, "CRYM", 4) != 0 || blob[4] != 1) return false;
+  memcpy(exp_, blob + 5, sizeof(exp_));
+
+  // biases first so they stay 4-byte aligned in the arena
+  int32_t* bias = (int32_t*)arena;
+  int8_t*  w    = (int8_t*)(bias + BIAS_LEN);
+  const uint8_t* p = blob + HEADER_LEN;
+  memcpy(w, p, W1_LEN);                                   p += W1_LEN;
+  memcpy(bias, p, C1 * sizeof(int32_t));                  p += C1 * sizeof(int32_t);
+  memcpy(w + W1_LEN, p, W2_LEN);                          p += W2_LEN;
+  memcpy(bias + C1, p, C2 * sizeof(int32_t));             p += C2 * sizeof(int32_t);
+  memcpy(w + W1_LEN + W2_LEN, p, WF_LEN);                 p += WF_LEN;
+  memcpy(bias + C1 + C2, p, N_LABELS * sizeof(int32_t));
+
+  b1_ = bias;          b2_ = bias + C1;              bf_ = bias + C1 + C2;
+  w1_ = w;             w2_ = w + W1_LEN;             wf_ = w + W1_LEN + W2_LEN;
+  window_ = w + W1_LEN + W2_LEN + WF_LEN;
+  act1_   = window_ + T * N_IN;
+  act2_   = act1_ + P1_OUT * C1;
+  reset();
+  return true;
+}
+
+void CryClassifier::push(const int32_t* mfcc) {
+  if (!loaded()) return;
+  // Q8 log2 units -> int8 at the model's input exponent
+  int8_t* dst = window_ + head_ * N_IN;
+  for (int i = 0; i < N_IN; i++) dst[i] = sat8(shiftRound(mfcc[i], 8 + exp_[E_IN]));
+  head_ = (head_ + 1) % T;
+  if (filled_ < T) filled_++;
+}
+
+void CryClassifier::infer(uint16_t prob[N_LABELS]) {
+  uint32_t t0 = cycleNow();
+
+  // Conv1D #1 + ReLU + MaxPool(2), reading the window ring oldest-first
+  int shift1 = exp_[E_O1] - exp_[E_IN] - exp_[E_W1];
+  for (int t = 0; t < P1_OUT; t++) {
+    for (int c = 0; c < C1; c++) {
+      int8_t best = 0;  // ReLU floor
+      for (int s = 0; s < 2; s++) {
+        int32_t acc = b1_[c];
+        const int8_t* wc = w1_ + c * N_IN * K;
+        for (int k = 0; k < K; k++) {
+          const int8_t* x = window_ + ((head_ + 2 * t + s + k) % T) * N_IN;
+          for (int i = 0; i < N_IN; i++) acc += x[i] * wc[i * K + k];
+        }
+        int8_t y = sat8(shiftRound(acc, shift1));
+        if (y > best) best = y;
+      }
+      act1_[t * C1 + c] = best;
+    }
+  }
+
+  // Conv1D #2 + ReLU
+  int shift2 = exp_[E_O2] - exp_[E_O1] - exp_[E_W2];
+  for (int t = 0; t < L2_OUT; t++) {
+    for (int c = 0; c < C2; c++) {
+      int32_t acc = b2_[c];
+      const int8_t* wc = w2_ + c * C1 * K;
+      for (int k = 0; k < K; k++) {
+        const int8_t* x = act1_ + (t + k) * C1;
+        for (int i = 0; i < C1; i++) acc += x[i] * wc[i * K + k];
+      }
+      int8_t y = sat8(shiftRound(acc, shift2));
+      act2_[t * C2 + c] = y > 0 ? y : 0;
+    }
+  }
+
+  // Global average pool (kept at int32, exponent o2) + Dense
+  int32_t pooled[C2];
+  for (int c = 0; c < C2; c++) {
+    int32_t sum = 0;
+    for (int t = 0; t < L2_OUT; t++) sum += act2_[t * C2 + c];
+    pooled[c] = (sum + L2_OUT / 2) / L2_OUT;
+  }
+  int shiftF = exp_[E_OF] - exp_[E_O2] - exp_[E_WF];
+  float logit[N_LABELS], maxLogit = -1e30f;
+  for (int j = 0; j < N_LABELS; j++) {
+    int32_t acc = bf_[j];
+    for (int c = 0; c < C2; c++) acc += pooled[c] * wf_[j * C2 + c];
+    logit[j] = ldexpf((float)sat8(shiftRound(acc, shiftF)), exp_[E_OF]);
+    if (logit[j] > maxLogit) maxLogit = logit[j];
+  }
+
+  // three-way softmax; not worth a fixed-point exp
+  float sum = 0;
+  for (int j = 0; j < N_LABELS; j++) { logit[j] = expf(logit[j] - maxLogit); sum += logit[j]; }
+  for (int j = 0; j < N_LABELS; j++) prob[j] = (uint16_t)lrintf(256.0f * logit[j] / sum);
+
+  lastCycles_ = cycleNow() - t0;
+  if (lastCycles_ > maxCycles_) maxCycles_ = lastCycles_;
+}
@@ -0,0 +1,65 @@
+#pragma once
+// Small int8 1-D CNN over a sliding window of MFCC frames:
+//
+//   MFCC[T=32][13] -> Conv1D(16, k3) ReLU -> MaxPool(2)
+//                  -> Conv1D(16, k3) ReLU -> GlobalAvgPool -> Dense(3)
+//
+// Quantisation follows esp-dl's convention (int8 values, power-of-two
+// exponents per tensor, int32 accumulators), so a model quantised with the
+// esp-dl toolchain exports straight into the blob below. Weights are not
+// compiled in: load() parses a blob (LittleFS /cry_model.bin on the device)
+// into a caller-supplied arena, so the PSRAM footprint is fixed at boot.
+//
+// Blob layout, little endian:
+//   "CRYM" u8 version(1) i8 exp[7] = {in, w1, o1, w2, o2, wf, of}
+//   i8 w1[16][13][3]  i32 b1[16]
+//   i8 w2[16][16][3]  i32 b2[16]
+//   i8 wf[3][16]      i32 bf[3]
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+class CryClassifier {
+public:
+  enum Label { CRY = 0, NO_CRY = 1, OTHER = 2, N_LABELS = 3 };
+
+  static const int N_IN   = 13;   // MFCC coefficients per frame
+  static const int T      = 32;   // frames per inference (~1 s at 32 ms)
+  static const int K      = 3;
+  static const int C1     = 16;
+  static const int C2     = 16;
+
+  // Bytes the arena passed to load() must provide.
+  static size_t arenaSize();
+
+  // Parse `blob` into `arena`. Returns false (and stays unloaded) if the
+  // blob is malformed.
+  bool load(const uint8_t* blob, size_t len, uint8_t* arena);
+  bool loaded() const { return w1_ != nullptr; }
+
+  void reset() { head_ = 0; filled_ = 0; }
+  // Append one frame of Q8 MFCCs to the window.
+  void push(const int32_t* mfcc);
+  bool ready() const { return filled_ >= T; }
+
+  // Run the network over the current window; probabilities in Q8 (0..256).
+  void infer(uint16_t prob[N_LABELS]);
+
+  uint32_t lastCycles() const { return lastCycles_; }
+  uint32_t maxCycles()  const { return maxCycles_; }
+
+private:
+  int8_t  exp_[7] = {};
+  const int8_t*  w1_ = nullptr; const int32_t* b1_ = nullptr;
+  const int8_t*  w2_ = nullptr; const int32_t* b2_ = nullptr;
+  const int8_t*  wf_ = nullptr; const int32_t* bf_ = nullptr;
+  int8_t* window_ = nullptr;  // [T][N_IN] ring
+  int8_t* act1_   = nullptr;  // [(T-2)/2][C1] after pooling
+  int8_t* act2_   = nullptr;  // [(T-2)/2-2][C2]
+
+  int      head_   = 0;
+  int      filled_ = 0;
+  uint32_t lastCycles_ = 0;
+  uint32_t maxCycles_  = 0;
+};
@@ -0,0 +1,167 @@
+#pragma once
+// Fixed-point MFCC front end for the cry classifier.
+//
+// Input is the FFT power spectrum CryDetector already computes for every
+// frame, so the features cost only the filterbank, a log and a small DCT.
+// The mel filterbank, log2 mantissa and DCT tables are generated at compile
+// time (constexpr), so nothing is built at boot and they live in flash.
+//
+// Output coefficients are int32 in Q8 log2 units. No Arduino dependency:
+// builds on the host so features can be checked against a float reference.
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mfcc_math {
+
+constexpr double PI  = 3.14159265358979323846;
+constexpr double LN2 = 0.69314718055994530942;
+
+constexpr double cos(double x) {
+  while (x >  PI) x -= 2 * PI;
+  while (x < -PI) x += 2 * PI;
+  double term = 1, sum = 1;
+  for (int i = 1; i < 24; i++) {
+    term *= -x * x / ((2 * i - 1) * (2 * i));
+    sum  += term;
+  }
+  return sum;
+}
+
+constexpr double ln(double x) {
+  int k = 0;
+  while (x > 2) { x /= 2; k++; }
+  while (x < 1) { x *= 2; k--; }
+  double y = (x - 1) / (x + 1), y2 = y * y, t = y, s = 0;
+  for (int i = 1; i < 60; i += 2) { s += t / i; t *= y2; }
+  return 2 * s + k * LN2;
+}
+
+constexpr double exp(double x) {
+  int n = (int)(x / LN2);
+  double r = x - n * LN2, term = 1, sum = 1;
+  for (int i = 1; i < 30; i++) { term *= r / i; sum += term; }
+  for (; n > 0; n--) sum *= 2;
+  for (; n < 0; n++) sum /= 2;
+  return sum;
+}
+
+constexpr double sqrt(double x) {
+  double r = x > 1 ? x : 1;
+  for (int i = 0; i < 60; i++) r = 0.5 * (r + x / r);
+  return r;
+}
+
+constexpr double hzToMel(double hz)  { return 2595.0 * ln(1.0 + hz / 700.0) / ln(10.0); }
+constexpr double melToHz(double mel) { return 700.0 * (exp(mel / 2595.0 * ln(10.0)) - 1.0); }
+
+constexpr int32_t roundTo(double x) { return (int32_t)(x < 0 ? x - 0.5 : x + 0.5); }
+
+}  // namespace mfcc_math
+
+namespace mfcc_tables {
+
+// Each FFT bin sits on the rising edge of at most one triangle and the
+// falling edge of its left neighbour: store the rising filter and weight.
+template <int BINS>
+struct BinMap {
+  int8_t   filter[BINS];   // -1: outside the filterbank
+  uint16_t weight[BINS];   // Q15 share that goes to `filter`
+};
+
+template <int FFT_SIZE, int SAMPLE_RATE, int N_MEL, int F_LO, int F_HI>
+constexpr BinMap<FFT_SIZE / 2> makeBinMap() {
+  BinMap<FFT_SIZE / 2> m{};
+  double edge[N_MEL + 2] = {};
+  double lo = mfcc_math::hzToMel(F_LO), hi = mfcc_math::hzToMel(F_HI);
+  for (int i = 0; i < N_MEL + 2; i++) {
+    edge[i] = mfcc_math::melToHz(lo + (hi - lo) * i / (N_MEL + 1)) * FFT_SIZE / SAMPLE_RATE;
+  }
+  for (int k = 0; k < FFT_SIZE / 2; k++) {
+    m.filter[k] = -1;
+    m.weight[k] = 0;
+    for (int i = 0; i < N_MEL + 1; i++) {
+      if (k >= edge[i] && k < edge[i + 1]) {
+        m.filter[k] = (int8_t)i;  // == N_MEL: only the falling part counts
+        m.weight[k] = (uint16_t)mfcc_math::roundTo(32768.0 * (k - edge[i]) / (edge[i + 1] - edge[i]));
+      }
+    }
+  }
+  return m;
+}
+
+// log2(1 + i/256) in Q8, for the mantissa of the fixed-point log
+struct Log2Table { uint8_t v[256]; };
+constexpr Log2Table makeLog2Table() {
+  Log2Table t{};
+  for (int i = 0; i < 256; i++) {
+    int32_t r = mfcc_math::roundTo(256.0 * mfcc_math::ln(1.0 + i / 256.0) / mfcc_math::LN2);
+    t.v[i] = (uint8_t)(r > 255 ? 255 : r);
+  }
+  return t;
+}
+
+// orthonormal DCT-II, Q15
+template <int N_COEF, int N_MEL>
+struct DctTable { int16_t v[N_COEF][N_MEL]; };
+
+template <int N_COEF, int N_MEL>
+constexpr DctTable<N_COEF, N_MEL> makeDctTable() {
+  DctTable<N_COEF, N_MEL> t{};
+  for (int n = 0; n < N_COEF; n++) {
+    double scale = mfcc_math::sqrt((n == 0 ? 1.0 : 2.0) / N_MEL);
+    for (int m = 0; m < N_MEL; m++) {
+      t.v[n][m] = (int16_t)mfcc_math::roundTo(32767.0 * scale * mfcc_math::cos(mfcc_math::PI * n * (m + 0.5) / N_MEL));
+    }
+  }
+  return t;
+}
+
+}  // namespace mfcc_tables
+
+template <int FFT_SIZE, int SAMPLE_RATE, int N_MEL = 20, int N_COEF = 13,
+          int F_LO = 100, int F_HI = SAMPLE_RATE / 2>
+class Mfcc {
+public:
+  static const int BINS   = FFT_SIZE / 2;
+  static const int N_MELS = N_MEL;
+  static const int N_MFCC = N_COEF;
+
+  static constexpr mfcc_tables::BinMap<BINS> binMap =
+    mfcc_tables::makeBinMap<FFT_SIZE, SAMPLE_RATE, N_MEL, F_LO, F_HI>();
+  static constexpr mfcc_tables::Log2Table log2Q8 = mfcc_tables::makeLog2Table();
+  static constexpr mfcc_tables::DctTable<N_COEF, N_MEL> dct =
+    mfcc_tables::makeDctTable<N_COEF, N_MEL>();
+
+  // log2(x + 1) in Q8
+  static int32_t log2Fixed(uint64_t x) {
+    x += 1;
+    int e = 63 - __builtin_clzll(x);
+    uint32_t mant = e >= 8 ? (uint32_t)(x >> (e - 8)) & 0xFF : (uint32_t)(x << (8 - e)) & 0xFF;
+    return (e << 8) + log2Q8.v[mant];
+  }
+
+  // `power` holds BINS FFT power values; writes N_MFCC coefficients and,
+  // optionally, the N_MEL log mel energies (both Q8 log2).
+  static void compute(const uint32_t* power, int32_t* out, int32_t* logMel = nullptr) {
+    // Q15 sums, into the log as they are: truncating each bin's share, or
+    // the sum, loses whole counts, and quiet bands are only a few counts
+    uint64_t mel[N_MEL + 1] = {};
+    for (int k = 0; k < BINS; k++) {
+      int f = binMap.filter[k];
+      if (f < 0) continue;
+      uint64_t p = power[k], w = binMap.weight[k];
+      mel[f] += p * w;
+      if (f > 0) mel[f - 1] += p * (32768 - w);
+    }
+    int32_t lm[N_MEL];
+    for (int m = 0; m < N_MEL; m++) lm[m] = log2Fixed(mel[m] + 32767) - (15 << 8);   // log2(mel + 1)
+    for (int n = 0; n < N_COEF; n++) {
+      int64_t acc = 0;
+      for (int m = 0; m < N_MEL; m++) acc += (int64_t)dct.v[n][m] * lm[m];
+      out[n] = (int32_t)(acc >> 15);
+    }
+    if (logMel) {
+      for (int m = 0; m < N_MEL; m++) logMel[m] = lm[m];
+    }
+  }
+};
@@ -0,0 +1,170 @@
+#include "CryDetector.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+#include "esp_dsp.h"
+#define CRY_USE_ESP_DSP 1
+static inline uint32_t cycleNow() { return esp_cpu_get_ccount(); }
+#else
+#include <chrono>
+#define CRY_USE_ESP_DSP 0
+static inline uint32_t cycleNow() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+#if !CRY_USE_ESP_DSP
+static int16_t twiddle[CryDetector::FRAME];  // cos/sin pairs, Q15
+#endif
+
+static int hzToBin(uint32_t hz, uint32_t rate) {
+  return (int)((hz * CryDetector::FRAME + rate / 2) / rate);
+}
+
+void CryDetector::begin(const CryDetectorConfig& cfg) {
+  cfg_ = cfg;
+  frameMs_    = FRAME * 1000 / cfg_.sampleRate;
+  persistMax_ = (cfg_.persistMs + frameMs_ - 1) / frameMs_;
+  binLo_      = hzToBin(250, cfg_.sampleRate);
+  binF0Hi_    = hzToBin(700, cfg_.sampleRate);
+  binHi_      = hzToBin(3500, cfg_.sampleRate);
+  if (binHi_ > FRAME / 2 - 1) binHi_ = FRAME / 2 - 1;
+
+  for (int i = 0; i < FRAME; i++) {
+    window_[i] = (int16_t)(32767.0f * 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / FRAME)));
+  }
+#if CRY_USE_ESP_DSP
+  dsps_fft2r_init_sc16(NULL, FRAME);
+#else
+  for (int i = 0; i < FRAME / 2; i++) {
+    twiddle[2 * i]     = (int16_t)lrintf(32767.0f * cosf(2.0f * (float)M_PI * i / FRAME));
+    twiddle[2 * i + 1] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * i / FRAME));
+  }
+#endif
+  reset();
+}
+
+void CryDetector::reset() {
+  persist_     = 0;
+  lastCryLike_ = false;
+  lastBand_    = 0;
+  lastF0Hz_    = 0;
+}
+
+// In-place radix-2 FFT on interleaved Q15 data, halving every stage so the
+// result is DFT/N and can never overflow. Same scaling as dsps_fft2r_sc16.
+void CryDetector::fft() {
+#if CRY_USE_ESP_DSP
+  dsps_fft2r_sc16(data_, FRAME);
+  dsps_bit_rev_sc16_ansi(data_, FRAME);
+#else
+  for (int i = 1, j = 0; i < FRAME; i++) {
+    int bit = FRAME >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      int16_t t;
+      t = data_[2 * i];     data_[2 * i]     = data_[2 * j];     data_[2 * j]     = t;
+      t = data_[2 * i + 1]; data_[2 * i + 1] = data_[2 * j + 1]; data_[2 * j + 1] = t;
+    }
+  }
+  for (int len = 2; len <= FRAME; len <<= 1) {
+    int half = len >> 1, step = FRAME / len;
+    for (int i = 0; i < FRAME; i += len) {
+      for (int k = 0; k < half; k++) {
+        int32_t wr = twiddle[2 * k * step], wi = -twiddle[2 * k * step + 1];
+        int16_t* a = &data_[2 * (i + k)];
+        int16_t* b = &data_[2 * (i + k + half)];
+        int32_t tr = (b[0] * wr - b[1] * wi + 0x4000) >> 15;
+        int32_t ti = (b[0] * wi + b[1] * wr + 0x4000) >> 15;
+        int32_t ar = a[0], ai = a[1];
+        a[0] = (int16_t)((ar + tr) >> 1);
+        a[1] = (int16_t)((ai + ti) >> 1);
+        b[0] = (int16_t)((ar - tr) >> 1);
+        b[1] = (int16_t)((ai - ti) >> 1);
+      }
+    }
+  }
+#endif
+}
+
+// Mean-removed, scaled by 2^shift into Q15 and Hann windowed.
+void CryDetector::load(const int16_t* x, int shift) {
+  int32_t mean = 0;
+  for (int i = 0; i < FRAME; i++) mean += x[i];
+  mean /= FRAME;
+  for (int i = 0; i < FRAME; i++) {
+    int32_t v = (x[i] - mean) << shift;
+    if (v > 32767) v = 32767; else if (v < -32768) v = -32768;
+    data_[2 * i]     = (int16_t)((v * window_[i]) >> 15);
+    data_[2 * i + 1] = 0;
+  }
+}
+
+void CryDetector::spectrum(uint32_t* p) {
+  p[0] = 0;  // DC was removed in load()
+  for (int k = 1; k < FRAME / 2; k++) {
+    int32_t re = data_[2 * k], im = data_[2 * k + 1];
+    p[k] = (uint32_t)(re * re + im * im);
+  }
+}
+
+bool CryDetector::process(const int16_t* frame, const int16_t* ref) {
+  uint32_t t0 = cycleNow();
+
+  uint32_t echoCycles = 0;
+  if (ref) {
+    load(ref, 0);  // already PCM16
+    fft();
+    spectrum(refPower_);
+    echoCycles = cycleNow() - t0;
+  }
+  // 12-bit ADC -> Q15 (x8)
+  load(frame, 3);
+  fft();
+  spectrum(power_);
+  if (ref || echo_.active()) {
+    uint32_t te = cycleNow();
+    echo_.suppress(power_, ref ? refPower_ : nullptr);
+    echoCycles += cycleNow() - te;
+  }
+  lastEchoCycles_ = echoCycles;
+  if (echoCycles > maxEchoCycles_) maxEchoCycles_ = echoCycles;
+
+  uint64_t total = 0, band = 0;
+  int      peak  = binLo_;
+  for (int k = 1; k < FRAME / 2; k++) {
+    total += power_[k];
+    if (k >= binLo_ && k <= binHi_) band += power_[k];
+    if (k >= binLo_ && k <= binF0Hi_ && power_[k] > power_[peak]) peak = k;
+  }
+
+  // energy on the fundamental and its 2nd/3rd harmonics, +-1 bin each
+  uint64_t harmonic = 0;
+  for (int h = 1; h <= 3; h++) {
+    int c = peak * h;
+    for (int k = c - 1; k <= c + 1; k++) {
+      if (k > 0 && k < FRAME / 2) harmonic += power_[k];
+    }
+  }
+
+  lastBand_    = band > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)band;
+  lastF0Hz_    = (uint16_t)(peak * cfg_.sampleRate / FRAME);
+  lastCryLike_ = band >= cfg_.minBandEnergy
+              && band * 100 >= total * cfg_.bandPct
+              && harmonic * 100 >= band * cfg_.harmonicPct;
+
+  if (lastCryLike_) {
+    if (persist_ < persistMax_) persist_++;
+  } else if (persist_ > 0) {
+    persist_--;
+  }
+
+  lastCycles_ = cycleNow() - t0;
+  if (lastCycles_ > maxCycles_) maxCycles_ = lastCycles_;
+  frames_++;
+  return persist_ >= persistMax_;
+}
@@ -0,0 +1,89 @@
+#pragma once
+// Spectral infant-cry detector.
+//
+// Each 256-sample frame is DC-removed, Hann windowed and run through a
+// fixed-point complex FFT (esp-dsp's PIE-accelerated sc16 kernel on the
+// ESP32-S3, a scalar radix-2 fallback elsewhere). A frame is "cry-like"
+// when enough of its energy sits in the cry band and that energy is
+// concentrated on a fundamental in the 250-700 Hz range plus its 2nd/3rd
+// harmonics. A leaky persistence counter turns cry-like frames into a
+// detection, so door slams and single thumps don't fire.
+//
+// While the speaker plays, a reference frame of the output lets an
+// EchoSuppressor strip the lullaby's echo from the spectrum first, so
+// detection keeps running during playback instead of being switched off.
+//
+// No Arduino dependency: builds and runs on the host.
+#include <stdint.h>
+#include <stddef.h>
+#include "EchoSuppressor.h"
+
+struct CryDetectorConfig {
+  uint32_t sampleRate     = 8000;
+  uint32_t minBandEnergy  = 2000;  // ~a 20-count tone at the ADC
+  uint8_t  bandPct        = 70;    // % of frame energy inside 250-3500 Hz
+  uint8_t  harmonicPct    = 25;    // % of band energy on F0 and harmonics
+  uint32_t persistMs      = 1500;  // net cry-like time before detecting
+};
+
+class CryDetector {
+public:
+  static const int FRAME = 256;
+
+  void begin(const CryDetectorConfig& cfg = CryDetectorConfig());
+  void reset();
+
+  // Feed one FRAME of raw 12-bit ADC samples, plus the matching FRAME of
+  // speaker output (PCM16 at the mic rate) while something is playing.
+  // Returns true once cry-like frames have outweighed the others for
+  // cfg.persistMs.
+  bool process(const int16_t* frame, const int16_t* ref = nullptr);
+
+  bool     lastCryLike()   const { return lastCryLike_; }
+  uint32_t lastBandEnergy()const { return lastBand_; }
+  uint16_t lastF0Hz()      const { return lastF0Hz_; }
+  uint32_t persistMs()     const { return persist_ * frameMs_; }
+  // Power spectrum of the last frame, FRAME/2 bins (feeds the MFCC stage).
+  const uint32_t* power()  const { return power_; }
+
+  // Cost of process(), in CPU cycles on the target (ns on the host).
+  uint32_t lastCycles()    const { return lastCycles_; }
+  uint32_t maxCycles()     const { return maxCycles_; }
+  uint32_t framesRun()     const { return frames_; }
+  // Share of those spent on echo suppression (reference FFT + subtraction).
+  uint32_t lastEchoCycles()const { return lastEchoCycles_; }
+  uint32_t maxEchoCycles() const { return maxEchoCycles_; }
+  uint8_t  lastEchoPct()   const { return echo_.active() ? echo_.lastRemovedPct() : 0; }
+
+  void setMinBandEnergy(uint32_t e) { cfg_.minBandEnergy = e; }
+
+  // Forget the learned speaker->mic coupling.
+  void resetEcho() { echo_.reset(); }
+
+private:
+  void load(const int16_t* x, int shift);
+  void fft();
+  void spectrum(uint32_t* p);
+
+  CryDetectorConfig cfg_;
+  uint32_t frameMs_    = 32;
+  uint32_t persistMax_ = 0;
+  uint32_t persist_    = 0;
+  int      binLo_ = 0, binF0Hi_ = 0, binHi_ = 0;
+
+  bool     lastCryLike_ = false;
+  uint32_t lastBand_    = 0;
+  uint16_t lastF0Hz_    = 0;
+  uint32_t lastCycles_  = 0;
+  uint32_t maxCycles_   = 0;
+  uint32_t frames_      = 0;
+  uint32_t lastEchoCycles_ = 0;
+  uint32_t maxEchoCycles_  = 0;
+
+  int16_t  window_[FRAME];
+  alignas(16) int16_t data_[FRAME * 2];  // interleaved re/im
+  uint32_t power_[FRAME / 2];
+  uint32_t refPower_[FRAME / 2];
+  EchoSuppressor echo_;
+  static_assert(EchoSuppressor::BINS == FRAME / 2, "echo bins must match the FFT");
+};
@@ -0,0 +1,98 @@
+#include "EchoSuppressor.h"
+#include <math.h>
+#include <string.h>
+
+static const uint32_t GAIN_MAX = 1u << 28;
+
+void EchoSuppressor::reset() {
+  memset(hist_, 0, sizeof(hist_));
+  memset(held_, 0, sizeof(held_));
+  memset(gain_, 0, sizeof(gain_));
+  memset(lagScore_, 0, sizeof(lagScore_));
+  head_       = 0;
+  lag_        = 0;
+  refEnergy_  = 0;
+  removedPct_ = 0;
+  warmup_     = WARMUP_FRAMES;
+}
+
+// The speaker -> mic path adds the I2S and ADC buffering on top of the
+// acoustic delay, tens of ms. Score each lag by how well that reference
+// frame lines up with the mic spectrum and follow the best, smoothed.
+void EchoSuppressor::trackLag(const uint32_t* mic) {
+  int best = 0;
+  for (int l = 0; l < LAGS; l++) {
+    const uint32_t* r = frame(l);
+    float dot = 0, norm = 0;
+    for (int k = 1; k < BINS; k++) {
+      float x = (float)r[k];
+      dot  += x * (float)mic[k];
+      norm += x * x;
+    }
+    float s = norm > 0 ? dot / sqrtf(norm) : 0;
+    lagScore_[l] += (s - lagScore_[l]) * (1.0f / 16);
+    if (lagScore_[l] > lagScore_[best]) best = l;
+  }
+  lag_ = best;
+}
+
+void EchoSuppressor::suppress(uint32_t* mic, const uint32_t* ref) {
+  head_ = (head_ + 1) % HIST;
+  if (ref) memcpy(hist_[head_], ref, sizeof(hist_[0]));
+  else     memset(hist_[head_], 0, sizeof(hist_[0]));
+  if (ref) trackLag(mic);
+
+  // until the coupling has been seen for a while, learn fast around the
+  // median and gate the mic outright rather than trust a half-learnt G
+  bool    warming = warmup_ > 0 && ref;
+  uint8_t pct     = warming ? 50 : PCT;
+  int     rate    = warming ? WARMUP_RATE : RATE;
+
+  // the echo lands between two reference frames; take the louder of them
+  const uint32_t* a = frame(lag_);
+  const uint32_t* b = frame(lag_ + 1);
+  uint64_t energy = 0, in = 0, out = 0;
+  for (int k = 1; k < BINS; k++) {
+    uint32_t r = a[k] > b[k] ? a[k] : b[k];
+    uint32_t h = held_[k] >> DECAY ? held_[k] - (held_[k] >> DECAY) : 0;
+    if (r > h) h = r;
+    held_[k] = h;
+    energy  += h;
+
+    uint32_t m = mic[k];
+    in += m;
+    if (!h || (!gain_[k] && !r)) {
+      out += m;
+      continue;
+    }
+
+    // frugal percentile of m/r, compared as m << G_SHIFT against G * r.
+    // Learnt against the live reference: the held one would bias it low.
+    uint64_t m16 = (uint64_t)m << G_SHIFT;
+    if (r && !gain_[k]) {
+      uint64_t g = m16 / r;  // first sighting of this bin: start at the ratio
+      gain_[k] = g < 1 ? 1 : g > GAIN_MAX ? GAIN_MAX : (uint32_t)g;
+    } else if (r) {
+      uint64_t gr   = (uint64_t)gain_[k] * r;
+      uint32_t step = gain_[k] >> rate;
+      if (step == 0) step = 1;
+      uint32_t up   = step * pct / 100,   down = step * (100 - pct) / 100;
+      if (m16 > gr) {
+        gain_[k] += up ? up : 1;
+        if (gain_[k] > GAIN_MAX) gain_[k] = GAIN_MAX;
+      } else if (m16 < gr) {
+        gain_[k] = gain_[k] > down + 1 ? gain_[k] - (down ? down : 1) : 1;
+      }
+    }
+    uint64_t gh = (uint64_t)gain_[k] * h;
+
+    // over-subtract: an echo-only bin goes to zero, not to a scaled copy
+    // of itself that would keep the music's harmonic shape
+    uint64_t echo = (gh >> G_SHIFT) << OVERSUB;
+    mic[k] = m > echo && !warming ? (uint32_t)(m - echo) : 0;
+    out   += mic[k];
+  }
+  if (warming) warmup_--;
+  refEnergy_  = energy;
+  removedPct_ = in ? (uint8_t)((in - out) * 100 / in) : 0;
+}
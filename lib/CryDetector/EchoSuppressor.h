@@ -0,0 +1,98 @@
+#pragma once
+// Playback-aware echo suppression for the cry detector.
+//
+// EchoReference taps the decoded lullaby on its way to the DAC and
+// decimates it to the mic rate. EchoSuppressor works on power spectra: it
+// follows the bulk speaker->mic delay (I2S and ADC buffering plus the air,
+// up to ~100 ms) by scoring a few frames of reference history against the
+// mic, then per bin learns the coupling G (mic power / reference power) as
+// a running percentile of the ratio, with the same frugal update as
+// NoiseFloor, and subtracts an over-estimate of the echo from the mic
+// spectrum. The reference is peak-held with a ~250 ms decay to cover the
+// room's reverb tail after playback stops. For the first frames of playback
+// after reset() the mic is gated outright while G converges.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+// Mono reference at the mic rate; producer and consumer both run in loop().
+class EchoReference {
+public:
+  static const uint32_t SIZE = 1024;  // power of two; 128 ms at 8 kHz
+
+  void begin(uint32_t micRate) { micRate_ = micRate; head_ = 0; acc_ = 0; count_ = 0; phase_ = 0; }
+
+  // One output sample at `outRate` Hz; boxcar-decimated to the mic rate.
+  void push(int16_t s, uint32_t outRate) {
+    acc_ += s;
+    count_++;
+    phase_ += micRate_;
+    if (phase_ < outRate) return;
+    phase_ -= outRate;
+    buf_[head_++ & (SIZE - 1)] = (int16_t)(acc_ / count_);
+    acc_ = 0;
+    count_ = 0;
+  }
+
+  uint32_t head() const { return head_; }
+
+  // The newest `n` (<= SIZE) samples, oldest first; false until that many.
+  bool latest(int16_t* dst, uint32_t n) const {
+    if (n > SIZE || head_ < n) return false;
+    for (uint32_t i = 0, p = head_ - n; i < n; i++, p++) dst[i] = buf_[p & (SIZE - 1)];
+    return true;
+  }
+
+private:
+  uint32_t micRate_ = 8000;
+  uint32_t head_    = 0;
+  int32_t  acc_     = 0;
+  int32_t  count_   = 0;
+  uint32_t phase_   = 0;
+  int16_t  buf_[SIZE];
+};
+
+class EchoSuppressor {
+public:
+  static const int BINS = 128;
+
+  // Forget the learned coupling (e.g. speaker volume changed).
+  void reset();
+
+  // True while the held reference still rings; suppress() is a no-op after.
+  bool active() const { return refEnergy_ != 0; }
+
+  // Remove the estimated echo from `mic` in place. `ref` is the reference
+  // power spectrum for this frame, or nullptr when playback is silent.
+  // The coupling keeps adapting through a cry: a low percentile rises only
+  // slowly while the mic carries more than the echo.
+  void suppress(uint32_t* mic, const uint32_t* ref);
+
+  // % of the input power removed from the last frame.
+  uint8_t lastRemovedPct() const { return removedPct_; }
+
+private:
+  static const int      LAGS      = 4;   // echo delays tried, in frames (~128 ms)
+  static const int      HIST      = LAGS + 1;
+  static const int      G_SHIFT   = 16;  // coupling is Q16
+  static const int      OVERSUB   = 2;   // subtract 4x the estimate
+  static const int      DECAY     = 2;   // held reference loses 1/4 per frame
+  static const int      RATE      = 6;   // frugal step: G/64 per frame
+  static const uint8_t  PCT       = 30;  // coupling tracks this percentile
+  static const int      WARMUP_FRAMES = 48;  // ~1.5 s gated after reset()
+  static const int      WARMUP_RATE   = 1;
+
+  const uint32_t* frame(int lag) const { return hist_[(head_ + HIST - lag) % HIST]; }
+  void trackLag(const uint32_t* mic);
+
+  uint32_t hist_[HIST][BINS] = {};  // reference spectra, newest at head_
+  int      head_           = 0;
+  int      lag_            = 0;
+  float    lagScore_[LAGS] = {};
+  uint32_t held_[BINS]     = {};
+  uint32_t gain_[BINS]     = {};   // 0 = not learned yet
+  uint64_t refEnergy_      = 0;
+  uint8_t  removedPct_     = 0;
+  int      warmup_         = WARMUP_FRAMES;
+};
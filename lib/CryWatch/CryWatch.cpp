@@ -0,0 +1,51 @@
+#include "CryWatch.h"
+
+static_assert(CryWatch::CryMfcc::N_MFCC == CryClassifier::N_IN, "MFCC size must match the CNN input");
+
+void CryWatch::begin(const CryWatchConfig& cfg, CryClassifier* classifier) {
+  cfg_        = cfg;
+  classifier_ = classifier;
+  CryDetectorConfig dc;
+  dc.sampleRate    = cfg.sampleRate;
+  dc.persistMs     = cfg.persistMs;
+  dc.minBandEnergy = cfg.minEnergy;
+  detector_.begin(dc);
+}
+
+void CryWatch::listen() {
+  hop_   = 0;
+  votes_ = 0;
+  detector_.reset();
+  if (classifier_) classifier_->reset();
+}
+
+bool CryWatch::frame(const int16_t* x, const int16_t* ref) {
+  bool spectral = detector_.process(x, ref);
+  if (!classifier_ || !classifier_->loaded()) return spectral;
+
+  int32_t coeffs[CryMfcc::N_MFCC];
+  CryMfcc::compute(detector_.power(), coeffs);
+  classifier_->push(coeffs);
+  if (++hop_ < cfg_.classifyHop || !classifier_->ready()) return false;
+  hop_ = 0;
+
+  uint16_t prob[CryClassifier::N_LABELS];
+  classifier_->infer(prob);
+  votes_ = prob[CryClassifier::CRY] >= cfg_.probThreshold ? votes_ + 1 : 0;
+  return votes_ >= cfg_.confirmVotes;
+}
+
+int32_t CryWatch::noiseFrame(const int16_t* x, NoiseFloor& floor) {
+  int32_t sum = 0;
+  for (int i = 0; i < FRAME; i++) sum += x[i];
+  int32_t mean = sum / FRAME;
+  uint64_t sq = 0;
+  for (int i = 0; i < FRAME; i++) {
+    int32_t d = x[i] - mean;
+    sq += (uint64_t)(d * d);
+  }
+  lastVar_ = (uint32_t)(sq / FRAME);
+  floor.update(lastVar_);
+  detector_.setMinBandEnergy(floor.threshold(cfg_.energyPerVar * cfg_.energyGain, cfg_.minEnergy));
+  return mean;
+}
@@ -0,0 +1,69 @@
+#pragma once
+// The cry verdict for each mic frame of a listening window, as the
+// firmware's loop() computes it. Each frame goes through the spectral
+// CryDetector and, when a model is loaded, the MFCC + CNN classifier,
+// which must vote "cry" on confirmVotes consecutive inferences. Room-noise
+// frames keep the NoiseFloor and the detector's minimum cry energy up to
+// date. When to listen, and what a verdict leads to, is SleepWake's call.
+//
+// Nothing here reads a clock, so the host replay harness (tools/replay)
+// runs this exact code on a virtual one.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include "CryDetector.h"
+#include "CryClassifier.h"
+#include "Mfcc.h"
+#include "NoiseFloor.h"
+
+struct CryWatchConfig {
+  uint32_t sampleRate    = 8000;
+  uint32_t persistMs     = 1500;  // net cry-like time (spectral detector)
+  // cry energy threshold, derived from the noise floor's frame variance
+  uint32_t energyPerVar  = 12;    // Parseval: band energy ≈ 12 × variance
+  uint32_t energyGain    = 8;     // cry must be ~9 dB over the floor
+  uint32_t minEnergy     = 2000;
+  // MFCC + CNN stage, used instead of the spectral verdict when loaded
+  int      classifyHop   = 8;     // frames between inferences (~256 ms)
+  uint16_t probThreshold = 180;   // Q8, ~70 %
+  int      confirmVotes  = 2;     // consecutive cry inferences
+};
+
+class CryWatch {
+public:
+  static const int      FRAME     = CryDetector::FRAME;
+  // the CNN was trained on 8 kHz MFCCs
+  static const uint32_t MFCC_RATE = 8000;
+  typedef Mfcc<FRAME, MFCC_RATE> CryMfcc;
+
+  // `classifier` may be null or unloaded: the spectral detector decides.
+  void begin(const CryWatchConfig& cfg, CryClassifier* classifier = nullptr);
+
+  // A listening window opens: forget the previous one's evidence.
+  void listen();
+
+  // One FRAME of raw ADC samples from the window, plus the matching speaker
+  // output while something plays. True once a cry is confirmed.
+  bool frame(const int16_t* x, const int16_t* ref = nullptr);
+
+  // Milliseconds of audio in one FRAME.
+  uint32_t frameMs() const { return (uint32_t)FRAME * 1000 / cfg_.sampleRate; }
+
+  // One FRAME of room noise (not the lullaby): updates `floor` and the
+  // detector's minimum cry energy. Returns the frame mean, for DC tracking.
+  int32_t noiseFrame(const int16_t* x, NoiseFloor& floor);
+  // Variance of the last noiseFrame(), on the floor's scale.
+  uint32_t lastVariance() const { return lastVar_; }
+
+  const CryWatchConfig& config() const { return cfg_; }
+  CryDetector&          detector()     { return detector_; }
+  const CryDetector&    detector() const { return detector_; }
+
+private:
+  CryWatchConfig cfg_;
+  CryDetector    detector_;
+  CryClassifier* classifier_ = nullptr;
+  int            hop_        = 0;
+  int            votes_      = 0;
+  uint32_t       lastVar_    = 0;
+};
@@ -0,0 +1,185 @@
+#include "EventJournal.h"
+#include <stddef.h>
+#include <stdio.h>
+
+static const uint16_t ACK = 0xFFFF;
+
+// CRC-32 (IEEE), bitwise: a record is 44 bytes
+static uint32_t crc32(const void* data, size_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = ~0u;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+template <class R>
+static uint32_t recordCrc(const R& r) {
+  return crc32(&r, offsetof(R, crc));
+}
+
+void EventJournal::name(int slot, char buf[24]) const {
+  snprintf(buf, 24, "%s%d", prefix_, slot);
+}
+
+void EventJournal::begin(const char* prefix) {
+  prefix_ = prefix;
+
+  // each segment up to its first bad record; the newest is the head
+  uint32_t newest = 0;
+  for (int s = 0; s < SEGMENTS; s++) {
+    char path[24];
+    name(s, path);
+    File f = LittleFS.open(path, "r");
+    if (!f) continue;
+    Record r;
+    size_t got;
+    while ((got = f.read((uint8_t*)&r, sizeof(r))) == sizeof(r) && r.crc == recordCrc(r)) {
+      seg_[s].lastSeq = r.seq;
+      seg_[s].records++;
+      if (r.event.kind == ACK && r.event.id > acked_) acked_ = r.event.id;
+      if (r.seq >= nextSeq_) nextSeq_ = r.seq + 1;
+    }
+    bool torn = got != 0;
+    f.close();
+    if (torn) stats_.corrupt++;
+    if (!seg_[s].records) {
+      LittleFS.remove(path);
+      continue;
+    }
+    if (torn) seg_[s].records = SEGMENT_RECORDS;   // append in the next one
+    if (seg_[s].lastSeq > newest) {
+      newest = seg_[s].lastSeq;
+      head_  = s;
+    }
+  }
+  for (int s = 0; s < SEGMENTS; s++) {
+    if (seg_[s].records) pending_ += scan(s);
+  }
+  if (!pending_) reset();
+}
+
+int EventJournal::scan(int slot, NetEvent* out, int have, int max) {
+  char path[24];
+  name(slot, path);
+  File   f = LittleFS.open(path, "r");
+  Record r;
+  int    n = 0;
+  while (f && f.read((uint8_t*)&r, sizeof(r)) == sizeof(r) && r.crc == recordCrc(r)) {
+    if (r.event.kind == ACK || r.seq <= acked_) continue;
+    if (out) {
+      if (have + n >= max) break;
+      out[have + n]     = r.event;
+      peeked_[have + n] = r.seq;
+    }
+    n++;
+  }
+  f.close();
+  return n;
+}
+
+bool EventJournal::append(const NetEvent& e) {
+  uint32_t start = micros();
+  Record r;
+  r.seq   = nextSeq_++;
+  r.event = e;
+  r.crc   = recordCrc(r);
+  bool ok = write(r);
+  if (ok) {
+    pending_++;
+    stats_.appended++;
+  } else {
+    stats_.failed++;
+  }
+  stats_.lastAppendUs = micros() - start;
+  if (stats_.lastAppendUs > stats_.maxAppendUs) stats_.maxAppendUs = stats_.lastAppendUs;
+  return ok;
+}
+
+bool EventJournal::write(Record& r) {
+  if (!prefix_) return false;
+  if (seg_[head_].records >= SEGMENT_RECORDS) rotate();
+  if (!headFile_) {
+    char path[24];
+    name(head_, path);
+    headFile_ = LittleFS.open(path, "a");
+    if (!headFile_) return false;
+  }
+  if (headFile_.write((const uint8_t*)&r, sizeof(r)) != sizeof(r)) {
+    headFile_.close();
+    seg_[head_].records = SEGMENT_RECORDS;   // whatever landed ends it
+    return false;
+  }
+  headFile_.flush();
+  seg_[head_].lastSeq = r.seq;
+  seg_[head_].records++;
+  return true;
+}
+
+// Move on to the next slot, dropping what the oldest segment still holds.
+void EventJournal::rotate() {
+  headFile_.close();
+  head_ = (head_ + 1) % SEGMENTS;
+  if (!seg_[head_].records) return;
+  uint32_t lost = scan(head_);
+  stats_.dropped += lost;
+  pending_       -= lost;
+  if (seg_[head_].lastSeq > acked_) acked_ = seg_[head_].lastSeq;
+  char path[24];
+  name(head_, path);
+  LittleFS.remove(path);
+  seg_[head_] = {};
+}
+
+// Nothing waits: no files at all.
+void EventJournal::reset() {
+  headFile_.close();
+  for (int s = 0; s < SEGMENTS; s++) {
+    char path[24];
+    name(s, path);
+    if (seg_[s].records) LittleFS.remove(path);
+    seg_[s] = {};
+  }
+  acked_ = nextSeq_ - 1;
+}
+
+int EventJournal::peek(NetEvent* out, int max) {
+  if (max > PEEK_MAX) max = PEEK_MAX;
+  int n = 0;
+  // oldest first: the slots after the head, the head last
+  for (int k = 1; k <= SEGMENTS && n < max; k++) {
+    int s = (head_ + k) % SEGMENTS;
+    if (seg_[s].records && seg_[s].lastSeq > acked_) n += scan(s, out, n, max);
+  }
+  if (!n && pending_) {   // the count was off: nothing left to read
+    pending_ = 0;
+    reset();
+  }
+  return n;
+}
+
+void EventJournal::ack(int n) {
+  if (n <= 0 || !prefix_) return;
+  acked_          = peeked_[n - 1];
+  pending_        = pending_ > (uint32_t)n ? pending_ - n : 0;
+  stats_.replayed += n;
+  if (!pending_) {
+    reset();
+    return;
+  }
+  Record r;
+  r.seq   = nextSeq_++;
+  r.event = NetEvent(ACK, nullptr, 0, acked_);
+  r.crc   = recordCrc(r);
+  write(r);
+  for (int s = 0; s < SEGMENTS; s++) {
+    if (s != head_ && seg_[s].records && seg_[s].lastSeq <= acked_) {
+      char path[24];
+      name(s, path);
+      LittleFS.remove(path);
+      seg_[s] = {};
+    }
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+// Outbound events kept in flash while the cloud can't be reached.
+//
+// The network task used to print "failed" and forget an event it couldn't
+// send. Now it appends the event here instead, and replays the journal a
+// batch at a time, oldest first, once the server answers again; anything
+// produced while events are waiting goes in behind them, so the cloud
+// still hears it all in order.
+//
+// The journal is append-only: fixed-size records, each with a sequence
+// number and a CRC, in SEGMENTS files on LittleFS used as a ring. An
+// acknowledgement is one more record, naming the last event delivered;
+// a segment is deleted once everything in it has been, and the whole ring
+// once nothing is waiting. Writes thus move on through fresh files and
+// LittleFS spreads them over its blocks; nothing is rewritten in place.
+// When the ring is full the oldest segment makes room, its undelivered
+// events counted as dropped. A record torn by a reset fails its CRC and
+// ends its segment; appends carry on in the next one.
+//
+// RAM is fixed: per-segment bookkeeping and one open file. Only the
+// network task appends (loop() just queues), so flash never stalls
+// sensing; append times are in the stats.
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "EventQueue.h"
+
+class EventJournal {
+public:
+  static const int SEGMENTS        = 4;
+  static const int SEGMENT_RECORDS = 64;   // 44 B each, under one 4 KB block
+  static const int PEEK_MAX        = 8;
+
+  struct Stats {
+    uint32_t appended;      // events journaled since boot
+    uint32_t replayed;      // ...and acknowledged
+    uint32_t dropped;       // undelivered when their segment was reused
+    uint32_t corrupt;       // segments cut short at begin() by a record failing its CRC
+    uint32_t failed;        // appends that couldn't be written
+    uint32_t lastAppendUs, maxAppendUs;
+  };
+
+  // Pick up the journal in files `prefix`0..SEGMENTS-1; LittleFS must be
+  // mounted. Until then nothing is kept.
+  void begin(const char* prefix = "/journal");
+
+  // Keep `e`. False if it couldn't be written.
+  bool append(const NetEvent& e);
+
+  // Events waiting for delivery.
+  uint32_t pending() const { return pending_; }
+
+  // Up to `max` (at most PEEK_MAX) of the oldest waiting events, in order.
+  int  peek(NetEvent* out, int max);
+  // The first `n` events of the last peek() are delivered.
+  void ack(int n);
+
+  const Stats& stats() const { return stats_; }
+
+private:
+  struct Record {
+    uint32_t seq;
+    NetEvent event;   // kind ACK: event.id is the last seq delivered
+    uint32_t crc;
+  };
+  struct Segment {
+    uint32_t lastSeq;
+    uint16_t records;   // SEGMENT_RECORDS once full or torn
+  };
+
+  void name(int slot, char buf[24]) const;
+  bool write(Record& r);
+  void rotate();
+  void reset();
+  // Events after acked_ in `slot`. With `out`, they are copied to
+  // out[have...] and their seqs to peeked_[have...], up to out[max - 1].
+  int  scan(int slot, NetEvent* out = nullptr, int have = 0, int max = 0);
+
+  const char* prefix_  = nullptr;
+  Segment     seg_[SEGMENTS] = {};
+  int         head_    = 0;      // slot appended to
+  File        headFile_;
+  uint32_t    nextSeq_ = 1;
+  uint32_t    acked_   = 0;      // events up to here are delivered
+  uint32_t    pending_ = 0;
+  uint32_t    peeked_[PEEK_MAX];
+  Stats       stats_   = {};
+};
@@ -0,0 +1,37 @@
+#include "EventBatch.h"
+#include <stdio.h>
+#include <time.h>
+
+static void isoTime(uint32_t t, char iso[24]) {
+  time_t    tt = (time_t)t;
+  struct tm g;
+  gmtime_r(&tt, &g);
+  strftime(iso, 24, "%Y-%m-%dT%H:%M:%SZ", &g);
+}
+
+size_t EventBatch::writeJson(char* buf, size_t len, uint16_t commandKind, int from, int count) const {
+  size_t pos = 0;
+  int    end = count < count_ - from ? from + count : count_;
+  int    w;
+  // commands first, then patterns, each in the order they happened
+  for (int pass = 0; pass < 2; pass++) {
+    bool commands = pass == 0;
+    w = snprintf(buf + pos, len - pos, commands ? "{\"commands\":[" : "],\"patterns\":[");
+    if (w < 0 || (size_t)w >= len - pos) return 0;
+    pos += w;
+    bool first = true;
+    for (int i = from; i < end; i++) {
+      if ((events_[i].kind == commandKind) != commands) continue;
+      char iso[24];
+      isoTime(events_[i].utc, iso);
+      w = snprintf(buf + pos, len - pos, "%s{\"%s\":\"%s\",\"timestamp\":\"%s\"}", first ? "" : ",",
+                   commands ? "command" : "patternType", events_[i].text, iso);
+      if (w < 0 || (size_t)w >= len - pos) return 0;
+      pos += w;
+      first = false;
+    }
+  }
+  w = snprintf(buf + pos, len - pos, "]}");
+  if (w < 0 || (size_t)w >= len - pos) return 0;
+  return pos + w;
+}
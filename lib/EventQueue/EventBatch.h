@@ -0,0 +1,94 @@
+#pragma once
+// Small events bound for the cloud, merged into one request.
+//
+// An incident used to cost an HTTPS request per event: the wake alert
+// alone is a notification and a vibrate, each a round trip with the radio
+// up. The consumer of an EventQueue adds such events to a batch instead
+// and sends it as one body once it is due: `maxMs` after its oldest event
+// was produced, at once when an urgent event joins it, or when it is full.
+// The caller flushes it before anything it doesn't batch, so the cloud
+// still hears everything in the order it happened.
+//
+// Only the consumer changes it; stats() are plain counters anyone may
+// read for a status line.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+#include "EventQueue.h"
+
+class EventBatch {
+public:
+  static const int MAX = 8;
+
+  // what made a batch go
+  enum Reason : uint8_t { NONE, URGENT, FULL, TIMER, BARRIER };
+
+  struct Stats {
+    uint32_t batches;     // flushed
+    uint32_t events;      // in them
+    uint32_t byReason[5]; // batches, indexed by Reason
+    uint32_t lastHoldMs;  // oldest event produced -> batch flushed
+    uint32_t maxHoldMs;
+  };
+
+  explicit EventBatch(uint32_t maxMs = 2000) : maxMs_(maxMs) {}
+  void setMaxMs(uint32_t ms) { maxMs_ = ms; }
+
+  // False when full: flush it first.
+  bool add(const NetEvent& e, bool urgent) {
+    if (count_ >= MAX) return false;
+    events_[count_++] = e;
+    urgent_ |= urgent;
+    return true;
+  }
+
+  // Why it should go now, `nowMs` on the events' millis() clock; NONE
+  // while it may wait.
+  Reason due(uint32_t nowMs) const {
+    if (!count_)                          return NONE;
+    if (urgent_)                          return URGENT;
+    if (count_ >= MAX)                    return FULL;
+    if (nowMs - events_[0].ms >= maxMs_)  return TIMER;
+    return NONE;
+  }
+
+  // How long it may wait yet; UINT32_MAX when empty.
+  uint32_t msLeft(uint32_t nowMs) const {
+    if (!count_) return UINT32_MAX;
+    uint32_t held = nowMs - events_[0].ms;
+    return held >= maxMs_ ? 0 : maxMs_ - held;
+  }
+
+  int             count()            const { return count_; }
+  const NetEvent& operator[](int i)  const { return events_[i]; }
+
+  // The batch as the document uploaded,
+  //   {"commands":[{"command":text,"timestamp":iso}...],"patterns":[{"patternType":...}...]}
+  // events of kind `commandKind` being commands and the rest patterns.
+  // Only `count` events from index `from` go in, to split a batch that won't
+  // fit. Returns the length written, 0 if `len` was too small.
+  size_t writeJson(char* buf, size_t len, uint16_t commandKind, int from = 0, int count = MAX) const;
+
+  // Once sent (or given up on): empty it and count it under `why`.
+  void clear(Reason why, uint32_t nowMs) {
+    if (!count_) return;
+    uint32_t held = nowMs - events_[0].ms;
+    stats_.batches++;
+    stats_.events += count_;
+    stats_.byReason[why]++;
+    stats_.lastHoldMs = held;
+    if (held > stats_.maxHoldMs) stats_.maxHoldMs = held;
+    count_  = 0;
+    urgent_ = false;
+  }
+
+  const Stats& stats() const { return stats_; }
+
+private:
+  NetEvent events_[MAX];
+  int      count_  = 0;
+  bool     urgent_ = false;
+  uint32_t maxMs_;
+  Stats    stats_  = {};
+};
@@ -0,0 +1,97 @@
+#pragma once
+// Single-producer/single-consumer queue of outbound events. loop() pushes
+// and returns at once; the network task pops and makes the HTTPS calls, so
+// a slow or dead link never holds up sensing. Each event carries the
+// millis() and UTC time it was produced, so what reaches the cloud is
+// stamped when it happened, not when it was sent, and the consumer can
+// tell how long it waited.
+//
+// Neither side locks or blocks. A full queue drops the new event and
+// counts it, as EdgeQueue does.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+struct NetEvent {
+  uint16_t kind;       // the caller's
+  uint16_t arg;
+  uint32_t id;
+  char     text[20];   // e.g. a command name
+  uint32_t ms;         // millis() when produced
+  uint32_t utc;        // time() when produced
+
+  NetEvent(uint16_t k = 0, const char* t = nullptr, uint16_t a = 0, uint32_t i = 0)
+    : kind(k), arg(a), id(i), text{}, ms(0), utc(0) {
+    if (t) strncpy(text, t, sizeof(text) - 1);
+  }
+};
+
+class EventQueue {
+public:
+  static const uint32_t SIZE = 16;  // power of two
+
+  struct Stats {
+    uint32_t pushed;       // events queued since boot
+    uint32_t dropped;      // events refused on a full queue
+    uint32_t depth;        // waiting now...
+    uint32_t maxDepth;     // ...and at most
+    uint32_t lastWaitMs;   // produced -> picked up by the consumer
+    uint32_t maxWaitMs;
+    uint32_t totalWaitMs;  // over `pushed - depth` events
+  };
+
+  // Producer side. `e.ms` and `e.utc` are stamped by the caller. False, and
+  // one more drop, when full.
+  bool push(const NetEvent& e) {
+    uint32_t h = head_.load(std::memory_order_relaxed);
+    uint32_t n = h - tail_.load(std::memory_order_acquire);
+    if (n >= SIZE) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    buf_[h & (SIZE - 1)] = e;
+    head_.store(h + 1, std::memory_order_release);
+    if (n + 1 > maxDepth_.load(std::memory_order_relaxed)) maxDepth_.store(n + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Consumer side; `nowMs` on the events' millis() clock.
+  bool pop(NetEvent& e, uint32_t nowMs) {
+    uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    e = buf_[t & (SIZE - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    uint32_t wait = nowMs - e.ms;
+    lastWaitMs_.store(wait, std::memory_order_relaxed);
+    if (wait > maxWaitMs_.load(std::memory_order_relaxed)) maxWaitMs_.store(wait, std::memory_order_relaxed);
+    totalWaitMs_.store(totalWaitMs_.load(std::memory_order_relaxed) + wait, std::memory_order_relaxed);
+    return true;
+  }
+
+  uint32_t size() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+
+  // Either side.
+  Stats stats() const {
+    Stats s;
+    s.pushed      = head_.load(std::memory_order_relaxed);
+    s.dropped     = dropped_.load(std::memory_order_relaxed);
+    s.depth       = size();
+    s.maxDepth    = maxDepth_.load(std::memory_order_relaxed);
+    s.lastWaitMs  = lastWaitMs_.load(std::memory_order_relaxed);
+    s.maxWaitMs   = maxWaitMs_.load(std::memory_order_relaxed);
+    s.totalWaitMs = totalWaitMs_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+private:
+  NetEvent              buf_[SIZE];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> maxDepth_{0};
+  std::atomic<uint32_t> lastWaitMs_{0};
+  std::atomic<uint32_t> maxWaitMs_{0};
+  std::atomic<uint32_t> totalWaitMs_{0};
+};
@@ -0,0 +1,142 @@
+#include "FrameDiff.h"
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+static inline uint32_t cycleNow() { return esp_cpu_get_ccount(); }
+#else
+#include <chrono>
+static inline uint32_t cycleNow() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static const uint32_t GUARD = 0x80808080;  // the spare top bit of each pixel
+static const uint32_t LOW7  = 0x7f7f7f7f;
+static const uint32_t ONES  = 0x01010101;
+
+// |a - b| for four 7-bit pixels. (a | GUARD) - b is 128 + a - b per byte
+// and never borrows across; its guard bit is clear exactly where a < b.
+static inline uint32_t absDiff(uint32_t a, uint32_t b) {
+  uint32_t x   = (a | GUARD) - b;
+  uint32_t neg = (~x & GUARD) >> 7;
+  return ((x & LOW7) ^ (neg * 0x7f)) + neg;
+}
+
+// max(d - t, 0) per pixel.
+static inline uint32_t minusFloor(uint32_t d, uint32_t t) {
+  uint32_t x    = (d | GUARD) - t;
+  uint32_t keep = (x & GUARD) >> 7;
+  return x & LOW7 & (keep * 0x7f);
+}
+
+// One step of b towards a: +1 where a > b, -1 where a < b.
+static inline uint32_t stepToward(uint32_t b, uint32_t a) {
+  uint32_t up   = (((a | GUARD) - b - ONES) & GUARD) >> 7;
+  uint32_t down = (((b | GUARD) - a - ONES) & GUARD) >> 7;
+  return b + up - down;
+}
+
+void FrameDiff::begin(uint8_t noise, uint8_t learnEvery) {
+  noise_      = noise >> 1;
+  learnEvery_ = learnEvery ? learnEvery : 1;
+  learnCount_ = 0;
+  frames_     = 0;
+  total_      = 0;
+  maxCycles_  = 0;
+  memset(energy_, 0, sizeof(energy_));
+}
+
+void FrameDiff::load(const uint8_t* gray, int w, int h, int stride) {
+  uint8_t* out = (uint8_t*)cur_;
+  for (int oy = 0; oy < H; oy++) {
+    int y0 = oy * h / H, y1 = (oy + 1) * h / H;
+    if (y1 <= y0) y1 = y0 + 1;
+    for (int ox = 0; ox < W; ox++) {
+      int x0 = ox * w / W, x1 = (ox + 1) * w / W;
+      if (x1 <= x0) x1 = x0 + 1;
+      uint32_t sum = 0;
+      for (int y = y0; y < y1; y++) {
+        const uint8_t* row = gray + (size_t)y * stride;
+        for (int x = x0; x < x1; x++) sum += row[x];
+      }
+      out[oy * W + ox] = (uint8_t)(sum / ((y1 - y0) * (x1 - x0)) >> 1);
+    }
+  }
+}
+
+void FrameDiff::process() {
+  uint32_t start = cycleNow();
+  if (frames_++ == 0) {
+    memcpy(bg_, cur_, sizeof(bg_));
+    return;
+  }
+  bool learn = ++learnCount_ >= learnEvery_;
+  if (learn) learnCount_ = 0;
+  if (heat_) {
+    // a frame adds at most 127 a pixel: make room for it first
+    if (heatPeak_ > 0xffff - 0x7f) {
+      for (int i = 0; i < W * H; i++) heat_[i] >>= 1;
+      heatPeak_ >>= 1;
+      heatHalvings_++;
+    }
+    heatFrames_++;
+  }
+
+  const uint32_t floor = noise_ * ONES;
+  uint32_t total = 0;
+  for (int ry = 0; ry < ROWS; ry++) {
+    for (int rx = 0; rx < COLS; rx++) {
+      uint32_t acc = 0;  // two 16-bit lanes
+      for (int y = ry * REGION_H; y < (ry + 1) * REGION_H; y++) {
+        int w0 = (y * W + rx * REGION_W) / 4;
+        for (int w = w0; w < w0 + REGION_W / 4; w++) {
+          uint32_t a = cur_[w], b = bg_[w];
+          uint32_t e = minusFloor(absDiff(a, b), floor);
+          acc += (e & 0x00ff00ff) + ((e >> 8) & 0x00ff00ff);
+          if (heat_ && e) addHeat(w, e);
+          if (learn) bg_[w] = stepToward(b, a);
+        }
+      }
+      // back to 8-bit grey levels
+      uint32_t e = ((acc & 0xffff) + (acc >> 16)) * 2;
+      energy_[ry * COLS + rx] = e;
+      total += e;
+    }
+  }
+  total_ = total;
+
+  lastCycles_ = cycleNow() - start;
+  if (lastCycles_ > maxCycles_) maxCycles_ = lastCycles_;
+}
+
+void FrameDiff::heatmap(uint16_t* heat) {
+  heat_ = heat;
+  clearHeat();
+}
+
+void FrameDiff::clearHeat() {
+  if (heat_) memset(heat_, 0, W * H * sizeof(uint16_t));
+  heatPeak_     = 0;
+  heatFrames_   = 0;
+  heatHalvings_ = 0;
+}
+
+// The four pixels of a word: byte k (little-endian) is pixel 4 * word + k.
+void FrameDiff::addHeat(int word, uint32_t e) {
+  uint16_t* h = heat_ + word * 4;
+  for (int k = 0; k < 4; k++, e >>= 8) {
+    uint16_t v = h[k] + (e & 0x7f);
+    h[k] = v;
+    if (v > heatPeak_) heatPeak_ = v;
+  }
+}
+
+void FrameDiff::snapshot(Snapshot& s) const {
+  s.frames     = frames_;
+  s.total      = total_;
+  memcpy(s.energy, energy_, sizeof(s.energy));
+  s.lastCycles = lastCycles_;
+  s.maxCycles  = maxCycles_;
+}
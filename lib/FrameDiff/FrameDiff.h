@@ -0,0 +1,93 @@
+#pragma once
+// Frame-difference motion on a small grayscale image.
+//
+// Each frame is box-decimated to 80x60 and kept at 7 bits per pixel, so
+// four pixels share a 32-bit word with a spare guard bit each: absolute
+// differences, the noise threshold and the background update are done four
+// pixels per instruction (SIMD within a register) with no carries crossing
+// pixels. The background is a sigma-delta estimate, stepped one grey level
+// towards the frame every `learnEvery` frames, so lighting drifts and a
+// baby who settles in a new spot fade into it while a hand or a rolling
+// body shows up at once. Differences under `noise` levels are sensor noise
+// and are dropped; what is left is summed per region of a 4x3 grid.
+//
+// With a heat buffer attached, what is left is also added per pixel into
+// W x H 16-bit counters over many frames: where the baby moved during the
+// night, in constant memory. Before a pixel could overflow, the whole map
+// halves, so it keeps its shape and only loses the faintest traces.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+class FrameDiff {
+public:
+  static const int W       = 80;
+  static const int H       = 60;
+  static const int COLS    = 4;
+  static const int ROWS    = 3;
+  static const int REGIONS = COLS * ROWS;
+
+  struct Snapshot {
+    uint32_t frames;            // frames processed since begin()
+    uint32_t total;             // motion energy of the last frame
+    uint32_t energy[REGIONS];   // per region, row-major from top-left
+    uint32_t lastCycles;        // cost of the last process(), CPU cycles
+    uint32_t maxCycles;         //   (ns on the host)
+  };
+
+  // `noise` in 8-bit grey levels.
+  void begin(uint8_t noise = 12, uint8_t learnEvery = 1);
+
+  // Box-decimate an 8-bit grayscale image into the working frame.
+  void load(const uint8_t* gray, int w, int h, int stride);
+
+  // Difference the loaded frame against the background, then let the
+  // background learn. The first frame only primes the background.
+  void process();
+
+  uint32_t        total()        const { return total_; }
+  const uint32_t* energy()       const { return energy_; }
+  // Mean energy per pixel of the frame, in 8-bit grey levels x 256.
+  uint32_t        level()        const { return (uint32_t)((uint64_t)total_ * 256 / (W * H)); }
+  uint32_t        frames()       const { return frames_; }
+  uint32_t        lastCycles()   const { return lastCycles_; }
+  uint32_t        maxCycles()    const { return maxCycles_; }
+  void            snapshot(Snapshot& s) const;
+
+  const uint8_t*  frame()        const { return (const uint8_t*)cur_; }
+  const uint8_t*  background()   const { return (const uint8_t*)bg_; }
+
+  // `heat` holds W x H counters, cleared here; nullptr stops accumulating.
+  void            heatmap(uint16_t* heat);
+  void            clearHeat();
+  const uint16_t* heat()         const { return heat_; }
+  uint16_t        heatPeak()     const { return heatPeak_; }
+  uint32_t        heatFrames()   const { return heatFrames_; }  // added since the clear
+  uint16_t        heatHalvings() const { return heatHalvings_; }
+
+private:
+  static const int WORDS        = W * H / 4;
+  static const int REGION_W     = W / COLS;
+  static const int REGION_H     = H / ROWS;
+  static_assert(W % (4 * COLS) == 0 && H % ROWS == 0, "regions must be whole words");
+  // two 16-bit lanes per accumulator, each adding at most 2 x 127 per word
+  static_assert(REGION_W / 4 * REGION_H * 254 < 65536, "region sum must fit a 16-bit lane");
+
+  void addHeat(int word, uint32_t e);
+
+  uint32_t cur_[WORDS];
+  uint32_t bg_[WORDS];
+  uint32_t energy_[REGIONS] = {};
+  uint32_t total_      = 0;
+  uint32_t frames_     = 0;
+  uint32_t lastCycles_ = 0;
+  uint32_t maxCycles_  = 0;
+  uint8_t  noise_      = 6;   // 7-bit levels
+  uint8_t  learnEvery_ = 1;
+  uint8_t  learnCount_ = 0;
+  uint16_t* heat_         = nullptr;
+  uint16_t  heatPeak_     = 0;
+  uint32_t  heatFrames_   = 0;
+  uint16_t  heatHalvings_ = 0;
+};
@@ -0,0 +1,116 @@
+#pragma once
+// Streaming IMA-ADPCM (4 bits/sample, 4:1 against 16-bit PCM).
+//
+// The encoder quantises each prediction error with masks instead of the
+// reference's three compare-and-subtract branches, and the 12-bit
+// ADC -> 16-bit PCM conversion is a separate straight-line pass the
+// compiler can vectorise. Nothing allocates: state is four bytes and the
+// caller owns every buffer. encodeBlock()/decodeBlock() produce the
+// self-contained 256-byte blocks of WAV format 0x11, so blocks can be
+// dropped (lossy links) or decoded independently.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ima_adpcm {
+
+static const int16_t STEP[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+  11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+  32767
+};
+
+static const int8_t INDEX_DELTA[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static const size_t   BLOCK_BYTES       = 256;
+static const size_t   SAMPLES_PER_BLOCK = (BLOCK_BYTES - 4) * 2 + 1;  // 505
+
+static inline int32_t clamp16(int32_t v) { return v > 32767 ? 32767 : v < -32768 ? -32768 : v; }
+
+// 12-bit ADC samples around `dc` -> 16-bit PCM. Branch-free, vectorisable.
+static inline void adcToPcm16(const int16_t* adc, size_t n, int dc, int16_t* out) {
+  for (size_t i = 0; i < n; i++) out[i] = (int16_t)clamp16((adc[i] - dc) * 16);
+}
+
+struct State {
+  int16_t predictor = 0;
+  uint8_t index     = 0;
+};
+
+// One sample; returns the 4-bit code and advances `s` as the decoder will.
+static inline uint8_t encodeSample(State& s, int16_t sample) {
+  int32_t step = STEP[s.index];
+  int32_t diff = sample - s.predictor;
+  uint8_t sign = (uint8_t)((uint32_t)diff >> 28) & 8;
+  diff = sign ? -diff : diff;
+
+  // the reference's three compare-and-subtract steps, as masks; `delta`
+  // accumulates exactly what the decoder will reconstruct
+  int32_t delta = step >> 3, m;
+  uint32_t q;
+  m = -(int32_t)(diff >= step);        q  = 4 & m; diff -= step & m;        delta += step & m;
+  m = -(int32_t)(diff >= step >> 1);   q |= 2 & m; diff -= (step >> 1) & m; delta += (step >> 1) & m;
+  m = -(int32_t)(diff >= step >> 2);   q |= 1 & m;                          delta += (step >> 2) & m;
+  s.predictor = (int16_t)clamp16(s.predictor + (sign ? -delta : delta));
+
+  int idx = s.index + INDEX_DELTA[q];
+  s.index = (uint8_t)(idx < 0 ? 0 : idx > 88 ? 88 : idx);
+  return (uint8_t)(q | sign);
+}
+
+static inline int16_t decodeSample(State& s, uint8_t code) {
+  int32_t step  = STEP[s.index];
+  int32_t delta = step >> 3;
+  if (code & 4) delta += step;
+  if (code & 2) delta += step >> 1;
+  if (code & 1) delta += step >> 2;
+  s.predictor = (int16_t)clamp16(s.predictor + ((code & 8) ? -delta : delta));
+  int idx = s.index + INDEX_DELTA[code & 7];
+  s.index = (uint8_t)(idx < 0 ? 0 : idx > 88 ? 88 : idx);
+  return s.predictor;
+}
+
+// Encode `n` samples (n even) into n/2 bytes, first sample in the low nibble.
+static inline size_t encode(State& s, const int16_t* pcm, size_t n, uint8_t* out) {
+  for (size_t i = 0; i + 1 < n; i += 2) {
+    uint8_t lo = encodeSample(s, pcm[i]);
+    uint8_t hi = encodeSample(s, pcm[i + 1]);
+    *out++ = (uint8_t)(lo | (hi << 4));
+  }
+  return n / 2;
+}
+
+static inline size_t decode(State& s, const uint8_t* in, size_t bytes, int16_t* out) {
+  for (size_t i = 0; i < bytes; i++) {
+    *out++ = decodeSample(s, in[i] & 0x0F);
+    *out++ = decodeSample(s, in[i] >> 4);
+  }
+  return bytes * 2;
+}
+
+// SAMPLES_PER_BLOCK samples -> one BLOCK_BYTES WAV/IMA block. The header
+// carries the first sample and step index, so `s` only seeds the index.
+static inline void encodeBlock(State& s, const int16_t* pcm, uint8_t* out) {
+  s.predictor = pcm[0];
+  out[0] = (uint8_t)s.predictor;
+  out[1] = (uint8_t)((uint16_t)s.predictor >> 8);
+  out[2] = s.index;
+  out[3] = 0;
+  // WAV packs 8 samples per 4-byte group, low nibble first; same as encode()
+  encode(s, pcm + 1, SAMPLES_PER_BLOCK - 1, out + 4);
+}
+
+static inline void decodeBlock(const uint8_t* in, int16_t* pcm) {
+  State s;
+  s.predictor = (int16_t)(in[0] | (in[1] << 8));
+  s.index     = in[2] > 88 ? 88 : in[2];
+  pcm[0] = s.predictor;
+  decode(s, in + 4, BLOCK_BYTES - 4, pcm + 1);
+}
+
+}  // namespace ima_adpcm
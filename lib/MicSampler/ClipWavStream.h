@@ -0,0 +1,135 @@
+#pragma once
+// Presents a pinned AudioClip as a mono WAV Stream, generated on the fly
+// from the clip's blocks: HTTPClient::sendRequest() and WebServer can both
+// send it without the clip ever being copied into one buffer.
+//
+// IMA_ADPCM (WAV format 0x11) is a quarter of the PCM16 size; it is encoded
+// one 256-byte block at a time as the stream is read.
+#include <Arduino.h>
+#include "SampleRing.h"
+#include "ImaAdpcm.h"
+
+class ClipWavStream : public Stream {
+public:
+  enum Format : uint8_t { PCM16, IMA_ADPCM };
+
+  // `dc` is the ADC bias removed before the 12-bit samples are scaled to 16.
+  ClipWavStream(const AudioClip& clip, uint32_t sampleRate, int dc, Format fmt = PCM16)
+    : clip_(clip), rate_(sampleRate), dc_(dc), fmt_(fmt) {
+    buildHeader();
+  }
+
+  size_t size() const { return header() + dataBytes(); }
+
+  int available() override { return (int)(size() - pos_); }
+  int peek() override {
+    char c;
+    return fill(&c, 1, false) ? (uint8_t)c : -1;
+  }
+  int read() override {
+    char c;
+    return fill(&c, 1, true) ? (uint8_t)c : -1;
+  }
+  size_t readBytes(char* buf, size_t len) override { return fill(buf, len, true); }
+  size_t write(uint8_t) override { return 0; }
+  void flush() override {}
+
+private:
+  static const size_t PCM_HEADER   = 44;
+  static const size_t ADPCM_HEADER = 60;  // 20-byte fmt chunk + fact chunk
+
+  size_t   header()    const { return fmt_ == PCM16 ? PCM_HEADER : ADPCM_HEADER; }
+  uint32_t blocks()    const {
+    return (clip_.length() + ima_adpcm::SAMPLES_PER_BLOCK - 1) / ima_adpcm::SAMPLES_PER_BLOCK;
+  }
+  uint32_t dataBytes() const {
+    return fmt_ == PCM16 ? clip_.length() * 2 : blocks() * ima_adpcm::BLOCK_BYTES;
+  }
+
+  void put32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+  void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+
+  void buildHeader() {
+    uint32_t data = dataBytes();
+    memcpy(hdr_, "RIFF", 4);      put32(hdr_ + 4, header() - 8 + data);
+    memcpy(hdr_ + 8, "WAVEfmt ", 8);
+    if (fmt_ == PCM16) {
+      put32(hdr_ + 16, 16);         put16(hdr_ + 20, 1);   // PCM
+      put16(hdr_ + 22, 1);          put32(hdr_ + 24, rate_);
+      put32(hdr_ + 28, rate_ * 2);  put16(hdr_ + 32, 2);
+      put16(hdr_ + 34, 16);
+      memcpy(hdr_ + 36, "data", 4); put32(hdr_ + 40, data);
+      return;
+    }
+    put32(hdr_ + 16, 20);         put16(hdr_ + 20, 0x11);  // IMA ADPCM
+    put16(hdr_ + 22, 1);          put32(hdr_ + 24, rate_);
+    put32(hdr_ + 28, rate_ * ima_adpcm::BLOCK_BYTES / ima_adpcm::SAMPLES_PER_BLOCK);
+    put16(hdr_ + 32, ima_adpcm::BLOCK_BYTES);
+    put16(hdr_ + 34, 4);          put16(hdr_ + 36, 2);
+    put16(hdr_ + 38, ima_adpcm::SAMPLES_PER_BLOCK);
+    memcpy(hdr_ + 40, "fact", 4); put32(hdr_ + 44, 4);
+    put32(hdr_ + 48, clip_.length());
+    memcpy(hdr_ + 52, "data", 4); put32(hdr_ + 56, data);
+  }
+
+  size_t fill(char* out, size_t len, bool advance) {
+    size_t pos = pos_, done = 0;
+    while (done < len && pos < size()) {
+      if (pos < header()) {
+        out[done++] = hdr_[pos++];
+        continue;
+      }
+      if (fmt_ == IMA_ADPCM) {
+        uint32_t off = pos - header();
+        if (!encodeBlock(off / ima_adpcm::BLOCK_BYTES)) break;
+        size_t n = ima_adpcm::BLOCK_BYTES - off % ima_adpcm::BLOCK_BYTES;
+        if (n > len - done) n = len - done;
+        memcpy(out + done, block_ + off % ima_adpcm::BLOCK_BYTES, n);
+        done += n;
+        pos  += n;
+        continue;
+      }
+      // whole samples only; an odd split re-reads the sample
+      int16_t s[64];
+      uint32_t first = (pos - header()) / 2;
+      uint32_t want  = (len - done + 1) / 2 + 1;
+      uint32_t got   = clip_.read(first, s, want < 64 ? want : 64);
+      if (!got) break;
+      for (uint32_t i = 0; i < got && done < len; i++) {
+        int32_t v = ima_adpcm::clamp16((s[i] - dc_) * 16);
+        uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+        for (int k = ((pos - header()) & 1); k < 2 && done < len; k++) {
+          out[done++] = b[k];
+          pos++;
+        }
+      }
+    }
+    if (advance) pos_ = pos;
+    return done;
+  }
+
+  // Encode block `n` into block_ unless it is already there. The step index
+  // carries over from the previous block, as a sequential encoder would.
+  bool encodeBlock(uint32_t n) {
+    if (n == blockNo_) return true;
+    int16_t pcm[ima_adpcm::SAMPLES_PER_BLOCK];
+    uint32_t got = clip_.read(n * ima_adpcm::SAMPLES_PER_BLOCK, pcm, ima_adpcm::SAMPLES_PER_BLOCK);
+    if (!got) return false;
+    // pad the final block with its last sample (silence after DC removal)
+    for (uint32_t i = got; i < ima_adpcm::SAMPLES_PER_BLOCK; i++) pcm[i] = pcm[got - 1];
+    ima_adpcm::adcToPcm16(pcm, ima_adpcm::SAMPLES_PER_BLOCK, dc_, pcm);
+    ima_adpcm::encodeBlock(adpcm_, pcm, block_);
+    blockNo_ = n;
+    return true;
+  }
+
+  const AudioClip&  clip_;
+  uint32_t          rate_;
+  int               dc_;
+  Format            fmt_;
+  uint8_t           hdr_[ADPCM_HEADER];
+  size_t            pos_ = 0;
+  ima_adpcm::State  adpcm_;
+  uint8_t           block_[ima_adpcm::BLOCK_BYTES];
+  uint32_t          blockNo_ = UINT32_MAX;
+};
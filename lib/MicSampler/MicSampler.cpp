@@ -0,0 +1,141 @@
+#include "MicSampler.h"
+#include "driver/adc.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+// One DMA "frame" worth of conversions per read; at 8 kHz mic + aux this
+// is 16 ms of audio, and the driver pool below holds eight of them.
+static const uint32_t CONV_PER_READ  = 256;
+static const uint32_t READ_BYTES     = CONV_PER_READ * SOC_ADC_DIGI_RESULT_BYTES;
+static const uint32_t POOL_BYTES     = READ_BYTES * 8;
+static const int      MIC_TASK_CORE  = 0;
+static const int      MIC_TASK_PRIO  = 5;
+
+// Carve `count` blocks out of one PSRAM (else internal) allocation.
+static bool allocBlocks(int16_t** blocks, uint32_t count) {
+  size_t bytes = (size_t)count * SampleRing::BLOCK * sizeof(int16_t);
+  int16_t* storage = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  if (!storage) storage = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+  if (!storage) return false;
+  for (uint32_t i = 0; i < count; i++) blocks[i] = storage + i * SampleRing::BLOCK;
+  return true;
+}
+
+bool MicSampler::allocClip(AudioClip& clip, uint32_t samples) {
+  int16_t* blocks[AudioClip::MAX_BLOCKS];
+  // +1: a clip rarely starts on a block boundary
+  uint32_t count = (samples + SampleRing::BLOCK - 1) / SampleRing::BLOCK + 1;
+  if (count > AudioClip::MAX_BLOCKS || !allocBlocks(blocks, count)) {
+    Serial.println("[MIC] clip alloc failed");
+    return false;
+  }
+  clip.attach(blocks, count);
+  return true;
+}
+
+bool MicSampler::begin(int micPin, int auxPin, uint32_t sampleRateHz, uint32_t ringSamples) {
+  uint32_t count = ringSamples / SampleRing::BLOCK;
+  if (count == 0 || (count & (count - 1)) || count > SampleRing::MAX_BLOCKS) return false;
+  micChan_ = digitalPinToAnalogChannel(micPin);
+  auxChan_ = auxPin >= 0 ? digitalPinToAnalogChannel(auxPin) : -1;
+  if (micChan_ < 0 || micChan_ >= SOC_ADC_CHANNEL_NUM(0)) return false;
+  if (auxChan_ >= SOC_ADC_CHANNEL_NUM(0)) auxChan_ = -1;
+  rate_ = sampleRateHz;
+
+  int16_t* blocks[SampleRing::MAX_BLOCKS];
+  if (!allocBlocks(blocks, count)) {
+    Serial.println("[MIC] ring alloc failed");
+    return false;
+  }
+  ring_.attach(blocks, count);
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = POOL_BYTES;
+  init.conv_num_each_intr = READ_BYTES;
+  init.adc1_chan_mask     = BIT(micChan_) | (auxChan_ >= 0 ? BIT(auxChan_) : 0);
+  if (adc_digi_initialize(&init) != ESP_OK) {
+    Serial.println("[MIC] adc_digi_initialize failed");
+    return false;
+  }
+
+  adc_digi_pattern_config_t pattern[2] = {};
+  uint32_t patternNum = 0;
+  int chans[2] = { micChan_, auxChan_ };
+  for (int c : chans) {
+    if (c < 0) continue;
+    pattern[patternNum].atten     = ADC_ATTEN_DB_11;
+    pattern[patternNum].channel   = c;
+    pattern[patternNum].unit      = 0;  // ADC1
+    pattern[patternNum].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    patternNum++;
+  }
+
+  adc_digi_configuration_t cfg = {};
+  cfg.conv_limit_en  = false;
+  cfg.pattern_num    = patternNum;
+  cfg.adc_pattern    = pattern;
+  cfg.sample_freq_hz = sampleRateHz * patternNum;
+  cfg.conv_mode      = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format         = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_digi_controller_configure(&cfg) != ESP_OK || adc_digi_start() != ESP_OK) {
+    Serial.println("[MIC] ADC continuous start failed");
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  xTaskCreatePinnedToCore(taskEntry, "mic", 4096, this, MIC_TASK_PRIO, nullptr, MIC_TASK_CORE);
+  Serial.printf("[MIC] sampling ch%d @ %u Hz, ring %u samples\n", micChan_, rate_, ringSamples);
+  return true;
+}
+
+MicSampler::Stats MicSampler::stats() const {
+  Stats s;
+  s.rateHz         = achieved_;
+  s.totalSamples   = total_;
+  s.droppedSamples = dropped_;
+  s.dmaOverflows   = overflows_;
+  return s;
+}
+
+void MicSampler::taskEntry(void* arg) {
+  static_cast<MicSampler*>(arg)->run();
+}
+
+void MicSampler::run() {
+  static uint8_t raw[READ_BYTES];
+  static int16_t pcm[CONV_PER_READ];
+  int64_t  windowStart = esp_timer_get_time();
+  uint32_t windowCount = 0;
+
+  for (;;) {
+    uint32_t len = 0;
+    esp_err_t err = adc_digi_read_bytes(raw, READ_BYTES, &len, ADC_MAX_DELAY);
+    if (err == ESP_ERR_INVALID_STATE) {
+      // pool overran; the driver hands back what it still has
+      overflows_++;
+    } else if (err != ESP_OK) {
+      continue;
+    }
+
+    uint32_t n = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      const adc_digi_output_data_t* d = (const adc_digi_output_data_t*)&raw[i];
+      if (d->type2.unit != 0) continue;
+      if (d->type2.channel == micChan_)      pcm[n++] = d->type2.data;
+      else if (d->type2.channel == auxChan_) aux_ = d->type2.data;
+    }
+    if (n) ring_.write(pcm, n);
+    total_      += n;
+    windowCount += n;
+
+    int64_t now = esp_timer_get_time();
+    if (now - windowStart >= 1000000) {
+      uint32_t expected = (uint32_t)((now - windowStart) * rate_ / 1000000);
+      achieved_ = (uint32_t)((int64_t)windowCount * 1000000 / (now - windowStart));
+      // tolerate the ADC clock divider's ~1 % rounding
+      if (windowCount + expected / 100 < expected) dropped_ += expected - windowCount;
+      windowStart = now;
+      windowCount = 0;
+    }
+  }
+}
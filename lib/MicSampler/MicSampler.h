@@ -0,0 +1,51 @@
+#pragma once
+// Fixed-rate microphone capture: the ADC digital controller DMAs the mic
+// pin (plus an optional slow auxiliary pin, e.g. the battery divider) and a
+// FreeRTOS task moves the mic samples into a SampleRing. Detectors read
+// frames from the ring through their own SampleReader, so blocking network
+// calls in loop() no longer leave holes in the audio.
+#include <Arduino.h>
+#include "SampleRing.h"
+
+class MicSampler {
+public:
+  struct Stats {
+    uint32_t rateHz;          // mic samples delivered over the last second
+    uint32_t totalSamples;    // mic samples delivered since begin()
+    uint32_t droppedSamples;  // expected minus delivered, accumulated
+    uint32_t dmaOverflows;    // reads that found the DMA pool overrun
+  };
+
+  // `ringSamples` must be a power-of-two number of SampleRing::BLOCKs; the
+  // ring is put in PSRAM when available. ADC1 pins only. Pass auxPin = -1
+  // to sample the mic alone.
+  bool begin(int micPin, int auxPin, uint32_t sampleRateHz, uint32_t ringSamples);
+
+  // Give `clip` spare blocks for up to `samples` of audio. Boot time only:
+  // freezing a clip later swaps blocks and never allocates.
+  bool allocClip(AudioClip& clip, uint32_t samples);
+  // Freeze ring positions [start, end) into `clip` once `end` is sampled.
+  bool freezeClip(AudioClip& clip, uint32_t start, uint32_t end) { return ring_.freeze(clip, start, end); }
+
+  const SampleRing& ring() const { return ring_; }
+  uint32_t sampleRate()    const { return rate_; }
+  int      latest()        const { return ring_.latest(); }
+  // The aux pin shares the conversion pattern, so analogRead() on ADC1
+  // would fight the DMA controller; read its last value from here instead.
+  int      auxRaw()        const { return aux_; }
+  Stats    stats()         const;
+
+private:
+  static void taskEntry(void* arg);
+  void run();
+
+  SampleRing        ring_;
+  uint32_t          rate_     = 0;
+  int               micChan_  = -1;
+  int               auxChan_  = -1;
+  volatile int      aux_      = 0;
+  volatile uint32_t achieved_ = 0;
+  volatile uint32_t total_    = 0;
+  volatile uint32_t dropped_  = 0;
+  volatile uint32_t overflows_= 0;
+};
@@ -0,0 +1,224 @@
+#pragma once
+// Lock-free single-producer / multi-reader ring of 16-bit audio samples.
+//
+// The producer (the mic sampling task) only ever advances `head`, a free
+// running sample counter. Every consumer owns a SampleReader with its own
+// cursor, so a slow consumer loses its own backlog without holding up the
+// producer or the other readers.
+//
+// Storage is a table of fixed-size blocks rather than one array, so a span
+// of history can be frozen into an AudioClip by swapping block pointers
+// with the clip's spare blocks: no samples are copied and nothing is
+// allocated after boot. No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+
+class SampleRing;
+
+// A frozen span of mic audio (pre-roll + post-roll around a detection).
+// Owns spare blocks from boot; freezing trades them for the ring's blocks.
+class AudioClip {
+public:
+  static const uint32_t MAX_BLOCKS = 32;
+  enum State : uint8_t { EMPTY, PENDING, READY, READING };
+
+  // `spare` holds `count` blocks of SampleRing::BLOCK samples.
+  void attach(int16_t* const* spare, uint32_t count) {
+    blocks_ = count < MAX_BLOCKS ? count : MAX_BLOCKS;
+    for (uint32_t i = 0; i < blocks_; i++) block_[i] = spare[i];
+  }
+
+  State    state()    const { return (State)state_.load(std::memory_order_acquire); }
+  uint32_t capacity() const;                  // longest clip, in samples
+  uint32_t length()   const { return end_ - start_; }
+  uint32_t start()    const { return start_; }  // absolute ring positions
+  uint32_t end()      const { return end_; }
+  uint32_t seq()      const { return seq_; }    // bumps on every new clip
+
+  // Pin a READY clip while it is streamed; a pinned clip is never reused.
+  bool beginRead() {
+    uint8_t s = READY;
+    return state_.compare_exchange_strong(s, READING, std::memory_order_acq_rel);
+  }
+  void endRead() { state_.store(READY, std::memory_order_release); }
+
+  // Copy up to `n` samples starting `offset` samples into the clip. Only
+  // between beginRead() and endRead(), or a new freeze may swap blocks.
+  uint32_t read(uint32_t offset, int16_t* dst, uint32_t n) const;
+
+private:
+  friend class SampleRing;
+  int16_t*             block_[MAX_BLOCKS] = {};
+  uint32_t             blocks_     = 0;
+  uint32_t             firstBlock_ = 0;
+  uint32_t             start_ = 0, end_ = 0;
+  uint32_t             seq_   = 0;
+  std::atomic<uint8_t> state_{EMPTY};
+};
+
+class SampleRing {
+public:
+  static const uint32_t BLOCK      = 4096;  // samples per block (512 ms at 8 kHz)
+  static const uint32_t MAX_BLOCKS = 64;
+
+  // `blocks` holds `count` blocks of BLOCK samples; count must be a power
+  // of two no larger than MAX_BLOCKS.
+  void attach(int16_t* const* blocks, uint32_t count) {
+    count_ = count;
+    for (uint32_t i = 0; i < count; i++) table_[i].store(blocks[i], std::memory_order_relaxed);
+    floor_.store(0, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_release);
+  }
+
+  uint32_t capacity() const { return count_ * BLOCK; }
+  bool     attached() const { return count_ != 0; }
+
+  // Absolute position one past the newest sample.
+  uint32_t head() const { return head_.load(std::memory_order_acquire); }
+
+  // Producer only.
+  void write(const int16_t* src, uint32_t n) {
+    uint32_t h = head_.load(std::memory_order_relaxed);
+    while (n) {
+      uint32_t off = h % BLOCK;
+      if (off == 0) serviceFreeze(h);
+      uint32_t len = n < BLOCK - off ? n : BLOCK - off;
+      memcpy(slot(h / BLOCK) + off, src, len * sizeof(int16_t));
+      src += len; n -= len; h += len;
+      head_.store(h, std::memory_order_release);
+    }
+  }
+
+  // Copy samples [pos, pos+n) out of the ring. Returns false if any of them
+  // had already been (or was being) overwritten or frozen into a clip.
+  bool copy(uint32_t pos, int16_t* dst, uint32_t n) const {
+    if (!valid(pos)) return false;
+    for (uint32_t p = pos; p != pos + n; ) {
+      uint32_t off = p % BLOCK;
+      uint32_t len = pos + n - p < BLOCK - off ? pos + n - p : BLOCK - off;
+      memcpy(dst, slot(p / BLOCK) + off, len * sizeof(int16_t));
+      dst += len; p += len;
+    }
+    // the producer may have lapped us, or swapped a block, while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return valid(pos);
+  }
+
+  // Where a lapped reader should resume: half a ring behind the head, or
+  // just past the last frozen clip if that is later.
+  uint32_t resumePoint() const {
+    uint32_t h = head();
+    uint32_t r = h > capacity() / 2 ? h - capacity() / 2 : 0;
+    uint32_t f = floor_.load(std::memory_order_relaxed);
+    return (int32_t)(f - r) > 0 ? f : r;
+  }
+
+  int16_t latest() const {
+    uint32_t h = head();
+    return h ? slot((h - 1) / BLOCK)[(h - 1) % BLOCK] : 0;
+  }
+
+  // Ask the producer to freeze [start, end) into `clip` once `end` has been
+  // written. Fails if another freeze is pending, the clip is pinned, the
+  // span is longer than the clip or its start already left the ring.
+  bool freeze(AudioClip& clip, uint32_t start, uint32_t end) {
+    uint32_t first = start / BLOCK, last = (end - 1) / BLOCK;
+    if (last - first + 1 > clip.blocks_ || last - first + 1 > count_) return false;
+    if (head() - start > capacity() - BLOCK) return false;
+    uint8_t s = clip.state_.load(std::memory_order_acquire);
+    if (s == AudioClip::PENDING || s == AudioClip::READING) return false;
+    if (!clip.state_.compare_exchange_strong(s, AudioClip::PENDING)) return false;
+    clip.firstBlock_ = first;
+    clip.start_      = start;
+    clip.end_        = end;
+    AudioClip* none = nullptr;
+    if (!pending_.compare_exchange_strong(none, &clip, std::memory_order_release)) {
+      clip.state_.store(AudioClip::EMPTY, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  int16_t* slot(uint32_t block) const {
+    return table_[block & (count_ - 1)].load(std::memory_order_relaxed);
+  }
+
+  bool valid(uint32_t pos) const {
+    return head() - pos <= capacity()
+        && (int32_t)(pos - floor_.load(std::memory_order_relaxed)) >= 0;
+  }
+
+  // Runs on the producer at every block boundary: once the pending clip's
+  // last block is complete, trade its blocks for the clip's spares.
+  void serviceFreeze(uint32_t h) {
+    AudioClip* clip = pending_.load(std::memory_order_acquire);
+    if (!clip || (int32_t)(h - clip->end_) < 0) return;
+    uint32_t n = (clip->end_ - 1) / BLOCK - clip->firstBlock_ + 1;
+    // readers must see the new floor before they can see a swapped block
+    floor_.store((clip->firstBlock_ + n) * BLOCK, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t i = 0; i < n; i++) {
+      std::atomic<int16_t*>& e = table_[(clip->firstBlock_ + i) & (count_ - 1)];
+      int16_t* mine = e.load(std::memory_order_relaxed);
+      e.store(clip->block_[i], std::memory_order_relaxed);
+      clip->block_[i] = mine;
+    }
+    clip->seq_++;
+    clip->state_.store(AudioClip::READY, std::memory_order_release);
+    pending_.store(nullptr, std::memory_order_release);
+  }
+
+  std::atomic<int16_t*>   table_[MAX_BLOCKS] = {};
+  uint32_t                count_ = 0;
+  std::atomic<uint32_t>   head_{0};
+  std::atomic<uint32_t>   floor_{0};  // positions below were frozen away
+  std::atomic<AudioClip*> pending_{nullptr};
+};
+
+inline uint32_t AudioClip::capacity() const { return blocks_ * SampleRing::BLOCK; }
+
+inline uint32_t AudioClip::read(uint32_t offset, int16_t* dst, uint32_t n) const {
+  if (offset >= length()) return 0;
+  if (n > length() - offset) n = length() - offset;
+  uint32_t p = start_ + offset, left = n;
+  while (left) {
+    uint32_t off = p % SampleRing::BLOCK;
+    uint32_t len = left < SampleRing::BLOCK - off ? left : SampleRing::BLOCK - off;
+    memcpy(dst, block_[p / SampleRing::BLOCK - firstBlock_] + off, len * sizeof(int16_t));
+    dst += len; p += len; left -= len;
+  }
+  return n;
+}
+
+// Per-consumer cursor into a SampleRing.
+class SampleReader {
+public:
+  void attach(const SampleRing& ring) { ring_ = &ring; skipToLatest(); }
+
+  void     skipToLatest()       { pos_ = ring_->head(); }
+  uint32_t position()  const    { return pos_; }
+  uint32_t available() const    { return ring_->head() - pos_; }
+  uint32_t overruns()  const    { return overruns_; }   // samples lost
+
+  // Read exactly `n` samples, or nothing if fewer are buffered. If the
+  // producer lapped this reader (or froze its backlog into a clip), the
+  // lost span is counted in overruns() and reading resumes further on.
+  bool readFrame(int16_t* dst, uint32_t n) {
+    for (;;) {
+      uint32_t avail = available();
+      if (avail < n) return false;
+      if (ring_->copy(pos_, dst, n)) { pos_ += n; return true; }
+      uint32_t resume = ring_->resumePoint();
+      overruns_ += resume - pos_;
+      pos_       = resume;
+    }
+  }
+
+private:
+  const SampleRing* ring_     = nullptr;
+  uint32_t          pos_      = 0;
+  uint32_t          overruns_ = 0;
+};
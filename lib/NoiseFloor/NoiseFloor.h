@@ -0,0 +1,82 @@
+#pragma once
+// Streaming noise-floor estimate: a running low percentile of a level
+// signal (frame energy, sample deviation, ...), tracked with the "frugal"
+// quantile update. Each update nudges the estimate up by p% or down by
+// (100-p)% of a step proportional to the estimate itself, so it settles
+// where p% of the input lies below it, for any input scale, in O(1) memory.
+// Short loud events (cries, door slams) barely move a low percentile; a fan
+// or humidifier that runs for minutes becomes the new floor.
+//
+// DcTracker follows the signal's DC offset (the mic's ADC bias) the levels
+// are measured from.
+//
+// No Arduino dependency: builds on the host. state()/restore() let the
+// firmware keep the estimate across reboots.
+#include <stdint.h>
+
+// Running mean, an exponential average over ~2^shift inputs. It is kept in
+// Q8: the integer form `dc += (v - dc) / 2^shift` stops moving once the
+// error is under 2^shift counts, leaving that much bias in every level
+// measured from it.
+class DcTracker {
+public:
+  explicit DcTracker(uint8_t shift = 6, int initial = 2048) : shift_(shift) { restore(initial); }
+
+  // Returns the updated estimate, rounded.
+  int update(int32_t v) {
+    q8_ += (v * 256 - q8_) >> shift_;   // the shift floors: within 1/256 count
+    return value();
+  }
+
+  int  value() const       { return (q8_ + 128) >> 8; }
+  void restore(int dc)     { q8_ = (int32_t)dc << 8; }
+
+private:
+  uint8_t shift_;
+  int32_t q8_;
+};
+
+class NoiseFloor {
+public:
+  // `percentile` in 1..99; `rateShift` sets the step to estimate/2^rateShift
+  // per update (7 ≈ 0.8 %, i.e. tens of seconds to track a new room at 30 Hz).
+  void begin(uint8_t percentile = 20, uint8_t rateShift = 7, uint32_t initial = 0) {
+    pct_     = percentile;
+    shift_   = rateShift;
+    q8_      = (uint64_t)initial << 8;
+    updates_ = 0;
+  }
+
+  void update(uint32_t level) {
+    uint64_t x8   = (uint64_t)level << 8;
+    uint64_t step = q8_ >> shift_;
+    if (step < 256) step = 256;
+    if (x8 > q8_) {
+      q8_ += step * pct_ / 100;
+    } else if (x8 < q8_) {
+      uint64_t down = step * (100 - pct_) / 100;
+      q8_ = q8_ > down ? q8_ - down : 0;
+      if (q8_ < x8) q8_ = x8;
+    }
+    if (updates_ < UINT32_MAX) updates_++;
+  }
+
+  uint32_t floor()   const { return (uint32_t)(q8_ >> 8); }
+  uint32_t updates() const { return updates_; }
+
+  // floor * gain, but never below `minimum`
+  uint32_t threshold(uint32_t gain, uint32_t minimum) const {
+    uint64_t t = (uint64_t)floor() * gain;
+    if (t > UINT32_MAX) t = UINT32_MAX;
+    return t < minimum ? minimum : (uint32_t)t;
+  }
+
+  uint32_t state() const        { return floor(); }
+  void     restore(uint32_t s)  { q8_ = (uint64_t)s << 8; }
+
+private:
+  uint8_t  pct_     = 20;
+  uint8_t  shift_   = 7;
+  uint64_t q8_      = 0;   // estimate, Q8
+  uint32_t updates_ = 0;
+};
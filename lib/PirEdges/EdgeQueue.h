@@ -0,0 +1,57 @@
+#pragma once
+// Single-producer/single-consumer queue of timestamped PIR edges. The GPIO
+// ISR pushes, loop() pops; neither side locks or blocks. When loop() falls
+// more than SIZE edges behind, new edges are dropped and counted, so the
+// consumer can tell an exact edge count from a lossy one.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <atomic>
+
+struct PirEdge {
+  int64_t us;    // esp_timer time of the edge (µs since boot)
+  bool    high;  // level after the edge: true = rise
+
+  // Same clock as millis().
+  uint32_t ms() const { return (uint32_t)(us / 1000); }
+};
+
+class EdgeQueue {
+public:
+  static const uint32_t SIZE = 64;  // power of two
+
+  // Producer side (ISR). False, and one more overflow, when full. Always
+  // inlined, so the caller's IRAM placement covers it.
+  __attribute__((always_inline)) bool push(const PirEdge& e) {
+    uint32_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) >= SIZE) {
+      overflows_.store(overflows_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    buf_[h & (SIZE - 1)] = e;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side (loop).
+  bool pop(PirEdge& e) {
+    uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    e = buf_[t & (SIZE - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: drop whatever is queued.
+  void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+  uint32_t size()      const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed); }
+  uint32_t pushed()    const { return head_.load(std::memory_order_relaxed); }
+  uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+  PirEdge               buf_[SIZE];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> overflows_{0};
+};
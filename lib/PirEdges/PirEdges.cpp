@@ -0,0 +1,46 @@
+#include "PirEdges.h"
+#include "hal/gpio_ll.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+void PirEdges::begin(int pin) {
+  pin_   = pin;
+  level_ = digitalRead(pin);
+  attachInterruptArg(digitalPinToInterrupt(pin), isr, this, CHANGE);
+  Serial.printf("[PIR] edge capture on GPIO%d, level %d\n", pin, (int)level_);
+}
+
+void IRAM_ATTR PirEdges::isr(void* arg) {
+  uint32_t start = esp_cpu_get_ccount();
+  int64_t  now   = esp_timer_get_time();
+  PirEdges* self = static_cast<PirEdges*>(arg);
+  // the ISR must stay in IRAM (it runs during flash writes): no gpio_get_level()
+  bool high = gpio_ll_get_level(&GPIO, (gpio_num_t)self->pin_);
+  if (high == self->level_) {
+    self->glitches_ = self->glitches_ + 1;
+  } else {
+    // after an overflow the queue may hold two rises in a row
+    self->queue_.push({ now, high });
+    self->level_ = high;
+  }
+  uint32_t cycles = esp_cpu_get_ccount() - start;
+  if (cycles > self->isrMaxCycles_) self->isrMaxCycles_ = cycles;
+}
+
+bool PirEdges::pop(PirEdge& e) {
+  if (!queue_.pop(e)) return false;
+  lastLatencyUs_ = (uint32_t)(esp_timer_get_time() - e.us);
+  if (lastLatencyUs_ > maxLatencyUs_) maxLatencyUs_ = lastLatencyUs_;
+  return true;
+}
+
+PirEdges::Stats PirEdges::stats() const {
+  Stats s;
+  s.edges         = queue_.pushed();
+  s.overflows     = queue_.overflows();
+  s.glitches      = glitches_;
+  s.isrMaxCycles  = isrMaxCycles_;
+  s.maxLatencyUs  = maxLatencyUs_;
+  s.lastLatencyUs = lastLatencyUs_;
+  return s;
+}
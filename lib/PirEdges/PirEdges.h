@@ -0,0 +1,45 @@
+#pragma once
+// Interrupt-driven PIR capture: a CHANGE interrupt on the sensor pin
+// timestamps every rise and fall with esp_timer and queues it, so the
+// motion logic sees exact edges with their real times even when loop() was
+// stuck in an HTTPS call or mp3->loop() for seconds.
+//
+// A pulse shorter than the interrupt response collapses into one pending
+// interrupt; the ISR then reads the level it already queued, drops the
+// event and counts a glitch, so queued edges alternate unless the queue
+// overflowed.
+#include <Arduino.h>
+#include "EdgeQueue.h"
+
+class PirEdges {
+public:
+  struct Stats {
+    uint32_t edges;          // edges queued since begin()
+    uint32_t overflows;      // edges dropped on a full queue
+    uint32_t glitches;       // pulses too short to see both edges
+    uint32_t isrMaxCycles;   // longest ISR run, CPU cycles
+    uint32_t maxLatencyUs;   // longest edge -> motion logic delay
+    uint32_t lastLatencyUs;
+  };
+
+  void begin(int pin);
+
+  // Next edge in time order; false when none is pending.
+  bool pop(PirEdge& e);
+  // Drop pending edges (the motion logic is not listening).
+  void clear() { queue_.clear(); }
+  // Level after the newest captured edge.
+  bool level() const { return level_; }
+  Stats stats() const;
+
+private:
+  static void IRAM_ATTR isr(void* arg);
+
+  EdgeQueue         queue_;
+  int               pin_          = -1;
+  volatile bool     level_        = false;
+  volatile uint32_t glitches_     = 0;
+  volatile uint32_t isrMaxCycles_ = 0;
+  uint32_t          maxLatencyUs_ = 0;
+  uint32_t          lastLatencyUs_= 0;
+};
@@ -0,0 +1,168 @@
+#include "SleepLog.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const uint32_t MAGIC = 0x534C4F47;  // "SLOG"
+static const uint32_t DAY_S = 86400;
+
+// CRC-32 (IEEE), bitwise: the store is a few hundred bytes
+static uint32_t crc32(const void* data, size_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFF;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+static uint32_t storeCrc(const SleepLog::Store* s) {
+  return crc32(s, offsetof(SleepLog::Store, crc));
+}
+
+bool SleepLog::begin(Store* store, uint32_t now, uint16_t closeMin) {
+  store_    = store;
+  closeMin_ = closeMin % (24 * 60);
+  if (store->magic == MAGIC && store->crc == storeCrc(store)) {
+    if (store->night.resets < UINT8_MAX) store->night.resets++;
+    seal();
+    return true;
+  }
+  memset(store, 0, sizeof(*store));
+  store->magic = MAGIC;
+  open(now, false);
+  return false;
+}
+
+void SleepLog::open(uint32_t now, bool awake) {
+  Night& n = store_->night;
+  memset(&n, 0, sizeof(n));
+  n.start = now;
+  n.since = now;
+  n.awake = awake;
+  seal();
+}
+
+// Book the time since the last transition to the state it was spent in.
+void SleepLog::settle(uint32_t now) {
+  Night& n = store_->night;
+  if (now < n.since) now = n.since;  // the clock was stepped back
+  uint32_t d = now - n.since;
+  if (n.awake) {
+    n.awakeS += d;
+  } else if (d) {
+    n.sleepS += d;
+    if (d > n.longestSleepS) n.longestSleepS = d;
+    if (n.sessionCount < MAX_SESSIONS) {
+      Session& s = n.sessions[n.sessionCount];
+      s.startMin = (uint16_t)((n.since - n.start) / 60);
+      s.minutes  = (uint16_t)((d + 30) / 60);
+    }
+    if (n.sessionCount < UINT16_MAX) n.sessionCount++;
+  }
+  n.since = now;
+}
+
+void SleepLog::awake(uint32_t now) {
+  if (!store_ || store_->night.awake) return;
+  settle(now);
+  store_->night.awake = 1;
+  store_->night.wakes++;
+  seal();
+}
+
+void SleepLog::asleep(uint32_t now) {
+  if (!store_ || !store_->night.awake) return;
+  settle(now);
+  store_->night.awake = 0;
+  seal();
+}
+
+void SleepLog::cry(uint32_t cryMs) {
+  if (!store_) return;
+  Night& n = store_->night;
+  n.cries++;
+  n.cryMs += cryMs;
+  if (cryMs > n.longestCryMs) n.longestCryMs = cryMs;
+  seal();
+}
+
+void SleepLog::lullaby() {
+  if (!store_) return;
+  store_->night.lullabies++;
+  seal();
+}
+
+void SleepLog::escalation() {
+  if (!store_) return;
+  store_->night.escalations++;
+  seal();
+}
+
+// First close time after `start`.
+uint32_t SleepLog::closeAt(uint32_t start) const {
+  uint32_t t = start - start % DAY_S + closeMin_ * 60u;
+  return t > start ? t : t + DAY_S;
+}
+
+bool SleepLog::poll(uint32_t now) {
+  if (!store_) return false;
+  bool closed = false;
+  // a night with the device off for days closes once per missed close
+  for (uint32_t end; now >= (end = closeAt(store_->night.start)); ) {
+    settle(end);
+    store_->night.end = end;
+    if (store_->pending.start) store_->lost++;
+    store_->pending = store_->night;
+    open(end, store_->pending.awake);
+    closed = true;
+  }
+  return closed;
+}
+
+void SleepLog::sent() {
+  if (!store_) return;
+  store_->pending.start = 0;
+  seal();
+}
+
+void SleepLog::seal() {
+  store_->crc = storeCrc(store_);
+}
+
+static void isoTime(uint32_t t, char iso[24]) {
+  time_t    tt = (time_t)t;
+  struct tm g;
+  gmtime_r(&tt, &g);
+  strftime(iso, 24, "%Y-%m-%dT%H:%M:%SZ", &g);
+}
+
+size_t SleepLog::writeJson(char* buf, size_t len, const Night& n) {
+  char start[24], end[24];
+  isoTime(n.start, start);
+  isoTime(n.end, end);
+  size_t pos = 0;
+  int w = snprintf(buf, len,
+                   "{\"start\":\"%s\",\"end\":\"%s\",\"sleep_s\":%u,\"awake_s\":%u,"
+                   "\"longest_sleep_s\":%u,\"wakes\":%u,\"cries\":%u,\"cry_ms\":%u,"
+                   "\"longest_cry_ms\":%u,\"lullabies\":%u,\"escalations\":%u,\"resets\":%u,"
+                   "\"sessions\":[",
+                   start, end, (unsigned)n.sleepS, (unsigned)n.awakeS, (unsigned)n.longestSleepS,
+                   (unsigned)n.wakes, (unsigned)n.cries, (unsigned)n.cryMs,
+                   (unsigned)n.longestCryMs, (unsigned)n.lullabies, (unsigned)n.escalations,
+                   (unsigned)n.resets);
+  if (w < 0 || (size_t)w >= len) return 0;
+  pos += w;
+  // [start, length] in minutes from the start of the night
+  int kept = n.sessionCount < MAX_SESSIONS ? n.sessionCount : MAX_SESSIONS;
+  for (int i = 0; i < kept; i++) {
+    w = snprintf(buf + pos, len - pos, "%s[%u,%u]", i ? "," : "",
+                 (unsigned)n.sessions[i].startMin, (unsigned)n.sessions[i].minutes);
+    if (w < 0 || (size_t)w >= len - pos) return 0;
+    pos += w;
+  }
+  w = snprintf(buf + pos, len - pos, "],\"sessions_dropped\":%u}", (unsigned)(n.sessionCount - kept));
+  if (w < 0 || (size_t)w >= len - pos) return 0;
+  return pos + w;
+}
@@ -0,0 +1,88 @@
+#pragma once
+// The night's sleep, kept on the device and sent as one summary.
+//
+// Instead of pushing every sleep/awake transition to the cloud, the device
+// keeps a compact record of each night: the sleep sessions (start and
+// length, in minutes from the start of the night), how often and how long
+// the baby was awake, the confirmed cries and how long each lasted, and
+// how many lullabies and escalations they took. A night runs from one
+// close time (a fixed UTC minute of the day) to the next; when it closes
+// it is set aside as the pending summary for upload and a new night
+// starts in the state the baby is in.
+//
+// Everything lives in one Store with a magic and a CRC, meant for memory
+// that survives a reset (RTC_NOINIT on the ESP32): a crash or brown-out
+// restart mid-night resumes the night, a power cycle starts a fresh one.
+// Times are UTC seconds, supplied by the caller.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+class SleepLog {
+public:
+  static const int MAX_SESSIONS = 16;
+
+  struct Session {
+    uint16_t startMin;  // from the start of the night
+    uint16_t minutes;
+  };
+
+  struct Night {
+    uint32_t start, end;        // UTC s; end 0 while open
+    uint32_t sleepS, awakeS;
+    uint32_t longestSleepS;
+    uint32_t cryMs, longestCryMs;
+    uint16_t wakes;             // asleep -> awake transitions
+    uint16_t cries;             // confirmed cries
+    uint16_t lullabies, escalations;
+    uint16_t sessionCount;      // sleep sessions, also those past MAX_SESSIONS
+    uint8_t  resets;            // restarts the night survived
+    uint8_t  awake;             // state at `since`
+    uint32_t since;             // last transition, or the start
+    Session  sessions[MAX_SESSIONS];
+  };
+
+  struct Store {
+    uint32_t magic;
+    Night    night;
+    Night    pending;           // closed, not yet uploaded; start 0 when none
+    uint16_t lost;              // closed nights overwritten before upload
+    uint32_t crc;
+  };
+
+  // Adopt `store`, resuming its night if it checks out, else starting one
+  // at `now` with the baby asleep. Nights close at `closeMin` past UTC
+  // midnight. True when a night was resumed.
+  bool begin(Store* store, uint32_t now, uint16_t closeMin = 8 * 60);
+
+  void awake(uint32_t now);
+  void asleep(uint32_t now);
+  void cry(uint32_t cryMs);   // a confirmed cry and its cry-like length
+  void lullaby();
+  void escalation();
+
+  // Close the night once `now` has passed its close time. True when a
+  // summary became pending.
+  bool poll(uint32_t now);
+
+  bool         pending()     const { return store_ && store_->pending.start; }
+  const Night& night()       const { return store_->night; }
+  const Night& pendingNight() const { return store_->pending; }
+  uint16_t     lost()        const { return store_ ? store_->lost : 0; }
+  // The pending summary was delivered.
+  void         sent();
+
+  // A night as JSON, the document uploaded. Returns the length written,
+  // 0 if `len` was too small.
+  static size_t writeJson(char* buf, size_t len, const Night& n);
+
+private:
+  void     open(uint32_t now, bool awake);
+  void     settle(uint32_t now);
+  uint32_t closeAt(uint32_t start) const;
+  void     seal();
+
+  Store*   store_    = nullptr;
+  uint16_t closeMin_ = 8 * 60;
+};
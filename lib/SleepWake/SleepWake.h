@@ -0,0 +1,142 @@
+#pragma once
+// The nursery's sleep/wake decisions as one table-driven state machine,
+// shared by both firmwares and the host tools.
+//
+//   ASLEEP    --rise-->    STIRRING            PIR starts reporting
+//   STIRRING  --still-->   ASLEEP              evidence lapsed
+//   STIRRING  --motion-->  LISTENING  WOKE     held high, or enough rises
+//   LISTENING --cry-->     ASLEEP     SOOTHE   (ESCALATE past MAX_LULLABIES)
+//   LISTENING --timeout--> ASLEEP     SETTLED  window ran out quietly
+//
+// Inputs are injected with their own timestamps: pir() takes levels or
+// edges, cry() takes a per-step verdict (a detector's, or a raw "loud"
+// flag that must hold for CRY_MS). Guards turn those into the events
+// above; only TABLE moves the state. Timings come from the `T` parameter,
+// a struct of static members:
+//
+//   HOLD_MS             PIR continuously high this long is motion (0: off)
+//   RISES               this many rises...
+//   RISE_WINDOW_MS      ...within this long is motion (RISES = 0: off)
+//   LISTEN_MS           cry window after motion (0: until a cry)
+//   CRY_MS              cry input held continuously this long (0: at once)
+//   MAX_LULLABIES       soothing attempts before escalating
+//   DEAF_WHILE_PLAYING  ignore cry input while the lullaby plays
+//
+// Firmware passes static const members, so every timing folds into the
+// code; the host tools may pass non-const statics to sweep them.
+//
+// No Arduino dependency: header-only, builds on the host.
+#include <stdint.h>
+
+template <class T>
+class SleepWake {
+public:
+  enum State  : uint8_t { ASLEEP, STIRRING, LISTENING, N_STATES };
+  enum Event  : uint8_t { RISE, STILL, MOTION, CRY, TIMEOUT, N_EVENTS };
+  enum Action : uint8_t { NONE, WOKE, SOOTHE, ESCALATE, SETTLED };
+
+  struct Transition {
+    State  from;
+    Event  event;
+    State  to;
+    Action action;
+  };
+
+  static constexpr Transition TABLE[] = {
+    { ASLEEP,    RISE,    STIRRING,  NONE    },
+    { STIRRING,  STILL,   ASLEEP,    NONE    },
+    { STIRRING,  MOTION,  LISTENING, WOKE    },
+    { LISTENING, CRY,     ASLEEP,    SOOTHE  },
+    { LISTENING, TIMEOUT, ASLEEP,    SETTLED },
+  };
+
+  // Back to ASLEEP with no lullabies played (device switched off).
+  void reset() {
+    state_     = ASLEEP;
+    pirHigh_   = false;
+    cryOn_     = false;
+    rises_     = 0;
+    lullabies_ = 0;
+  }
+
+  // A PIR level sample or edge at `nowMs`. Returns WOKE when it completes
+  // the motion evidence, else NONE.
+  Action pir(bool high, uint32_t nowMs) {
+    if (state_ == LISTENING) return NONE;
+    bool rose = high && !pirHigh_;
+    // a fall that ends a long enough high still counts: with queued edges
+    // the rise and fall can arrive together after a blocked loop()
+    bool held = T::HOLD_MS && pirHigh_ && nowMs - highSince_ >= T::HOLD_MS;
+    if (rose) highSince_ = nowMs;
+    pirHigh_ = high;
+
+    if (rose) fire(RISE, nowMs);
+    if (state_ != STIRRING) return NONE;
+    if (rose && T::RISES) {
+      if (!rises_ || nowMs - riseSince_ > T::RISE_WINDOW_MS) {
+        riseSince_ = nowMs;
+        rises_     = 0;
+      }
+      rises_++;
+    }
+    if (T::HOLD_MS && high && nowMs - highSince_ >= T::HOLD_MS) held = true;
+    if (held || (T::RISES && rises_ >= T::RISES)) return fire(MOTION, nowMs);
+    bool counting = T::RISES && rises_ && nowMs - riseSince_ <= T::RISE_WINDOW_MS;
+    if (!high && !counting) fire(STILL, nowMs);
+    return NONE;
+  }
+
+  // The cry verdict for the audio at `nowMs`, while listening. Returns
+  // SOOTHE/ESCALATE on a cry, SETTLED when the window runs out, else NONE.
+  Action cry(bool heard, uint32_t nowMs, bool playing = false) {
+    if (state_ != LISTENING) return NONE;
+    if (playing && T::DEAF_WHILE_PLAYING) heard = false;
+    if (heard && !cryOn_) cryStart_ = nowMs;
+    cryOn_ = heard;
+    if (heard && nowMs - cryStart_ >= T::CRY_MS) return fire(CRY, nowMs);
+    if (T::LISTEN_MS && nowMs - since_ >= T::LISTEN_MS) return fire(TIMEOUT, nowMs);
+    return NONE;
+  }
+
+  // Both inputs sampled at one instant (polling firmware, simulation).
+  Action step(uint32_t nowMs, bool pirHigh, bool heard, bool playing = false) {
+    Action a = pir(pirHigh, nowMs);
+    return a != NONE ? a : cry(heard, nowMs, playing);
+  }
+
+  State    state()     const { return state_; }
+  bool     listening() const { return state_ == LISTENING; }
+  // When the current state was entered.
+  uint32_t since()     const { return since_; }
+  int      lullabies() const { return lullabies_; }
+
+private:
+  Action fire(Event e, uint32_t nowMs) {
+    for (const Transition& t : TABLE) {
+      if (t.from != state_ || t.event != e) continue;
+      state_ = t.to;
+      since_ = nowMs;
+      if (state_ == ASLEEP) {
+        // a PIR still high now is fresh evidence at its next sample
+        pirHigh_ = false;
+        cryOn_   = false;
+        rises_   = 0;
+      }
+      if (t.action != SOOTHE) return t.action;
+      if (lullabies_ >= T::MAX_LULLABIES) return ESCALATE;
+      lullabies_++;
+      return SOOTHE;
+    }
+    return NONE;
+  }
+
+  State    state_     = ASLEEP;
+  bool     pirHigh_   = false;
+  bool     cryOn_     = false;
+  uint8_t  rises_     = 0;
+  int      lullabies_ = 0;
+  uint32_t since_     = 0;
+  uint32_t highSince_ = 0;
+  uint32_t riseSince_ = 0;
+  uint32_t cryStart_  = 0;
+};
@@ -0,0 +1,214 @@
+#include "SoundMeter.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Block layout: seq u32 | count u16 | leq i16 | peak i16 | deltas...
+static const size_t HEADER     = 10;
+static const size_t MAX_RECORD = 6;  // two 3-byte varints
+
+static void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+static uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+static size_t putDelta(uint8_t* p, int32_t d) {
+  uint32_t z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+  size_t n = 0;
+  do {
+    p[n++] = (uint8_t)((z & 0x7F) | (z > 0x7F ? 0x80 : 0));
+    z >>= 7;
+  } while (z);
+  return n;
+}
+
+static int32_t getDelta(const uint8_t*& p) {
+  uint32_t z = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t b = *p++;
+    z |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+int32_t SoundMeter::log2q8(uint64_t v) {
+  int e = 63 - __builtin_clzll(v);
+  uint32_t m = e >= 8 ? (uint32_t)(v >> (e - 8)) & 0xFF : (uint32_t)(v << (8 - e)) & 0xFF;
+  // log2(1 + m) ~= m + 0.34 m (1 - m)
+  return e * 256 + (int32_t)(m + ((m * (256 - m) * 87) >> 16));
+}
+
+// Q8 log2 of a power ratio -> dB x4: 4 * 10 * log10(2) / 256 ~= 3083 / 65536
+static int16_t toDb4(int32_t log2Ratio) {
+  int32_t db4 = (int32_t)(((int64_t)log2Ratio * 3083 + 0x8000) >> 16);
+  return (int16_t)(db4 < -32767 ? -32767 : db4 > 32767 ? 32767 : db4);
+}
+
+void SoundMeter::begin(uint8_t* storage, size_t bytes, uint32_t samplesPerSecond, int fullScale) {
+  store_   = storage;
+  blocks_  = (uint32_t)(bytes / BLOCK);
+  head_    = tail_ = 0;
+  fill_    = 0;
+  perSec_  = samplesPerSecond;
+  fsLog_   = log2q8((uint64_t)fullScale * fullScale);
+  sumSq_   = 0;
+  count_   = 0;
+  peak_    = 0;
+  started_ = false;
+  seq_     = 0;
+  last_    = { 0, MISSING, MISSING };
+}
+
+void SoundMeter::add(int x, int dc) {
+  int32_t d = x - dc;
+  uint32_t a = (uint32_t)(d < 0 ? -d : d);
+  sumSq_ += a * a;
+  if (a > peak_) peak_ = a;
+  if (++count_ == perSec_) close();
+}
+
+void SoundMeter::add(const int16_t* x, size_t n, int dc) {
+  for (size_t i = 0; i < n; i++) add(x[i], dc);
+}
+
+bool SoundMeter::poll(uint32_t nowMs) {
+  if (perSec_) return false;
+  if (!started_) {
+    started_    = true;
+    secStartMs_ = nowMs;
+    return false;
+  }
+  uint32_t secs = (nowMs - secStartMs_) / 1000;
+  if (!secs) return false;
+  secStartMs_ += secs * 1000;
+  // the running second keeps what it got; the whole seconds a stall
+  // skipped had no samples, so they are missing, not one long second
+  // or levels made up from the samples that come after
+  close();
+  while (--secs) append(MISSING, MISSING);
+  return true;
+}
+
+void SoundMeter::close() {
+  int16_t leq = MISSING, peak = MISSING;
+  if (count_) {
+    uint64_t ms = sumSq_ / count_;
+    leq  = ms    ? toDb4(log2q8(ms) - fsLog_)                       : toDb4(-fsLog_);
+    peak = peak_ ? toDb4(log2q8((uint64_t)peak_ * peak_) - fsLog_) : toDb4(-fsLog_);
+  }
+  sumSq_ = 0;
+  count_ = 0;
+  peak_  = 0;
+  append(leq, peak);
+}
+
+void SoundMeter::append(int16_t leq, int16_t peak) {
+  Record r = { seq_++, leq, peak };
+  if (!blocks_) {
+    last_ = r;
+    return;
+  }
+  uint8_t* b = block(head_);
+  if (fill_ == 0 || fill_ + MAX_RECORD > BLOCK) {
+    if (fill_) {
+      head_++;
+      if (head_ - tail_ >= blocks_) tail_++;  // drop the oldest block
+      b = block(head_);
+    }
+    put32(b, r.seq);
+    put16(b + 4, 1);
+    put16(b + 6, (uint16_t)r.leq);
+    put16(b + 8, (uint16_t)r.peak);
+    fill_ = HEADER;
+  } else {
+    fill_ += putDelta(b + fill_, r.leq - last_.leq);
+    fill_ += putDelta(b + fill_, r.peak - last_.peak);
+    put16(b + 4, get16(b + 4) + 1);
+  }
+  last_ = r;
+}
+
+uint32_t SoundMeter::oldest() const {
+  return (blocks_ && fill_) ? get32(block(tail_)) : seq_;
+}
+
+size_t SoundMeter::read(uint32_t from, Record* out, size_t max) const {
+  if (!blocks_ || !fill_) return 0;
+  size_t n = 0;
+  for (uint32_t i = tail_; i <= head_ && n < max; i++) {
+    const uint8_t* b = block(i);
+    uint32_t seq   = get32(b);
+    uint16_t count = get16(b + 4);
+    if (seq + count <= from) continue;
+    Record r = { seq, (int16_t)get16(b + 6), (int16_t)get16(b + 8) };
+    const uint8_t* p = b + HEADER;
+    for (uint16_t k = 0; k < count && n < max; k++) {
+      if (k) {
+        r.seq++;
+        r.leq  = (int16_t)(r.leq + getDelta(p));
+        r.peak = (int16_t)(r.peak + getDelta(p));
+      }
+      if (r.seq >= from) out[n++] = r;
+    }
+  }
+  return n;
+}
+
+static int putLevel(char* p, size_t len, int16_t db4) {
+  if (db4 == SoundMeter::MISSING) return snprintf(p, len, "null");
+  int v = db4 < 0 ? -db4 : db4;
+  return snprintf(p, len, "%s%d.%02d", db4 < 0 ? "-" : "", v / 4, (v % 4) * 25);
+}
+
+size_t SoundMeter::writeJson(char* buf, size_t len, uint32_t from, size_t maxRecords) const {
+  Record recs[64];
+  size_t pos = 0, count = 0;
+  uint32_t first = from > oldest() ? from : oldest();
+  double energy = 0;
+  size_t heard = 0;
+  int w;
+
+  // two passes over the same records: levels, then peaks
+  for (int pass = 0; pass < 2; pass++) {
+    w = pass ? snprintf(buf + pos, len - pos, "],\"peak\":[")
+             : snprintf(buf + pos, len - pos, "{\"first\":%u,\"leq\":[", (unsigned)first);
+    if (w < 0 || (size_t)w >= len - pos) return 0;
+    pos += w;
+    uint32_t at = first;
+    size_t done = 0;
+    while (done < maxRecords) {
+      size_t want = maxRecords - done < 64 ? maxRecords - done : 64;
+      size_t n = read(at, recs, want);
+      if (!n) break;
+      for (size_t i = 0; i < n; i++) {
+        int16_t v = pass ? recs[i].peak : recs[i].leq;
+        if (done + i) {
+          if (pos + 1 >= len) return 0;
+          buf[pos++] = ',';
+        }
+        w = putLevel(buf + pos, len - pos, v);
+        if (w < 0 || (size_t)w >= len - pos) return 0;
+        pos += w;
+        // export path only: energy-average the batch into one Leq
+        if (!pass && v != MISSING) {
+          energy += pow(10.0, v / 40.0);
+          heard++;
+        }
+      }
+      done += n;
+      at = recs[n - 1].seq + 1;
+    }
+    count = done;
+  }
+  w = snprintf(buf + pos, len - pos, "],\"count\":%u,\"batchLeq\":", (unsigned)count);
+  if (w < 0 || (size_t)w >= len - pos) return 0;
+  pos += w;
+  w = heard ? putLevel(buf + pos, len - pos, (int16_t)lround(40.0 * log10(energy / heard)))
+            : snprintf(buf + pos, len - pos, "null");
+  if (w < 0 || (size_t)w + 2 > len - pos) return 0;
+  pos += w;
+  buf[pos++] = '}';
+  buf[pos]   = 0;
+  return pos;
+}
@@ -0,0 +1,77 @@
+#pragma once
+// Continuous sound-level meter.
+//
+// Every second of mic samples becomes one record: Leq (the energy-mean
+// level over that second, i.e. its RMS level) and peak, both in dBFS with
+// 0.25 dB steps, computed with integer sums and an integer log2. Records
+// are kept as a delta-encoded time series in a caller-supplied buffer:
+// fixed-size blocks, each opening with an absolute keyframe followed by
+// zigzag varint deltas, so a quiet night costs ~2 bytes a second and the
+// oldest block is simply dropped when the buffer is full. Readers pull
+// batches with read() or writeJson(), never one sample at a time.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+#include <stddef.h>
+
+class SoundMeter {
+public:
+  struct Record {
+    uint32_t seq;   // seconds since begin()
+    int16_t  leq;   // dBFS x4; MISSING if the second had no samples
+    int16_t  peak;  // dBFS x4
+  };
+  static const int16_t MISSING = INT16_MIN;
+  static const size_t  BLOCK   = 128;  // bytes; ~55 seconds of deltas
+
+  // `samplesPerSecond` > 0 closes seconds by sample count (a gap-free DMA
+  // stream); 0 closes them by poll() time instead (sparse or burst
+  // sampling). `fullScale` is the amplitude that reads 0 dBFS.
+  void begin(uint8_t* storage, size_t bytes, uint32_t samplesPerSecond = 0,
+             int fullScale = 2048);
+
+  // Raw ADC samples around `dc`.
+  void add(const int16_t* x, size_t n, int dc);
+  void add(int x, int dc);
+
+  // Time-closed mode: close the running second once 1000 ms have passed,
+  // and store the seconds a longer gap skipped as MISSING. True when
+  // records were stored.
+  bool poll(uint32_t nowMs);
+
+  uint32_t oldest() const;                  // first seq still stored
+  uint32_t next()   const { return seq_; }  // seq the running second will get
+  Record   last()   const { return last_; }
+
+  // Decode up to `max` records starting at `from` (or the oldest kept).
+  size_t read(uint32_t from, Record* out, size_t max) const;
+
+  // One batch as JSON: {"first":..,"count":..,"leq":[..],"peak":[..],
+  // "batchLeq":..}; levels in dBFS, missing seconds as null. Returns the
+  // length written, 0 if `len` was too small.
+  size_t writeJson(char* buf, size_t len, uint32_t from, size_t maxRecords) const;
+
+  // log2(v) in Q8, ~0.01 error; v > 0
+  static int32_t log2q8(uint64_t v);
+
+private:
+  void close();
+  void append(int16_t leq, int16_t peak);
+  uint8_t* block(uint32_t i) const { return store_ + (size_t)(i % blocks_) * BLOCK; }
+
+  uint8_t* store_  = nullptr;
+  uint32_t blocks_ = 0;
+  uint32_t head_   = 0;   // block being written (absolute index)
+  uint32_t tail_   = 0;   // oldest block kept
+  size_t   fill_   = 0;   // bytes used in the head block
+  uint32_t perSec_ = 0;
+  int32_t  fsLog_  = 0;   // log2q8(fullScale^2)
+
+  uint64_t sumSq_  = 0;
+  uint32_t count_  = 0;
+  uint32_t peak_   = 0;
+  uint32_t secStartMs_ = 0;
+  bool     started_    = false;
+  uint32_t seq_    = 0;
+  Record   last_   = { 0, MISSING, MISSING };
+};
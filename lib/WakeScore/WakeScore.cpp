@@ -0,0 +1,91 @@
+#include "WakeScore.h"
+
+static const uint32_t FULL = 65536;  // Q16 one
+
+// v * tau / (tau + dt): exponential decay to first order per step, and
+// never negative however long the gap
+void WakeScore::Leak::decay(uint32_t nowMs, uint32_t tauMs) {
+  uint32_t dt = seen ? nowMs - at : 0;
+  if (dt) v = (uint32_t)((uint64_t)v * tauMs / ((uint64_t)tauMs + dt));
+  at   = nowMs;
+  seen = true;
+}
+
+// one-pole low-pass towards x over tau; the first sample starts from 0
+void WakeScore::Leak::smooth(uint32_t x, uint32_t nowMs, uint32_t tauMs) {
+  uint32_t dt = seen ? nowMs - at : 0;
+  int64_t  d  = (int64_t)x - v;
+  v   = (uint32_t)(v + d * dt / ((int64_t)tauMs + dt));
+  at   = nowMs;
+  seen = true;
+}
+
+void WakeScore::Leak::add(uint32_t x, uint32_t nowMs, uint32_t tauMs) {
+  decay(nowMs, tauMs);
+  v = v + x > FULL ? FULL : v + x;
+}
+
+static uint32_t ratioQ16(uint64_t num, uint64_t den) {
+  if (!den) return num ? FULL : 0;
+  uint64_t r = num * FULL / den;
+  return r > FULL ? FULL : (uint32_t)r;
+}
+
+void WakeScore::begin(const WakeScoreConfig& cfg) {
+  cfg_ = cfg;
+  if (!cfg_.pirRises) cfg_.pirRises = 1;
+  if (cfg_.soundFull < 2) cfg_.soundFull = 2;
+  if (cfg_.offScore > cfg_.onScore) cfg_.offScore = cfg_.onScore;
+  raised_ = 0;
+  reset();
+}
+
+void WakeScore::reset() {
+  pir_ = sound_ = camera_ = cry_ = Leak();
+  soundLive_ = cameraLive_ = false;
+  score_    = 0;
+  alerting_ = false;
+}
+
+void WakeScore::pir(uint32_t nowMs) {
+  pir_.add(FULL / cfg_.pirRises, nowMs, cfg_.pirTauMs);
+}
+
+void WakeScore::sound(uint32_t variance, uint32_t floor, uint32_t nowMs) {
+  // 0 at the floor, full at soundFull x the floor
+  uint64_t over = variance > floor ? (uint64_t)variance - floor : 0;
+  sound_.smooth(ratioQ16(over, (uint64_t)floor * (cfg_.soundFull - 1)), nowMs, cfg_.soundTauMs);
+}
+
+void WakeScore::camera(uint32_t level, uint32_t nowMs) {
+  camera_.smooth(ratioQ16(level, cfg_.cameraFull), nowMs, cfg_.cameraTauMs);
+}
+
+void WakeScore::cry(uint32_t nowMs) {
+  cry_.add(FULL, nowMs, cfg_.cryTauMs);
+}
+
+WakeScore::Edge WakeScore::update(uint32_t nowMs) {
+  pir_.decay(nowMs, cfg_.pirTauMs);
+  cry_.decay(nowMs, cfg_.cryTauMs);
+  soundLive_  = sound_.seen && nowMs - sound_.at < cfg_.soundTauMs;
+  cameraLive_ = camera_.seen && nowMs - camera_.at < cfg_.cameraTauMs;
+
+  uint32_t s = (pirEvidence()    * cfg_.pirWeight
+              + soundEvidence()  * cfg_.soundWeight
+              + cameraEvidence() * cfg_.cameraWeight
+              + cryEvidence()    * cfg_.cryWeight) >> 8;
+  score_ = s > 256 ? 256 : (uint16_t)s;
+
+  if (!alerting_ && score_ >= cfg_.onScore) {
+    alerting_ = true;
+    since_    = nowMs;
+    raised_++;
+    return RAISED;
+  }
+  if (alerting_ && score_ < cfg_.offScore && nowMs - since_ >= cfg_.holdMs) {
+    alerting_ = false;
+    return CLEARED;
+  }
+  return NONE;
+}
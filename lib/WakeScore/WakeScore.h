@@ -0,0 +1,91 @@
+#pragma once
+// One confidence that the baby is really awake, fused from every sensor,
+// so the app is only contacted when it is worth it.
+//
+// Each source is kept as evidence between 0 and 1 (Q8: 256 = full):
+//
+//   PIR     each rise adds 1/pirRises, leaking away with pirTauMs
+//   sound   frame variance over the noise floor, smoothed over soundTauMs;
+//           full at soundFull x the floor
+//   camera  FrameDiff motion level, smoothed over cameraTauMs; full at
+//           cameraFull
+//   cry     a confirmed cry is full evidence, leaking away with cryTauMs
+//
+// The score is their weighted sum, capped at 256. With the default weights
+// any one of PIR, sound or camera alone stays under onScore, while any two
+// agreeing, or a confirmed cry, cross it. A smoothed source that stops
+// reporting (no camera, mic paused for a lullaby) counts as zero once it
+// has been silent for its time constant. The alert latches on at onScore
+// and off below offScore after at least holdMs, so a restless baby
+// hovering around the threshold is one alert, not a stream of them.
+//
+// Everything is timestamped by the caller: the host replay harness drives
+// it from a virtual clock.
+//
+// No Arduino dependency: builds on the host.
+#include <stdint.h>
+
+struct WakeScoreConfig {
+  uint8_t  pirRises     = 3;      // rises for full PIR evidence
+  uint32_t pirTauMs     = 60000;
+  uint16_t soundFull    = 16;     // variance / floor (~12 dB)
+  uint32_t soundTauMs   = 5000;
+  uint32_t cameraFull   = 1024;   // FrameDiff::level(), 4 grey levels a pixel
+  uint32_t cameraTauMs  = 3000;
+  uint32_t cryTauMs     = 30000;
+  // Q8 weights: full evidence adds weight to the score
+  uint16_t pirWeight    = 96;
+  uint16_t soundWeight  = 96;
+  uint16_t cameraWeight = 96;
+  uint16_t cryWeight    = 256;
+  uint16_t onScore      = 160;
+  uint16_t offScore     = 64;
+  uint32_t holdMs       = 60000;  // shortest alert
+};
+
+class WakeScore {
+public:
+  enum Edge : uint8_t { NONE, RAISED, CLEARED };
+
+  void begin(const WakeScoreConfig& cfg = WakeScoreConfig());
+  void reset();
+
+  void pir(uint32_t nowMs);                                    // a PIR rise
+  void sound(uint32_t variance, uint32_t floor, uint32_t nowMs);
+  void camera(uint32_t level, uint32_t nowMs);
+  void cry(uint32_t nowMs);                                    // a confirmed cry
+
+  // Score at `nowMs` and whether the alert just latched on or off.
+  Edge update(uint32_t nowMs);
+
+  uint16_t score()    const { return score_; }
+  bool     alerting() const { return alerting_; }
+  uint32_t raised()   const { return raised_; }   // alerts since begin()
+
+  // Evidence as of the last update(), Q8.
+  uint16_t pirEvidence()    const { return pir_.q8(); }
+  uint16_t soundEvidence()  const { return soundLive_ ? sound_.q8() : 0; }
+  uint16_t cameraEvidence() const { return cameraLive_ ? camera_.q8() : 0; }
+  uint16_t cryEvidence()    const { return cry_.q8(); }
+
+private:
+  // Q16 evidence with the time it was last brought up to date.
+  struct Leak {
+    uint32_t v  = 0;
+    uint32_t at = 0;
+    bool     seen = false;
+    uint16_t q8() const { return (uint16_t)(v >> 8); }
+    void decay(uint32_t nowMs, uint32_t tauMs);
+    void smooth(uint32_t x, uint32_t nowMs, uint32_t tauMs);
+    void add(uint32_t x, uint32_t nowMs, uint32_t tauMs);
+  };
+
+  WakeScoreConfig cfg_;
+  Leak     pir_, sound_, camera_, cry_;
+  bool     soundLive_  = false;
+  bool     cameraLive_ = false;
+  uint16_t score_      = 0;
+  bool     alerting_   = false;
+  uint32_t since_      = 0;
+  uint32_t raised_     = 0;
+};
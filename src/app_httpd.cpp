@@ -13,12 +13,20 @@
 // limitations under the License.
 #include "esp_http_server.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_camera.h"
 #include "img_converters.h"
 #include "fb_gfx.h"
 #include "esp32-hal-ledc.h"
 #include "sdkconfig.h"
 #include "camera_index.h"
+#include "lwip/sockets.h"
+#include "freertos/semphr.h"
+#include "SampleRing.h"
+#include "ImaAdpcm.h"
+#include "FrameDiff.h"
+#include "BreathRate.h"
+#include "esp_jpg_decode.h"
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -99,6 +107,7 @@ static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %
 
 httpd_handle_t stream_httpd = NULL;
 httpd_handle_t camera_httpd = NULL;
+httpd_handle_t audio_httpd = NULL;
 
 #if CONFIG_ESP_FACE_DETECT_ENABLED
 
@@ -745,6 +754,571 @@ static esp_err_t stream_handler(httpd_req_t *req) {
   return res;
 }
 
+// Live audio listen-in. One task encodes the mic ring into IMA-ADPCM WAV
+// blocks (63 ms each at 8 kHz) and fans every block out to all /audio
+// listeners with non-blocking sends. A listener whose socket can't take the
+// next block skips it, so a slow phone loses audio instead of stalling the
+// sampler or the other listeners. /audio has a server of its own, two ports
+// up from the camera server: /stream holds its server's only task for as
+// long as a viewer watches, and audio must not wait behind it.
+#define AUDIO_MAX_LISTENERS 4
+#define AUDIO_FRAME_MAX     (8 + ima_adpcm::BLOCK_BYTES + 2)  // chunk size line + block + CRLF
+#define AUDIO_MAX_BACKLOG   (ima_adpcm::SAMPLES_PER_BLOCK * 2) // skip ahead past ~130 ms
+#define AUDIO_STALL_US      (5 * 1000000)                      // close a listener stuck this long
+#define AUDIO_POLL_MS       10
+
+typedef struct {
+  int fd;  // -1 when the slot is free
+  bool closing;
+  uint16_t len;   // bytes in frame, 0 when idle
+  uint16_t sent;  // bytes of frame already on the wire
+  uint8_t frame[AUDIO_FRAME_MAX];
+  int64_t last_progress;
+  uint32_t blocks;
+  uint32_t dropped;
+} audio_listener_t;
+
+static const char *_AUDIO_RESPONSE =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: audio/wav\r\n"
+  "Transfer-Encoding: chunked\r\n"
+  "Cache-Control: no-cache\r\n"
+  "Access-Control-Allow-Origin: *\r\n\r\n";
+
+static const SampleRing *audio_ring = NULL;
+static uint32_t audio_rate = 0;
+static const volatile int *audio_dc = NULL;
+static SemaphoreHandle_t audio_lock = NULL;
+static audio_listener_t audio_listeners[AUDIO_MAX_LISTENERS];
+static volatile int audio_listener_count = 0;
+
+static size_t audio_put_chunk(uint8_t *out, const uint8_t *data, size_t len) {
+  size_t n = snprintf((char *)out, 8, "%x\r\n", (unsigned)len);
+  memcpy(out + n, data, len);
+  memcpy(out + n + len, "\r\n", 2);
+  return n + len + 2;
+}
+
+// Streaming WAV header: the length fields are left at their maximum.
+static size_t audio_wav_header(uint8_t *h) {
+  const uint32_t spb = ima_adpcm::SAMPLES_PER_BLOCK, align = ima_adpcm::BLOCK_BYTES;
+  const uint32_t fields[] = { 0xFFFFFFFF, 20, 0x00010011, audio_rate, audio_rate * align / spb,
+                              (4 << 16) | align, (spb << 16) | 2, 4, 0xFFFFFFFF, 0xFFFFFFFF };
+  memcpy(h, "RIFF", 4);
+  memcpy(h + 8, "WAVEfmt ", 8);
+  memcpy(h + 40, "fact", 4);
+  memcpy(h + 52, "data", 4);
+  const uint8_t at[] = { 4, 16, 20, 24, 28, 32, 36, 44, 48, 56 };
+  for (int i = 0; i < 10; i++) {
+    for (int b = 0; b < 4; b++) {
+      h[at[i] + b] = (uint8_t)(fields[i] >> (8 * b));
+    }
+  }
+  return 60;
+}
+
+// Push what is left of the listener's frame. Returns true once it is all out.
+static bool audio_flush(audio_listener_t *l) {
+  while (l->sent < l->len) {
+    int n = send(l->fd, l->frame + l->sent, l->len - l->sent, MSG_DONTWAIT);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        l->closing = true;
+      }
+      return false;
+    }
+    l->sent += n;
+    l->last_progress = esp_timer_get_time();
+  }
+  l->len = l->sent = 0;
+  return true;
+}
+
+static void audio_listener_close(audio_listener_t *l) {
+  if (!l->closing || l->fd < 0 || !audio_httpd) {
+    return;
+  }
+  log_i("Audio listener %d closing: %u blocks sent, %u dropped", l->fd, l->blocks, l->dropped);
+  httpd_sess_trigger_close(audio_httpd, l->fd);
+  l->len = l->sent = 0;
+}
+
+// Session free callback: the socket is about to be closed by httpd.
+static void audio_listener_free(void *ctx) {
+  audio_listener_t *l = (audio_listener_t *)ctx;
+  xSemaphoreTake(audio_lock, portMAX_DELAY);
+  l->fd = -1;
+  l->len = l->sent = 0;
+  audio_listener_count--;
+  xSemaphoreGive(audio_lock);
+}
+
+static void audio_fanout(const uint8_t *block) {
+  int64_t now = esp_timer_get_time();
+  xSemaphoreTake(audio_lock, portMAX_DELAY);
+  for (int i = 0; i < AUDIO_MAX_LISTENERS; i++) {
+    audio_listener_t *l = &audio_listeners[i];
+    if (l->fd < 0 || l->closing) {
+      continue;
+    }
+    if (!audio_flush(l)) {
+      // still busy with an older block: this one is dropped for this listener
+      if (block) {
+        l->dropped++;
+      }
+      if (now - l->last_progress > AUDIO_STALL_US) {
+        l->closing = true;
+      }
+      audio_listener_close(l);
+      continue;
+    }
+    if (block) {
+      l->len = audio_put_chunk(l->frame, block, ima_adpcm::BLOCK_BYTES);
+      l->blocks++;
+      audio_flush(l);
+      audio_listener_close(l);
+    }
+  }
+  xSemaphoreGive(audio_lock);
+}
+
+static void audio_task(void *arg) {
+  SampleReader reader;
+  reader.attach(*audio_ring);
+  ima_adpcm::State state;
+  static int16_t pcm[ima_adpcm::SAMPLES_PER_BLOCK];
+  static uint8_t block[ima_adpcm::BLOCK_BYTES];
+
+  while (true) {
+    if (!audio_listener_count) {
+      reader.skipToLatest();
+      vTaskDelay(pdMS_TO_TICKS(AUDIO_POLL_MS * 5));
+      continue;
+    }
+    // latency stays bounded: never serve audio older than the backlog limit
+    if (reader.available() > AUDIO_MAX_BACKLOG) {
+      reader.skipToLatest();
+    }
+    if (!reader.readFrame(pcm, ima_adpcm::SAMPLES_PER_BLOCK)) {
+      audio_fanout(NULL);  // keep partially sent blocks moving
+      vTaskDelay(pdMS_TO_TICKS(AUDIO_POLL_MS));
+      continue;
+    }
+    ima_adpcm::adcToPcm16(pcm, ima_adpcm::SAMPLES_PER_BLOCK, *audio_dc, pcm);
+    ima_adpcm::encodeBlock(state, pcm, block);
+    audio_fanout(block);
+  }
+}
+
+static esp_err_t audio_handler(httpd_req_t *req) {
+  if (!audio_ring) {
+    return httpd_resp_send_404(req);
+  }
+  int fd = httpd_req_to_sockfd(req);
+  audio_listener_t *l = NULL;
+  xSemaphoreTake(audio_lock, portMAX_DELAY);
+  for (int i = 0; i < AUDIO_MAX_LISTENERS && !l; i++) {
+    if (audio_listeners[i].fd < 0) {
+      l = &audio_listeners[i];
+    }
+  }
+  xSemaphoreGive(audio_lock);
+  if (!l) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "Too many listeners", HTTPD_RESP_USE_STRLEN);
+  }
+
+  // Chunks are small and latency matters more than packet count
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  // The response never ends, so it is written raw and the socket handed to
+  // audio_task; httpd keeps the session and tells us when it closes.
+  uint8_t hdr[60];
+  uint8_t chunk[AUDIO_FRAME_MAX];
+  size_t hlen = audio_put_chunk(chunk, hdr, audio_wav_header(hdr));
+  if (httpd_send(req, _AUDIO_RESPONSE, strlen(_AUDIO_RESPONSE)) < 0 || httpd_send(req, (const char *)chunk, hlen) < 0) {
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(audio_lock, portMAX_DELAY);
+  l->closing = false;
+  l->len = l->sent = 0;
+  l->blocks = l->dropped = 0;
+  l->last_progress = esp_timer_get_time();
+  l->fd = fd;
+  audio_listener_count++;
+  xSemaphoreGive(audio_lock);
+  req->sess_ctx = l;
+  req->free_ctx = audio_listener_free;
+  log_i("Audio listener %d joined", fd);
+  return ESP_OK;
+}
+
+// Called once the mic is sampling and Wi-Fi is up: starts the encoder task
+// and the /audio server.
+void startAudioStream(const SampleRing *ring, uint32_t sample_rate, const volatile int *dc) {
+  if (audio_ring) {
+    return;
+  }
+  for (int i = 0; i < AUDIO_MAX_LISTENERS; i++) {
+    audio_listeners[i].fd = -1;
+  }
+  audio_lock = xSemaphoreCreateMutex();
+  audio_rate = sample_rate;
+  audio_dc = dc;
+  audio_ring = ring;
+  xTaskCreate(audio_task, "audio", 4096, NULL, 3, NULL);
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port += 2;
+  config.ctrl_port += 2;
+  config.max_open_sockets = AUDIO_MAX_LISTENERS + 1;  // one more to answer 503
+
+  httpd_uri_t audio_uri = {
+    .uri = "/audio",
+    .method = HTTP_GET,
+    .handler = audio_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+  log_i("Starting audio server on port: '%d'", config.server_port);
+  if (httpd_start(&audio_httpd, &config) == ESP_OK) {
+    httpd_register_uri_handler(audio_httpd, &audio_uri);
+  }
+}
+
+// Camera motion. A low-priority task on core 0, away from loop() and the
+// stream sender, grabs a frame every motion_interval_ms, decodes it at 1/8
+// scale (640x480 JPEG -> 80x60) straight to grey, hands the frame buffer
+// back and runs FrameDiff on it. /stream is untouched: it just waits a
+// frame when the motion task holds the buffer. Results and the per-frame
+// cost are served as JSON on /motion.
+//
+// The same frames feed BreathRate over the crib region, which /breath
+// reports and moves (?x=&y=&w=&h= on the 80x60 frame). Its cell history is
+// a fixed 16 KB in PSRAM and an estimate runs once a second.
+//
+// FrameDiff also adds every frame's motion into a 9.6 KB heat map for the
+// night; /heatmap encodes it as a JPEG on request, nothing is kept between.
+#define MOTION_GRAY_MAX (1600 / 8 * 1200 / 8)  // UXGA at 1/8 scale
+#define HEATMAP_SCALE 4                         // 80x60 -> 320x240
+
+typedef struct {
+  uint8_t *gray;
+  const uint8_t *jpg;
+  size_t jpg_len;
+  uint16_t w;
+  uint16_t h;
+} motion_decode_t;
+
+static FrameDiff motion_diff;
+static FrameDiff::Snapshot motion_snap;
+static uint32_t motion_grab_us = 0;  // frame grab + decode of the last frame
+static uint32_t motion_interval_ms = 0;
+static SemaphoreHandle_t motion_lock = NULL;
+static uint8_t *motion_gray = NULL;
+static BreathRate motion_breath;
+static BreathRate::Estimate motion_breath_est;
+static uint16_t motion_breath_region[4];  // x, y, w, h; /breath's copy, under the lock
+static bool motion_breath_moved = false;  // region changed by /breath, applied by the task
+static uint16_t *motion_heat = NULL;
+static bool motion_heat_clear = false;    // requested by cameraHeatClear(), applied by the task
+
+static size_t motion_jpg_read(void *arg, size_t index, uint8_t *buf, size_t len) {
+  motion_decode_t *d = (motion_decode_t *)arg;
+  if (index >= d->jpg_len) {
+    return 0;
+  }
+  if (len > d->jpg_len - index) {
+    len = d->jpg_len - index;
+  }
+  if (buf) {
+    memcpy(buf, d->jpg + index, len);
+  }
+  return len;
+}
+
+// RGB888 blocks to grey (BT.601 luma).
+static bool motion_jpg_write(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+  motion_decode_t *d = (motion_decode_t *)arg;
+  if (!data) {
+    if (x == 0 && y == 0) {  // start: the scaled image size
+      d->w = w;
+      d->h = h;
+      return (size_t)w * h <= MOTION_GRAY_MAX;
+    }
+    return true;
+  }
+  for (uint16_t iy = 0; iy < h; iy++) {
+    uint8_t *o = d->gray + (size_t)(y + iy) * d->w + x;
+    for (uint16_t ix = 0; ix < w; ix++, data += 3) {
+      o[ix] = (77 * data[0] + 150 * data[1] + 29 * data[2]) >> 8;
+    }
+  }
+  return true;
+}
+
+static void motion_task(void *arg) {
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(motion_interval_ms));
+    int64_t start = esp_timer_get_time();
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      continue;
+    }
+    bool ok = true;
+    if (fb->format == PIXFORMAT_GRAYSCALE) {
+      motion_diff.load(fb->buf, fb->width, fb->height, fb->width);
+    } else if (fb->format == PIXFORMAT_JPEG) {
+      motion_decode_t d = { motion_gray, fb->buf, fb->len, 0, 0 };
+      ok = esp_jpg_decode(fb->len, JPG_SCALE_8X, motion_jpg_read, motion_jpg_write, &d) == ESP_OK;
+      if (ok) {
+        motion_diff.load(motion_gray, d.w, d.h, d.w);
+      }
+    } else {
+      ok = false;
+    }
+    esp_camera_fb_return(fb);
+    if (!ok) {
+      continue;
+    }
+    uint32_t grab_us = esp_timer_get_time() - start;
+
+    // process() adds into the heat map, which /heatmap copies under the lock
+    xSemaphoreTake(motion_lock, portMAX_DELAY);
+    bool moved = motion_breath_moved;
+    uint16_t region[4];
+    memcpy(region, motion_breath_region, sizeof(region));
+    motion_breath_moved = false;
+    if (motion_heat_clear) {
+      motion_diff.clearHeat();
+      motion_heat_clear = false;
+    }
+    motion_diff.process();
+    xSemaphoreGive(motion_lock);
+
+    if (moved) {
+      motion_breath.setRegion(region[0], region[1], region[2], region[3]);
+    }
+    motion_breath.add(motion_diff.frame(), FrameDiff::W, FrameDiff::H, FrameDiff::W);
+
+    xSemaphoreTake(motion_lock, portMAX_DELAY);
+    motion_diff.snapshot(motion_snap);
+    motion_grab_us = grab_us;
+    motion_breath_est = motion_breath.estimate();
+    xSemaphoreGive(motion_lock);
+  }
+}
+
+// Called once the camera is up; /motion answers 404 until then.
+void startCameraMotion(uint32_t interval_ms, uint8_t noise, uint8_t learn_every) {
+  if (motion_lock) {
+    return;
+  }
+  motion_gray = (uint8_t *)heap_caps_malloc(MOTION_GRAY_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!motion_gray) {
+    motion_gray = (uint8_t *)malloc(MOTION_GRAY_MAX);
+  }
+  if (!motion_gray) {
+    log_e("Camera motion: no memory");
+    return;
+  }
+  motion_diff.begin(noise, learn_every);
+  motion_heat = (uint16_t *)heap_caps_malloc(FrameDiff::W * FrameDiff::H * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+  if (motion_heat) {
+    motion_diff.heatmap(motion_heat);
+  }
+  motion_interval_ms = interval_ms ? interval_ms : 1000;
+  BreathRateConfig breath_cfg;
+  breath_cfg.periodMs = motion_interval_ms;
+  breath_cfg.hop = (1000 + motion_interval_ms / 2) / motion_interval_ms;
+  motion_breath.begin(breath_cfg, (uint16_t *)heap_caps_malloc(BreathRate::STORE_BYTES, MALLOC_CAP_SPIRAM));
+  motion_breath_est = motion_breath.estimate();
+  const BreathRateConfig &c = motion_breath.config();
+  motion_breath_region[0] = c.x;
+  motion_breath_region[1] = c.y;
+  motion_breath_region[2] = c.w;
+  motion_breath_region[3] = c.h;
+  motion_lock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(motion_task, "motion", 4096, NULL, 1, NULL, 0);
+}
+
+// The last frame's result; false before the first difference.
+bool cameraMotion(FrameDiff::Snapshot *out, uint32_t *grab_us) {
+  if (!motion_lock) {
+    return false;
+  }
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  *out = motion_snap;
+  if (grab_us) {
+    *grab_us = motion_grab_us;
+  }
+  xSemaphoreGive(motion_lock);
+  return out->frames > 1;
+}
+
+// The latest breathing estimate; false before the camera task runs.
+bool cameraBreath(BreathRate::Estimate *out) {
+  if (!motion_lock) {
+    return false;
+  }
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  *out = motion_breath_est;
+  xSemaphoreGive(motion_lock);
+  return true;
+}
+
+// Start the heat map over, e.g. when a new night begins.
+void cameraHeatClear() {
+  if (!motion_lock) {
+    return;
+  }
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  motion_heat_clear = true;
+  xSemaphoreGive(motion_lock);
+}
+
+// Dark through purple and red to pale yellow, as B, G, R: the order
+// esp32-camera's RGB888 is kept in.
+static void heatmap_palette(uint8_t lut[256][3]) {
+  static const uint8_t stops[5][3] = { { 0, 0, 0 }, { 110, 0, 60 }, { 40, 30, 200 }, { 0, 150, 250 }, { 200, 255, 255 } };
+  for (int i = 0; i < 256; i++) {
+    int seg = i * 4 / 256, t = i * 4 % 256;
+    for (int c = 0; c < 3; c++) {
+      lut[i][c] = stops[seg][c] + (stops[seg + 1][c] - stops[seg][c]) * t / 255;
+    }
+  }
+}
+
+// GET /heatmap: where motion happened since the map was cleared, as a JPEG.
+// Counts are square-root scaled to the peak, so an hour of fidgeting in one
+// spot does not wash out a single roll elsewhere, then upscaled bilinearly.
+// The map and its peak are copied under the motion lock first, so a frame
+// being added or a halving never shows half done.
+static esp_err_t heatmap_handler(httpd_req_t *req) {
+  if (!motion_heat) {
+    return httpd_resp_send_404(req);
+  }
+  static uint8_t lut[256][3];
+  static bool lut_ready = false;
+  if (!lut_ready) {
+    heatmap_palette(lut);
+    lut_ready = true;
+  }
+  const int w = FrameDiff::W, h = FrameDiff::H;
+  const int ow = w * HEATMAP_SCALE, oh = h * HEATMAP_SCALE;
+  uint8_t *level = (uint8_t *)malloc(w * h);
+  size_t out_len = (size_t)ow * oh * 3;
+  uint8_t *out = (uint8_t *)heap_caps_malloc(out_len, MALLOC_CAP_SPIRAM);
+  uint16_t *heat = (uint16_t *)heap_caps_malloc(w * h * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+  if (!level || !out || !heat) {
+    free(level);
+    heap_caps_free(out);
+    heap_caps_free(heat);
+    log_e("Heatmap: no memory");
+    return httpd_resp_send_500(req);
+  }
+#if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
+  int64_t fr_start = esp_timer_get_time();
+#endif
+
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  memcpy(heat, motion_heat, w * h * sizeof(uint16_t));
+  uint32_t peak = motion_diff.heatPeak();
+  uint32_t heat_frames = motion_diff.heatFrames();
+  uint16_t heat_halvings = motion_diff.heatHalvings();
+  xSemaphoreGive(motion_lock);
+
+  for (int i = 0; i < w * h; i++) {
+    uint32_t v = heat[i];
+    // sqrt(v / peak) * 255
+    uint32_t x = peak ? (v > peak ? 65025 : v * 65025 / peak) : 0, r = 0;
+    for (uint32_t bit = 1UL << 16; bit; bit >>= 2) {
+      if (x >= r + bit) {
+        x -= r + bit;
+        r = (r >> 1) + bit;
+      } else {
+        r >>= 1;
+      }
+    }
+    level[i] = r > 255 ? 255 : r;
+  }
+
+  // output pixel centres mapped back onto the map, Q8
+  uint8_t *o = out;
+  for (int oy = 0; oy < oh; oy++) {
+    int sy = ((2 * oy + 1) * 128 / HEATMAP_SCALE) - 128;
+    sy = sy < 0 ? 0 : sy > (h - 1) * 256 ? (h - 1) * 256 : sy;
+    int y0 = sy >> 8, y1 = y0 + 1 < h ? y0 + 1 : y0, fy = sy & 255;
+    for (int ox = 0; ox < ow; ox++, o += 3) {
+      int sx = ((2 * ox + 1) * 128 / HEATMAP_SCALE) - 128;
+      sx = sx < 0 ? 0 : sx > (w - 1) * 256 ? (w - 1) * 256 : sx;
+      int x0 = sx >> 8, x1 = x0 + 1 < w ? x0 + 1 : x0, fx = sx & 255;
+      const uint8_t *r0 = level + y0 * w, *r1 = level + y1 * w;
+      int top = r0[x0] * (256 - fx) + r0[x1] * fx;
+      int bot = r1[x0] * (256 - fx) + r1[x1] * fx;
+      const uint8_t *c = lut[(top * (256 - fy) + bot * fy) >> 16];
+      o[0] = c[0];
+      o[1] = c[1];
+      o[2] = c[2];
+    }
+  }
+  free(level);
+  heap_caps_free(heat);
+
+  char frames[16], halvings[8];
+  snprintf(frames, sizeof(frames), "%u", heat_frames);
+  snprintf(halvings, sizeof(halvings), "%u", heat_halvings);
+  httpd_resp_set_type(req, "image/jpeg");
+  httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=heatmap.jpg");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "X-Heat-Frames", frames);
+  httpd_resp_set_hdr(req, "X-Heat-Halvings", halvings);
+
+  jpg_chunking_t jchunk = { req, 0 };
+  bool s = fmt2jpg_cb(out, out_len, ow, oh, PIXFORMAT_RGB888, 80, jpg_encode_stream, &jchunk);
+  heap_caps_free(out);
+  if (!s) {
+    log_e("Heatmap JPEG compression failed");
+    return ESP_FAIL;
+  }
+  httpd_resp_send_chunk(req, NULL, 0);
+#if ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
+  int64_t fr_end = esp_timer_get_time();
+#endif
+  log_i("Heatmap: %uB %ums", (uint32_t)jchunk.len, (uint32_t)((fr_end - fr_start) / 1000));
+  return ESP_OK;
+}
+
+static esp_err_t motion_handler(httpd_req_t *req) {
+  FrameDiff::Snapshot s;
+  uint32_t grab_us = 0;
+  if (!motion_lock) {
+    return httpd_resp_send_404(req);
+  }
+  cameraMotion(&s, &grab_us);
+
+  char json_response[320];
+  char *p = json_response;
+  p += sprintf(p, "{\"frames\":%u,\"interval_ms\":%u,\"total\":%u,\"regions\":[", s.frames, motion_interval_ms, s.total);
+  for (int i = 0; i < FrameDiff::REGIONS; i++) {
+    p += sprintf(p, "%s%u", i ? "," : "", s.energy[i]);
+  }
+  p += sprintf(p, "],\"cols\":%d,\"grab_us\":%u,\"diff_cycles\":%u,\"diff_max_cycles\":%u}",
+               FrameDiff::COLS, grab_us, s.lastCycles, s.maxCycles);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, json_response, p - json_response);
+}
+
 static esp_err_t parse_get(httpd_req_t *req, char **obuf) {
   char *buf = NULL;
   size_t buf_len = 0;
@@ -1125,6 +1699,54 @@ static esp_err_t win_handler(httpd_req_t *req) {
   return httpd_resp_send(req, NULL, 0);
 }
 
+static esp_err_t breath_handler(httpd_req_t *req) {
+  if (!motion_lock) {
+    return httpd_resp_send_404(req);
+  }
+  // the motion task owns motion_breath; the region is read from the copy
+  // kept under the lock, never from its config()
+  uint16_t r[4];
+  xSemaphoreTake(motion_lock, portMAX_DELAY);
+  memcpy(r, motion_breath_region, sizeof(r));
+  xSemaphoreGive(motion_lock);
+  char *buf = NULL;
+  if (httpd_req_get_url_query_len(req)) {
+    if (parse_get(req, &buf) != ESP_OK) {
+      return ESP_FAIL;
+    }
+    int x = parse_get_var(buf, "x", r[0]);
+    int y = parse_get_var(buf, "y", r[1]);
+    int w = parse_get_var(buf, "w", r[2]);
+    int h = parse_get_var(buf, "h", r[3]);
+    free(buf);
+    if (x < 0 || y < 0 || w < BreathRate::CELLS_X || h < BreathRate::CELLS_Y || x + w > FrameDiff::W || y + h > FrameDiff::H) {
+      return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Region must fit the 80x60 frame");
+    }
+    log_i("Breathing region: %d,%d %dx%d", x, y, w, h);
+    r[0] = x;
+    r[1] = y;
+    r[2] = w;
+    r[3] = h;
+    xSemaphoreTake(motion_lock, portMAX_DELAY);
+    memcpy(motion_breath_region, r, sizeof(r));
+    motion_breath_moved = true;
+    xSemaphoreGive(motion_lock);
+  }
+
+  BreathRate::Estimate e;
+  cameraBreath(&e);
+  char json_response[256];
+  int n = snprintf(json_response, sizeof(json_response),
+                   "{\"state\":\"%s\",\"bpm\":%u.%u,\"quality\":%u,\"frame\":%u,"
+                   "\"region\":[%u,%u,%u,%u],\"window_s\":%u,\"estimate_cycles\":%u,\"estimate_max_cycles\":%u}",
+                   BreathRate::stateName(e.state), e.bpmX10 / 10, e.bpmX10 % 10, e.quality, e.frame,
+                   r[0], r[1], r[2], r[3], BreathRate::WINDOW * motion_interval_ms / 1000,
+                   motion_breath.lastCycles(), motion_breath.maxCycles());
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, json_response, n);
+}
+
 static esp_err_t index_handler(httpd_req_t *req) {
   httpd_resp_set_type(req, "text/html");
   httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
@@ -1277,6 +1899,45 @@ void startCameraServer() {
 #endif
   };
 
+  httpd_uri_t motion_uri = {
+    .uri = "/motion",
+    .method = HTTP_GET,
+    .handler = motion_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+  httpd_uri_t breath_uri = {
+    .uri = "/breath",
+    .method = HTTP_GET,
+    .handler = breath_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
+  httpd_uri_t heatmap_uri = {
+    .uri = "/heatmap",
+    .method = HTTP_GET,
+    .handler = heatmap_handler,
+    .user_ctx = NULL
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ,
+    .is_websocket = true,
+    .handle_ws_control_frames = false,
+    .supported_subprotocol = NULL
+#endif
+  };
+
   httpd_uri_t win_uri = {
     .uri = "/resolution",
     .method = HTTP_GET,
@@ -1311,6 +1972,9 @@ void startCameraServer() {
     httpd_register_uri_handler(camera_httpd, &greg_uri);
     httpd_register_uri_handler(camera_httpd, &pll_uri);
     httpd_register_uri_handler(camera_httpd, &win_uri);
+    httpd_register_uri_handler(camera_httpd, &motion_uri);
+    httpd_register_uri_handler(camera_httpd, &breath_uri);
+    httpd_register_uri_handler(camera_httpd, &heatmap_uri);
   }
 
   config.server_port += 1;
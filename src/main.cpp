@@ -12,6 +12,23 @@
 #include <NimBLEDevice.h>
 #include <time.h>
 #include "esp_camera.h"
+#include "MicSampler.h"
+#include "ClipWavStream.h"
+#include "CryWatch.h"
+#include "SleepWake.h"
+#include "WakeScore.h"
+#include "SoundMeter.h"
+#include "PirEdges.h"
+#include "FrameDiff.h"
+#include "BreathRate.h"
+#include "SleepLog.h"
+#include "ApiLink.h"
+#include "EventQueue.h"
+#include "EventBatch.h"
+#include "EventJournal.h"
+#include <LittleFS.h>
+#include "esp_heap_caps.h"
+#include <atomic>
 
 #define CAMERA_MODEL_XIAO_ESP32S3
 #include "pins_layout.h"  // BCLK_, LRC_, DIN_, MOTION_SENSOR_PIN, SOUND_SENSOR_PIN
@@ -30,7 +47,12 @@ static const char* API_HOST  = "theta.proto.aalto.fi";
 static const int   DEVICE_ID = 1;
 static const char* API_USER  = "demo";      // replace securely
 static const char* API_PASS  = "demodemo";  // replace securely
+static const uint32_t API_IDLE_MS = 55000;  // under the server's keep-alive timeout
+static const char* API_CA_PATH = "/api_ca.pem";  // LittleFS: the CA the server's cert chains to
 String             apiToken;
+ApiLink            api;   // one keep-alive connection for every call below
+String             apiCA;
+RTC_NOINIT_ATTR TlsClient::Cache tlsCache;  // TLS session, resumed after sleep or a reset
 
 //=== Audio & cry globals ===
 const float ADC_REF      = 3.3f;  
@@ -38,27 +60,130 @@ const int   ADC_RES      = 4095;
 // Divider ratio = (R1 + R2) / R2. E.g. 100 kΩ/100 kΩ → 2.0
 const float R_DIVIDER    = 2.0f;  
 const float          gain               = 0.2;
-const int            SOUND_THRESHOLD    = 2000;
+const int            SOUND_THRESHOLD    = 2000;   // until the noise floor is learned
 const unsigned long  PIR_HIGH_MS        = 3000;
 const unsigned long  CRY_WINDOW_MS      = 5000;
-const int            DIFF_THRESHOLD     = 300;
-const int            CRY_COUNT_THRESHOLD= 50;
+const unsigned long  CRY_PERSIST_MS     = 1500;
 const int            MAX_LULLABIES      = 3;
 const size_t         BUF_SIZE           = 256 * 1024;
+const uint32_t       MIC_SAMPLE_RATE    = 8000;
+const uint32_t       MIC_RING_SAMPLES   = 131072; // ~16 s of history, 256 KB PSRAM
+const uint32_t       CLIP_PRE_ROLL_MS   = 5000;   // audio kept from before a cry
+const uint32_t       CLIP_POST_ROLL_MS  = 5000;
+const int            CLIP_SLOTS         = 2;      // latest clips held for review
+const uint32_t       CRY_FRAME_SAMPLES  = CryDetector::FRAME;  // 32 ms
+// Adaptive thresholds, derived from the 20th percentile of frame variance
+const uint32_t       CRY_ENERGY_PER_VAR = 12;    // Parseval: band energy ≈ 12 × variance
+const uint32_t       NOISE_ENERGY_GAIN  = 8;     // cry must be ~9 dB over the floor
+const uint32_t       CRY_MIN_ENERGY     = 2000;
+const int            SOUND_SIGMA_GAIN   = 4;     // test-mode trip level, in noise σ
+const int            SOUND_MIN_MARGIN   = 100;
+const unsigned long  NOISE_SAVE_MS      = 15UL * 60 * 1000;
+// MFCC + int8 CNN stage; falls back to the spectral detector without a model
+const char*          CRY_MODEL_PATH     = "/cry_model.bin";
+const int            CRY_CLASSIFY_HOP   = 8;     // frames between inferences (~256 ms)
+const uint16_t       CRY_PROB_THRESHOLD = 180;   // Q8, ~70 %
+const int            CRY_CONFIRM_VOTES  = 2;     // consecutive cry inferences
+const size_t         METER_BYTES        = 128 * 1024;  // ~16 h of per-second levels, PSRAM
+const size_t         METER_BATCH        = 300;   // records per /levels response
+// camera frame-difference motion, on core 0 next to /stream
+const uint32_t       CAM_MOTION_PERIOD  = 250;   // ms between analysed frames; breathing needs ~4 fps
+const uint8_t        CAM_MOTION_NOISE   = 12;    // grey levels of sensor noise
+const uint8_t        CAM_MOTION_LEARN   = 4;     // frames per background step
+// one sleep summary per night instead of every transition
+const uint16_t       NIGHT_CLOSE_MIN    = 8 * 60;  // nights end at 08:00 UTC
+const unsigned long  SUMMARY_RETRY_MS   = 10UL * 60 * 1000;
+// HTTPS off loop(): events queue for the network task on core 0
+const unsigned long  TEST_FEEDBACK_MS   = 500;   // test-mode feedback spacing
+// commands and patterns go up together, at most this late unless urgent
+const uint32_t       BATCH_MAX_MS       = 2000;
+// what can't be sent is journaled in flash and replayed from the oldest
+const uint32_t       JOURNAL_RETRY_MS   = 30000;
 const char* songURL   = "http://ia600107.us.archive.org/13/items/LullabySong/06-nickelback-lullaby.mp3";
 
 const int PIR_PIN = MOTION_SENSOR_PIN;
 const int MIC_PIN = SOUND_SENSOR_PIN;
 
+MicSampler   mic;
+PirEdges     pirEdges;                   // PIR rises/falls, queued by the GPIO ISR
+SampleReader cryReader;
+AudioClip    cryClips[CLIP_SLOTS];
+uint32_t     clipNumber[CLIP_SLOTS];     // which capture each slot holds
+uint32_t     clipUploaded[CLIP_SLOTS];
+time_t       clipTime[CLIP_SLOTS];
+uint32_t     clipCount = 0;
+CryWatch     cryWatch;                   // cry verdict per window frame
+// PIR -> cry window -> lullaby, timings folded in at compile time
+struct NurseryTiming {
+  static const uint32_t HOLD_MS            = PIR_HIGH_MS;
+  static const uint8_t  RISES              = 0;
+  static const uint32_t RISE_WINDOW_MS     = 0;
+  static const uint32_t LISTEN_MS          = CRY_WINDOW_MS;
+  static const uint32_t CRY_MS             = 0;      // CryWatch has confirmed it
+  static const int      MAX_LULLABIES      = ::MAX_LULLABIES;
+  static const bool     DEAF_WHILE_PLAYING = false;  // echo suppression hears through it
+};
+typedef SleepWake<NurseryTiming> Nursery;
+Nursery      nursery;
+WakeScore    wakeScore;                  // fused evidence; gates the app calls
+uint32_t     appCalls     = 0;           // HTTPS calls to the app; tools/replay measures the saving
+RTC_NOINIT_ATTR SleepLog::Store sleepStore;  // survives a reset, not a power cycle
+SleepLog     sleepLog;                   // tonight's sessions, cries and lullabies
+EchoReference echoRef;                   // lullaby as heard by the DAC, at the mic rate
+static_assert(MIC_SAMPLE_RATE == CryWatch::MFCC_RATE, "cry model expects 8 kHz audio");
+CryClassifier cryClassifier;
+void loadCryModel();
+bool loadApiCA();
+SampleReader levelReader;
+SampleReader meterReader;
+SoundMeter   soundMeter;
+void handleLevels();
+NoiseFloor   noiseFloor;
+Preferences  noisePrefs;
+DcTracker    micDcTrack(4);  // per frame mean
+int          micDc          = 2048;
+int          soundThreshold = SOUND_THRESHOLD;
+// /audio listen-in on its own server, port 82; needs Wi-Fi up
+void startAudioStream(const SampleRing* ring, uint32_t sampleRate, const volatile int* dc);
+// /motion, from frames grabbed at a low rate alongside /stream
+void startCameraMotion(uint32_t intervalMs, uint8_t noise, uint8_t learnEvery);
+bool cameraMotion(FrameDiff::Snapshot* out, uint32_t* grabUs);
+bool cameraBreath(BreathRate::Estimate* out);
+void cameraHeatClear();
+
 WebServer server(80);
 bool       testMode     = false;
-int        lullabyCount = 0;
 
 AudioFileSourceHTTPStream *file   = nullptr;
 AudioFileSourceBuffer     *buffer = nullptr;
 AudioGeneratorMP3         *mp3    = nullptr;
 AudioOutputI2S            *out    = nullptr;
 
+// loop() queues what the cloud should hear; netTask sends it. Commands
+// and patterns (arg: urgent) are batched.
+enum NetEventKind : uint16_t { EV_COMMAND, EV_PATTERN, EV_SONG, EV_CLIP, EV_SUMMARY };
+EventQueue netEvents;
+EventBatch netBatch(BATCH_MAX_MS);
+bool       batchApi = true;  // until the server says it has no /events
+EventBatch   replayBatch;       // netTask: journaled events on their way out
+EventJournal journal;
+uint32_t     journalRetryAt = 0;
+TaskHandle_t netTaskHandle = nullptr;
+std::atomic<AudioFileSourceHTTPStream*> songReady{nullptr};  // opened by netTask, played by loop()
+std::atomic<bool> summaryBusy{false};  // a summary is queued or being sent...
+std::atomic<bool> summarySent{false};  // ...and got through
+void netTask(void* arg);
+
+// Feeds every decoded sample to the echo reference on its way to the DAC
+class EchoTapOutput : public AudioOutputI2S {
+public:
+  bool ConsumeSample(int16_t sample[2]) override {
+    if (!AudioOutputI2S::ConsumeSample(sample)) return false;
+    echoRef.push((int16_t)((sample[0] + sample[1]) / 2), hertz);
+    return true;
+  }
+};
+
 // Map LiPo voltage (3.0–4.2 V) → %  
 float voltageToPercent(float v) {
   if (v >= 4.20f) return 100.0f;
@@ -68,75 +193,77 @@ float voltageToPercent(float v) {
 
 //=== Cloud functions ===
 bool apiLogin() {
-  WiFiClientSecure* client = new WiFiClientSecure();
-  client->setInsecure(); // TODO: load real CA
-
-  HTTPClient https;
-  String url = String("https://") + API_HOST + "/api/users/login";
-  https.begin(*client, url);
-  https.addHeader("Content-Type", "application/json");
-
   StaticJsonDocument<128> body;
   body["username"] = API_USER;
   body["password"] = API_PASS;
   String payload;
   serializeJson(body, payload);
 
-  int code = https.POST(payload);
+  String reply;
+  int code = api.call("POST", "/api/users/login", "application/json",
+                      (const uint8_t*)payload.c_str(), payload.length(), &reply);
   if (code != HTTP_CODE_OK) {
     Serial.printf("API login failed: %d\n", code);
-    https.end(); delete client;
     return false;
   }
 
   StaticJsonDocument<256> resp;
-  DeserializationError err = deserializeJson(resp, https.getString());
-  https.end(); delete client;
+  DeserializationError err = deserializeJson(resp, reply);
   if (err) {
     Serial.println("JSON parse error on login");
     return false;
   }
 
   apiToken = resp["token"].as<String>();
+  api.setToken(apiToken);
   Serial.printf("→ Success Login: Got API token: %s\n", apiToken.c_str());
   return true;
 }
 
-bool sendPattern(const char* patternType) {
-  WiFiClientSecure client;
-  client.setInsecure();
+// Queue an outbound event stamped with the time it happened.
+bool postEvent(NetEvent e) {
+  e.ms  = millis();
+  e.utc = (uint32_t)time(nullptr);
+  if (netEvents.push(e)) {
+    if (netTaskHandle) xTaskNotifyGive(netTaskHandle);
+    return true;
+  }
+  Serial.printf("Net queue full, event %u dropped\n", e.kind);
+  return false;
+}
+
+static void isoTime(uint32_t utc, char buf[32]) {
+  time_t t = (time_t)utc;
+  struct tm *g = gmtime(&t);
+  strftime(buf, 32, "%Y-%m-%dT%H:%M:%SZ", g);
+}
 
-  HTTPClient https;
-  String url = String("https://") + API_HOST
-               + "/api/devices/" + String(DEVICE_ID) + "/patterns";
-  https.begin(client, url);
-  https.addHeader("Authorization", "Bearer " + apiToken);
-  https.addHeader("Content-Type", "application/json");
+bool sendPattern(const char* patternType, bool urgent = false) {
+  return postEvent(NetEvent(EV_PATTERN, patternType, urgent));
+}
 
+// netTask: the pattern as of `utc`; the HTTP status
+int putPattern(const char* patternType, uint32_t utc) {
   StaticJsonDocument<128> doc;
   char buf[32];
-  time_t now = time(nullptr);
-  struct tm *g = gmtime(&now);
-  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", g);
+  isoTime(utc, buf);
   doc["timestamp"]   = buf;
   doc["patternType"] = patternType;
 
   String body;
   serializeJson(doc, body);
-  int code = https.PUT(body);
-  https.end();
+  int code = api.call("PUT", "/api/devices/" + String(DEVICE_ID) + "/patterns", "application/json",
+                      (const uint8_t*)body.c_str(), body.length());
 
   if (code >= 200 && code < 300) {
     Serial.printf("→ Sent pattern \"%s\" (HTTP %d)\n", patternType, code);
-    return true;
   } else {
     Serial.printf("Pattern send failed: HTTP %d\n", code);
-    return false;
   }
+  return code;
 }
 
-bool playCloudSong() {
-  // ————— 1) tear down any prior playback —————
+void stopSong() {
   if (mp3->isRunning()) {
     mp3->stop();
     delay(10);
@@ -151,7 +278,18 @@ bool playCloudSong() {
     delete file;
     file = nullptr;
   }
+}
 
+// Stop what plays and have netTask open the active sound; loop() starts
+// it once the stream is up (startCloudSong()).
+bool playCloudSong() {
+  // ————— 1) tear down any prior playback —————
+  stopSong();
+  return postEvent(NetEvent(EV_SONG));
+}
+
+// netTask: the slow part, fetching the stream
+AudioFileSourceHTTPStream* openCloudSong() {
   // ————— 2) build the "active sound" URL —————
   String url = String("https://") + API_HOST
                + "/api/devices/" + String(DEVICE_ID)
@@ -160,60 +298,209 @@ bool playCloudSong() {
   Serial.printf("→ Fetching active sound from: %s\n", url.c_str());
 
   // ————— 3) open the HTTP stream directly —————
-  file = new AudioFileSourceHTTPStream();
-  if (!file->open(url.c_str())) {
-    // file->open() will return false on 404 or any non-200
+  AudioFileSourceHTTPStream* src = new AudioFileSourceHTTPStream();
+  if (!src->open(url.c_str())) {
+    // src->open() will return false on 404 or any non-200
     Serial.println("→ No active sound or HTTP error");
-    delete file;
-    file = nullptr;
-    return false;
+    delete src;
+    return nullptr;
   }
+  return src;
+}
+
+// loop(): play the stream netTask opened, if there is a new one
+void startCloudSong() {
+  AudioFileSourceHTTPStream* src = songReady.exchange(nullptr);
+  if (!src) return;
+  stopSong();  // another song may have started since it was asked for
 
   // ————— 4) wrap & kick off the decoder —————
+  file   = src;
   buffer = new AudioFileSourceBuffer(file, BUF_SIZE);
   mp3->begin(buffer, out);
-
-  return true;
 }
 
 void startLullaby() {
   mp3->begin(buffer, out);
 }
 
-bool sendCommand(const char* cmd) {
-  WiFiClientSecure client;
-  client.setInsecure();           // or setInsecure()
-  HTTPClient http;
-  String url = String("https://") + API_HOST
-               + "/api/devices/" + DEVICE_ID + "/commands";
-  http.begin(client, url);
-  http.addHeader("Authorization","Bearer "+apiToken);
-  http.addHeader("Content-Type","application/json");
+bool sendCommand(const char* cmd, bool urgent = false) {
+  return postEvent(NetEvent(EV_COMMAND, cmd, urgent));
+}
 
+// netTask: the command, stamped `utc`; the HTTP status
+int putCommand(const char* cmd, uint32_t utc) {
   // build payload
-  StaticJsonDocument<64> doc;
-  doc["command"] = cmd;
+  StaticJsonDocument<96> doc;
+  char ts[32];
+  isoTime(utc, ts);
+  doc["command"]   = cmd;
+  doc["timestamp"] = ts;
   String body;
   serializeJson(doc, body);
 
-  int code = http.PUT(body);
-  http.end();
+  int code = api.call("PUT", "/api/devices/" + String(DEVICE_ID) + "/commands", "application/json",
+                      (const uint8_t*)body.c_str(), body.length());
   if (code >= 200 && code < 300) {
     Serial.printf("→ Sent command \"%s\" (HTTP %d)\n", cmd, code);
-    return true;
   } else {
     Serial.printf("Command send failed: HTTP %d\n", code);
-    return false;
   }
-  return (code >=200 && code<300);
- 
+  return code;
 }
 
-void sendWarningToApp()   { sendCommand("notification"); }
-void sendVibrateCommand() { sendCommand("vibrate"); }
+void sendWarningToApp()   { sendCommand("notification", true); }
+void sendVibrateCommand() { sendCommand("vibrate", true); }
 void sendMotionFeedback() { sendCommand("motion_detected"); }
 void sendSoundFeedback() { sendCommand("sound_detected"); }
 
+// No answer, or the server's trouble: worth trying again later.
+static bool retryable(int code) {
+  return code < 0 || code == 408 || code == 429 || code >= 500;
+}
+
+// netTask: `b` as one request, or one PUT each on a server without
+// /events. Returns how many of its events, from the first, are done
+// with: sent, or refused for good.
+int deliverBatch(const EventBatch& b) {
+  int n = b.count(), done = 0;
+  if (WiFi.status() != WL_CONNECTED) return 0;
+  while (batchApi && done < n) {
+    // MAX events fit; if they ever don't, they go in as many requests as
+    // it takes, never as a cut-off body
+    char   json[640];
+    size_t len = 0;
+    int    k   = n - done;
+    while (k && !(len = b.writeJson(json, sizeof(json), EV_COMMAND, done, k))) k /= 2;
+    if (!k) {
+      Serial.printf("Event \"%s\" too large for a batch, dropped\n", b[done].text);
+      done++;
+      continue;
+    }
+    int code = api.call("POST", "/api/devices/" + String(DEVICE_ID) + "/events", "application/json",
+                        (const uint8_t*)json, len);
+    if (code == HTTP_CODE_NOT_FOUND) {
+      Serial.println("→ No batch endpoint, sending events one by one");
+      batchApi = false;
+    } else if (code >= 200 && code < 300) {
+      Serial.printf("→ Sent %d events in one batch (HTTP %d)\n", k, code);
+      done += k;
+    } else if (retryable(code)) {
+      Serial.printf("Batch send failed: HTTP %d\n", code);
+      return done;
+    } else {
+      Serial.printf("Batch refused: HTTP %d, %d events dropped\n", code, k);
+      done += k;
+    }
+  }
+  for (; done < n; done++) {
+    const NetEvent& e = b[done];
+    int code = e.kind == EV_COMMAND ? putCommand(e.text, e.utc) : putPattern(e.text, e.utc);
+    if (retryable(code)) return done;
+  }
+  return n;
+}
+
+// netTask: send the batch, journaling what doesn't get through. With
+// events already journaled it goes in behind them, to keep the order; an
+// urgent one has the journal replayed now rather than after the backoff.
+void sendBatch(EventBatch::Reason why) {
+  int  n      = netBatch.count();
+  if (!n) return;
+  bool behind = journal.pending() > 0;
+  int  done   = behind ? 0 : deliverBatch(netBatch);
+  for (int i = done; i < n; i++) {
+    if (!journal.append(netBatch[i])) Serial.printf("Event \"%s\" lost\n", netBatch[i].text);
+  }
+  if (behind && why == EventBatch::URGENT) journalRetryAt = millis();
+  else if (!behind && done < n)           journalRetryAt = millis() + JOURNAL_RETRY_MS;
+  netBatch.clear(why, millis());
+}
+
+// netTask: a batch of the oldest journaled events; false unless all of
+// them got through.
+bool replayJournal() {
+  NetEvent ev[EventBatch::MAX];
+  int n = journal.peek(ev, EventBatch::MAX);
+  if (!n) return false;
+  for (int i = 0; i < n; i++) replayBatch.add(ev[i], false);
+  int done = deliverBatch(replayBatch);
+  replayBatch.clear(EventBatch::NONE, millis());
+  journal.ack(done);
+  if (done) Serial.printf("→ Replayed %d journaled events, %u still waiting\n", done, journal.pending());
+  return done == n;
+}
+
+// Freeze pre-roll + post-roll around ring position `at` into a clip slot.
+// The slot is swapped in by the sampler once the post-roll is recorded.
+void captureCryClip(uint32_t at) {
+  uint32_t pre  = CLIP_PRE_ROLL_MS  * MIC_SAMPLE_RATE / 1000;
+  uint32_t post = CLIP_POST_ROLL_MS * MIC_SAMPLE_RATE / 1000;
+  for (int i = 0; i < CLIP_SLOTS; i++) {
+    int slot = (clipCount + i) % CLIP_SLOTS;
+    if (mic.freezeClip(cryClips[slot], at - pre, at + post)) {
+      clipNumber[slot] = ++clipCount;
+      clipTime[slot]   = time(nullptr);
+      return;
+    }
+  }
+  Serial.println("Cry clip not captured (slots busy)");
+}
+
+// Newest recorded clip, or -1
+int latestClipSlot() {
+  int best = -1;
+  for (int i = 0; i < CLIP_SLOTS; i++) {
+    if (cryClips[i].state() != AudioClip::READY) continue;
+    if (best < 0 || clipNumber[i] > clipNumber[best]) best = i;
+  }
+  return best;
+}
+
+// GET /clip → latest cry clip as WAV, streamed straight from PSRAM
+void handleClipRequest() {
+  int slot = latestClipSlot();
+  if (slot < 0 || !cryClips[slot].beginRead()) {
+    server.send(404, "text/plain", "no clip");
+    return;
+  }
+  // ADPCM by default; ?fmt=pcm for tools that only read plain WAV
+  ClipWavStream::Format fmt = server.arg("fmt") == "pcm" ? ClipWavStream::PCM16
+                                                          : ClipWavStream::IMA_ADPCM;
+  ClipWavStream wav(cryClips[slot], MIC_SAMPLE_RATE, micDc, fmt);
+  server.setContentLength(wav.size());
+  server.sendHeader("X-Clip-Time", String((long)clipTime[slot]));
+  server.send(200, "audio/wav", "");
+  char chunk[1024];
+  size_t n;
+  while ((n = wav.readBytes(chunk, sizeof(chunk))) > 0) server.sendContent(chunk, n);
+  cryClips[slot].endRead();
+}
+
+// netTask: clip `number`, unless a newer capture has taken its slot, as
+//   POST /api/devices/{id}/clips   audio/wav (IMA ADPCM, 8 kHz mono)
+//   X-Clip-Time: capture time, Unix seconds
+// next to /patterns and /commands. A clip is sent once; if that fails,
+// GET /clip on the device still serves it until its slot is reused.
+bool uploadCryClip(int slot, uint32_t number) {
+  if (!cryClips[slot].beginRead()) return false;
+  if (clipNumber[slot] != number) {
+    cryClips[slot].endRead();
+    return false;
+  }
+  ClipWavStream wav(cryClips[slot], MIC_SAMPLE_RATE, micDc, ClipWavStream::IMA_ADPCM);
+  api.header("X-Clip-Time", String((long)clipTime[slot]));
+  int code = api.call("POST", "/api/devices/" + String(DEVICE_ID) + "/clips", "audio/wav", &wav, wav.size());
+  cryClips[slot].endRead();
+
+  if (code >= 200 && code < 300) {
+    Serial.printf("→ Uploaded cry clip #%u (%u B, HTTP %d)\n", clipNumber[slot], (unsigned)wav.size(), code);
+    return true;
+  }
+  Serial.printf("Clip upload failed: HTTP %d\n", code);
+  return false;
+}
+
 // bool sendImageToCloud() {
 //   // 1) snap a photo
 //   camera_fb_t *fb = esp_camera_fb_get();
@@ -252,33 +539,42 @@ void sendSoundFeedback() { sendCommand("sound_detected"); }
 //   }
 // }
 
-bool sendIpToCloud(const String& ip) {
-  // 1) prepare secure client
-  WiFiClientSecure client;
-  client.setInsecure();  // or load your CA
+// The closed night's summary; the cloud no longer rebuilds it from patterns.
+//   POST /api/devices/{id}/nights   application/json, SleepLog::writeJson()
+// True once the night is done with: stored, or refused for good. Anything
+// retryable() keeps it pending for the next try.
+bool uploadSleepSummary() {
+  char json[640];
+  size_t len = SleepLog::writeJson(json, sizeof(json), sleepLog.pendingNight());
+  if (!len) return false;
 
-  // 2) build URL
-  String url = String("https://") + API_HOST
-               + "/api/devices/" + String(DEVICE_ID)
-               + "/ip";
+  int code = api.call("POST", "/api/devices/" + String(DEVICE_ID) + "/nights", "application/json",
+                      (const uint8_t*)json, len);
 
-  // 3) start PUT
-  HTTPClient https;
-  https.begin(client, url);
-  https.addHeader("Authorization", "Bearer " + apiToken);
-  https.addHeader("Content-Type", "application/json");
+  if (code >= 200 && code < 300) {
+    Serial.printf("→ Uploaded night summary (%u B, HTTP %d)\n", (unsigned)len, code);
+    return true;
+  }
+  if (!retryable(code)) {
+    Serial.printf("Night summary refused: HTTP %d, dropped\n", code);
+    return true;
+  }
+  Serial.printf("Night summary upload failed: HTTP %d\n", code);
+  return false;
+}
 
-  // 4) build payload
+bool sendIpToCloud(const String& ip) {
+  // 1) build payload
   StaticJsonDocument<64> doc;
   doc["IPaddress"] = ip;                   // <-- as per cloud spec
   String payload;
   serializeJson(doc, payload);
 
-  // 5) send & clean up
-  int code = https.PUT(payload);
-  https.end();
+  // 2) send on the shared connection
+  int code = api.call("PUT", "/api/devices/" + String(DEVICE_ID) + "/ip", "application/json",
+                      (const uint8_t*)payload.c_str(), payload.length());
 
-  // 6) report result
+  // 3) report result
   if (code >= 200 && code < 300) {
     Serial.printf("→ Sent IP “%s” OK (HTTP %d)\n", ip.c_str(), code);
     return true;
@@ -348,6 +644,42 @@ void setup() {
   analogSetAttenuation(ADC_11db);
   pinMode(MIC_PIN, INPUT);
   pinMode(PIR_PIN, INPUT);
+  pirEdges.begin(PIR_PIN);
+  // Battery shares ADC1 with the mic, so it rides in the same DMA pattern
+  if (!mic.begin(MIC_PIN, BAT_ADC_PIN, MIC_SAMPLE_RATE, MIC_RING_SAMPLES)) {
+    Serial.println("Mic sampler init failed");
+  }
+  cryReader.attach(mic.ring());
+  for (int i = 0; i < CLIP_SLOTS; i++) {
+    mic.allocClip(cryClips[i], (CLIP_PRE_ROLL_MS + CLIP_POST_ROLL_MS) * MIC_SAMPLE_RATE / 1000);
+  }
+  loadCryModel();
+  CryWatchConfig cryCfg;
+  cryCfg.sampleRate    = MIC_SAMPLE_RATE;
+  cryCfg.persistMs     = CRY_PERSIST_MS;
+  cryCfg.energyPerVar  = CRY_ENERGY_PER_VAR;
+  cryCfg.energyGain    = NOISE_ENERGY_GAIN;
+  cryCfg.minEnergy     = CRY_MIN_ENERGY;
+  cryCfg.classifyHop   = CRY_CLASSIFY_HOP;
+  cryCfg.probThreshold = CRY_PROB_THRESHOLD;
+  cryCfg.confirmVotes  = CRY_CONFIRM_VOTES;
+  cryWatch.begin(cryCfg, &cryClassifier);
+  wakeScore.begin();
+
+  // Noise floor survives reboots so a nursery fan isn't relearned each time
+  levelReader.attach(mic.ring());
+  // per-second Leq/peak of everything the mic hears, lullabies included
+  meterReader.attach(mic.ring());
+  uint8_t* meterStore = (uint8_t*)heap_caps_malloc(METER_BYTES, MALLOC_CAP_SPIRAM);
+  soundMeter.begin(meterStore, meterStore ? METER_BYTES : 0, MIC_SAMPLE_RATE);
+  noisePrefs.begin("noise", false);
+  noiseFloor.begin();
+  noiseFloor.restore(noisePrefs.getUInt("floor", 0));
+  micDc = noisePrefs.getInt("dc", micDc);
+  micDcTrack.restore(micDc);
+  if (esp_camera_sensor_get()) {
+    startCameraMotion(CAM_MOTION_PERIOD, CAM_MOTION_NOISE, CAM_MOTION_LEARN);
+  }
 
   //Load stored Wi-Fi creds
   preferences.begin("wifi", false);
@@ -384,14 +716,28 @@ void setup() {
   Serial.print("Waiting for time");
   while (time(nullptr) < 24*3600) { delay(500); Serial.print("."); }
   Serial.println(" done.");
+  if (sleepLog.begin(&sleepStore, time(nullptr), NIGHT_CLOSE_MIN)) {
+    Serial.printf("Sleep log: resumed the night (%u wakes so far)\n", sleepLog.night().wakes);
+  }
 
   // Cloud login
+  api.begin(API_HOST);
+  api.setIdleMs(API_IDLE_MS);
+  api.setSessionCache(&tlsCache);
+  if (loadApiCA()) {
+    api.setCA(apiCA.c_str());
+    journal.begin();  // nothing will get through without the CA anyway
+    if (journal.pending()) Serial.printf("Journal: %u events from before the reset\n", journal.pending());
+  }
   if (!apiLogin()) Serial.println("Cloud auth failed");
 
   // Test HTTP server
   server.on("/test/on",  [](){ testMode=true;  server.send(200,"text/plain","ON"); });
   server.on("/test/off", [](){ testMode=false; server.send(200,"text/plain","OFF"); });
+  server.on("/clip", HTTP_GET, handleClipRequest);
+  server.on("/levels", HTTP_GET, handleLevels);
   server.begin();
+  startAudioStream(&mic.ring(), MIC_SAMPLE_RATE, &micDc);
 
   // Send IP to cloud
   String myIp = WiFi.localIP().toString();
@@ -400,7 +746,8 @@ void setup() {
   }
 
   // Audio init
-  out = new AudioOutputI2S();
+  echoRef.begin(MIC_SAMPLE_RATE);
+  out = new EchoTapOutput();
   out->SetPinout(BCLK_AMPLIFIER_PIN, LRC_AMPLIFIER_PIN, DIN_AMPLIFIER_PIN);
   out->SetOutputModeMono(true);
   out->SetGain(gain);
@@ -409,92 +756,357 @@ void setup() {
   buffer = new AudioFileSourceBuffer(file, BUF_SIZE);
   mp3    = new AudioGeneratorMP3();
 
+  // from here on every HTTPS call is netTask's; TLS wants the big stack
+  xTaskCreatePinnedToCore(netTask, "net", 8192, nullptr, 1, &netTaskHandle, 0);
+
   Serial.println("Setup complete; monitoring...");
 }
 
+// Load the cry CNN from LittleFS into a fixed PSRAM arena. Without a model
+// the spectral detector alone decides, as before.
+void loadCryModel() {
+  if (!LittleFS.begin(false)) {
+    Serial.println("[CRY] no filesystem, spectral detector only");
+    return;
+  }
+  File f = LittleFS.open(CRY_MODEL_PATH, "r");
+  if (!f) {
+    Serial.println("[CRY] no model, spectral detector only");
+    return;
+  }
+  size_t len   = f.size();
+  uint8_t* blob  = (uint8_t*)malloc(len);
+  uint8_t* arena = (uint8_t*)heap_caps_malloc(CryClassifier::arenaSize(), MALLOC_CAP_SPIRAM);
+  if (!arena) arena = (uint8_t*)heap_caps_malloc(CryClassifier::arenaSize(), MALLOC_CAP_8BIT);
+  bool ok = blob && arena && f.read(blob, len) == len && cryClassifier.load(blob, len, arena);
+  f.close();
+  free(blob);
+  if (!ok) {
+    heap_caps_free(arena);
+    Serial.println("[CRY] model rejected, spectral detector only");
+    return;
+  }
+  Serial.printf("[CRY] model loaded, %u B arena\n", (unsigned)CryClassifier::arenaSize());
+}
+
+// The API server's CA from LittleFS (pio run -t uploadfs, data/api_ca.pem).
+// Without it the server can't be verified and no API call is made.
+bool loadApiCA() {
+  File f;
+  if (LittleFS.begin(false)) f = LittleFS.open(API_CA_PATH, "r");
+  if (!f) {
+    Serial.printf("[API] no %s, cloud calls disabled\n", API_CA_PATH);
+    return false;
+  }
+  apiCA = f.readString();
+  f.close();
+  return apiCA.length() > 0;
+}
+
+// Run one window frame through the detector(s); true once a cry is confirmed.
+bool classifyCryFrame(const int16_t* frame) {
+  // while the lullaby plays, strip its echo instead of going deaf
+  static int16_t ref[CRY_FRAME_SAMPLES];
+  bool playing = mp3->isRunning() && echoRef.latest(ref, CRY_FRAME_SAMPLES);
+  return cryWatch.frame(frame, playing ? ref : nullptr);
+}
+
+static uint32_t isqrt32(uint32_t v) {
+  uint32_t r = 0;
+  for (uint32_t bit = 1UL << 30; bit; bit >>= 2) {
+    if (v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+    else r >>= 1;
+  }
+  return r;
+}
+
+void updateSoundMeter() {
+  static int16_t frame[CRY_FRAME_SAMPLES];
+  while (meterReader.readFrame(frame, CRY_FRAME_SAMPLES)) {
+    soundMeter.add(frame, CRY_FRAME_SAMPLES, micDc);
+  }
+}
+
+// GET /levels?since=<seq>: next batch of per-second Leq/peak records
+void handleLevels() {
+  static char json[METER_BATCH * 16 + 128];
+  uint32_t since = server.hasArg("since") ? server.arg("since").toInt() : 0;
+  size_t   len   = soundMeter.writeJson(json, sizeof(json), since, METER_BATCH);
+  if (!len) {
+    server.send(500, "text/plain", "level batch too large");
+    return;
+  }
+  server.send(200, "application/json", json);
+}
+
+// Track DC and the noise floor from every mic frame and re-derive the
+// sound/cry thresholds. The lullaby is not room noise, so skip it.
+void updateNoiseFloor() {
+  static int16_t frame[CRY_FRAME_SAMPLES];
+  if (mp3->isRunning()) { levelReader.skipToLatest(); return; }
+  while (levelReader.readFrame(frame, CRY_FRAME_SAMPLES)) {
+    int32_t mean = cryWatch.noiseFrame(frame, noiseFloor);
+    micDc = micDcTrack.update(mean);
+    wakeScore.sound(cryWatch.lastVariance(), noiseFloor.floor(), millis());
+  }
+
+  uint32_t var = noiseFloor.floor();
+  int margin = SOUND_SIGMA_GAIN * (int)isqrt32(var);
+  soundThreshold = micDc + (margin > SOUND_MIN_MARGIN ? margin : SOUND_MIN_MARGIN);
+
+  static unsigned long lastSave = 0;
+  static uint32_t savedVar = noiseFloor.floor();  // as restored in setup()
+  if (millis() - lastSave >= NOISE_SAVE_MS) {
+    lastSave = millis();
+    uint32_t delta = var > savedVar ? var - savedVar : savedVar - var;
+    if (delta > savedVar / 8) {  // spare the flash when nothing moved
+      noisePrefs.putUInt("floor", var);
+      noisePrefs.putInt("dc", micDc);
+      savedVar = var;
+    }
+  }
+}
+
 void loop() {
   server.handleClient();
+  updateNoiseFloor();
+  updateSoundMeter();
   if (testMode) {
-    if (digitalRead(PIR_PIN)) sendMotionFeedback();
-    if (analogRead(MIC_PIN) > SOUND_THRESHOLD) sendSoundFeedback();
+    pirEdges.clear();  // test mode reports the live level
+    static unsigned long lastFeedback = 0;
+    if (millis() - lastFeedback >= TEST_FEEDBACK_MS) {
+      bool motion = digitalRead(PIR_PIN), sound = mic.latest() > soundThreshold;
+      if (motion) sendMotionFeedback();
+      if (sound)  sendSoundFeedback();
+      if (motion || sound) lastFeedback = millis();
+    }
     delay(100);
     return;
   }
 
+  // replay each queued edge at its own time, then check the hold now
+  static uint32_t windowStart = 0;
+  bool woke = false;
+  PirEdge edge;
+  while (pirEdges.pop(edge)) {
+    if (edge.high) wakeScore.pir(edge.ms());
+    woke |= nursery.pir(edge.high, edge.ms()) == Nursery::WOKE;
+  }
   unsigned long now = millis();
-  static unsigned long pirHighStart = 0;
-  static bool pirTriggered = false;
-  static unsigned long cryWindowStart = 0;
-  static int prevSound = 0, crySpikes = 0;
-
-  bool pir = digitalRead(PIR_PIN);
-  if (!pirTriggered && !mp3->isRunning()) {
-    if (pir) {
-      if (pirHighStart == 0) pirHighStart = now;
-      else if (now - pirHighStart >= PIR_HIGH_MS) {
-        pirTriggered   = true;
-        cryWindowStart = now;
-        prevSound      = analogRead(MIC_PIN);
-        crySpikes      = 0;
-        Serial.println(">> PIR HIGH → baby has some motions");
-        //sendPattern("move");
-        sendWarningToApp();
-        sendVibrateCommand();
-        sendPattern("sleep");
-        sendPattern("awake");
-        //playCloudSong();
-      }
+  woke |= nursery.pir(pirEdges.level(), now) == Nursery::WOKE;
+  if (woke) {
+    cryReader.skipToLatest();
+    windowStart = cryReader.position();
+    cryWatch.listen();
+    Serial.println(">> PIR HIGH → baby has some motions");
+    //sendPattern("move");
+    //playCloudSong();
+  }
+  static uint32_t camFrames = 0;
+  FrameDiff::Snapshot cam;
+  if (cameraMotion(&cam, nullptr) && cam.frames != camFrames) {
+    camFrames = cam.frames;
+    wakeScore.camera((uint32_t)((uint64_t)cam.total * 256 / (FrameDiff::W * FrameDiff::H)), now);
+  }
+
+  // window frames are timed by the audio clock from the moment of motion,
+  // so the HTTPS calls above don't eat into it; the reader catches up here
+  static int16_t frame[CRY_FRAME_SAMPLES];
+  Nursery::Action verdict = Nursery::NONE;
+  while (verdict == Nursery::NONE && nursery.listening()
+         && cryReader.readFrame(frame, CRY_FRAME_SAMPLES)) {
+    bool heard = classifyCryFrame(frame);
+    uint32_t audioMs = nursery.since() + (cryReader.position() - windowStart) * 1000 / MIC_SAMPLE_RATE;
+    verdict = nursery.cry(heard, audioMs, mp3->isRunning());
+  }
+  if (verdict == Nursery::SOOTHE || verdict == Nursery::ESCALATE) {
+    Serial.println(">> Cry detected! Baby is awake");
+    captureCryClip(cryReader.position());
+    wakeScore.cry(millis());  // raises the alert below if it isn't up yet
+    sleepLog.cry(cryWatch.detector().persistMs());
+    //sendImageToCloud();
+
+    if (verdict == Nursery::SOOTHE) {
+      Serial.printf(" Playing lullaby #%d\n", nursery.lullabies());
+      //startLullaby();
+      playCloudSong();
+      sleepLog.lullaby();
     } else {
-      pirHighStart = 0;
-      //sendPattern("sleep");
+      Serial.println(" Max lullabies → vibrate");
+      sendVibrateCommand();  // escalation always reaches the app
+      sleepLog.escalation();
+      appCalls++;
     }
+  } else if (verdict == Nursery::SETTLED) {
+    Serial.printf(">> Cry window expired (%u ms cry-like), baby sleeping\n", cryWatch.detector().persistMs());
   }
 
-  if (pirTriggered && !mp3->isRunning()) {
-    if (now - cryWindowStart <= CRY_WINDOW_MS) {
-      int v = analogRead(MIC_PIN);
-      if (abs(v - prevSound) > DIFF_THRESHOLD) crySpikes++;
-      prevSound = v;
-      if (crySpikes >= CRY_COUNT_THRESHOLD) {
-        Serial.println(">> Cry detected! Baby is awake");
-        sendWarningToApp();
-        sendPattern("awake");
-        //sendImageToCloud();
-
-        if (lullabyCount < MAX_LULLABIES) {
-          lullabyCount++;
-          Serial.printf(" Playing lullaby #%d\n", lullabyCount);
-          //startLullaby();
-          playCloudSong();
-        } else {
-          Serial.println(" Max lullabies → vibrate");
-          sendVibrateCommand();
-        }
-        pirTriggered = false;
-        pirHighStart = 0;
-      }
-    } else {
-      Serial.printf(">> Cry window expired (%d), baby sleeping\n", crySpikes);
-      sendPattern("sleep");
-      pirTriggered = false;
-      pirHighStart = 0;
+  // the app hears about it only once the evidence adds up, and once more
+  // when it has died down
+  WakeScore::Edge alert = wakeScore.update(millis());
+  if (alert == WakeScore::RAISED) {
+    Serial.printf(">> Wake score %u (PIR %u, sound %u, camera %u, cry %u) → alerting the app\n",
+                  wakeScore.score(), wakeScore.pirEvidence(), wakeScore.soundEvidence(),
+                  wakeScore.cameraEvidence(), wakeScore.cryEvidence());
+    sendCommand("vibrate");  // waits in the batch for the urgent one
+    sendWarningToApp();
+    sleepLog.awake(time(nullptr));
+    appCalls += 2;
+  } else if (alert == WakeScore::CLEARED) {
+    Serial.println(">> Wake score low again → back to sleep");
+    sleepLog.asleep(time(nullptr));
+  }
+
+  // the night's transitions go up as one summary once it closes
+  static unsigned long lastSummaryTry = 0;
+  static bool          summaryTried   = false;
+  if (sleepLog.poll(time(nullptr))) {
+    summaryTried = false;
+    cameraHeatClear();  // the heat map covers one night too
+  }
+  if (summarySent.exchange(false)) sleepLog.sent();
+  if (sleepLog.pending() && !summaryBusy && (!summaryTried || now - lastSummaryTry >= SUMMARY_RETRY_MS)) {
+    summaryTried   = true;
+    lastSummaryTry = now;
+    summaryBusy    = true;  // before netTask can clear it
+    if (!postEvent(NetEvent(EV_SUMMARY))) summaryBusy = false;
+    appCalls++;
+  }
+
+  // ship each clip once its post-roll has been frozen
+  for (int i = 0; i < CLIP_SLOTS; i++) {
+    if (cryClips[i].state() == AudioClip::READY && clipUploaded[i] != clipNumber[i]) {
+      postEvent(NetEvent(EV_CLIP, nullptr, i, clipNumber[i]));
+      clipUploaded[i] = clipNumber[i];  // one attempt; /clip still serves it
     }
   }
 
   static unsigned long lastBatt = 0;
   if (now - lastBatt >= 60000) {
     lastBatt = now;
-    int raw   = analogRead(BAT_ADC_PIN);
+    int raw   = mic.auxRaw();
     float vDiv= raw / (float)ADC_RES * ADC_REF;
     float vBat= vDiv * R_DIVIDER;
     float pct = voltageToPercent(vBat);
     Serial.printf("Battery: %.2f V (%.0f%%)\n", vBat, pct);
+    MicSampler::Stats ms = mic.stats();
+    Serial.printf("Mic: %u Hz, %u dropped, %u DMA overflows, %u reader overruns\n",
+                  ms.rateHz, ms.droppedSamples, ms.dmaOverflows, cryReader.overruns());
+    PirEdges::Stats ps = pirEdges.stats();
+    Serial.printf("PIR: %u edges, %u queue overflows, %u glitches, ISR max %u cyc, edge->logic %u ms (max %u)\n",
+                  ps.edges, ps.overflows, ps.glitches, ps.isrMaxCycles,
+                  ps.lastLatencyUs / 1000, ps.maxLatencyUs / 1000);
+    // share of one core if every frame were analysed
+    const CryDetector& cd = cryWatch.detector();
+    float cryLoad = cd.maxCycles() * (MIC_SAMPLE_RATE / (float)CRY_FRAME_SAMPLES)
+                    / (ESP.getCpuFreqMHz() * 1e6f) * 100.0f;
+    Serial.printf("App calls: %u sent (wake score now %u)\n", appCalls, wakeScore.score());
+    EventQueue::Stats qs = netEvents.stats();
+    uint32_t picked = qs.pushed - qs.depth;
+    Serial.printf("Net queue: %u waiting (max %u), %u sent, %u dropped, in queue last %u ms, avg %u ms, max %u ms\n",
+                  qs.depth, qs.maxDepth, picked, qs.dropped, qs.lastWaitMs,
+                  picked ? qs.totalWaitMs / picked : 0, qs.maxWaitMs);
+    const EventBatch::Stats& bs = netBatch.stats();
+    Serial.printf("Batches: %u with %u events (%u urgent, %u timed, %u full, %u flushed), held last %u ms, max %u ms%s\n",
+                  bs.batches, bs.events, bs.byReason[EventBatch::URGENT], bs.byReason[EventBatch::TIMER],
+                  bs.byReason[EventBatch::FULL], bs.byReason[EventBatch::BARRIER], bs.lastHoldMs,
+                  bs.maxHoldMs, batchApi ? "" : ", no /events: one by one");
+    const EventJournal::Stats& js = journal.stats();
+    Serial.printf("Journal: %u waiting, %u kept, %u replayed, %u dropped, %u torn segments, %u failed, append last %u us, max %u us\n",
+                  journal.pending(), js.appended, js.replayed, js.dropped, js.corrupt, js.failed,
+                  js.lastAppendUs, js.maxAppendUs);
+    const ApiLink::Stats& as = api.stats();
+    uint32_t reused = as.calls - as.connects - as.failures;
+    Serial.printf("API link: %u calls, %u connects (avg %u ms), %u reused (avg %u ms), %u expired, %u retried, %u failed, last %u ms, max %u ms\n",
+                  as.calls, as.connects, as.connects ? as.connectMs / as.connects : 0,
+                  reused, reused ? as.reuseMs / reused : 0, as.expired, as.retries,
+                  as.failures, as.lastMs, as.maxMs);
+    const TlsClient::Stats& ts = api.tlsStats();
+    Serial.printf("TLS: %u full (avg %u ms), %u resumed (avg %u ms), %u sessions refused, %u failed\n",
+                  ts.full, ts.full ? ts.fullMs / ts.full : 0, ts.resumed,
+                  ts.resumed ? ts.resumedMs / ts.resumed : 0, ts.refused, ts.failures);
+    const SleepLog::Night& night = sleepLog.night();
+    Serial.printf("Sleep log: %s, %u wakes, %u cries (%u ms), %u lullabies; %s, %u lost\n",
+                  night.awake ? "awake" : "asleep", night.wakes, night.cries, night.cryMs,
+                  night.lullabies, sleepLog.pending() ? "summary pending" : "nothing pending",
+                  sleepLog.lost());
+    Serial.printf("Noise floor: var %u, DC %d, sound thr %d\n",
+                  noiseFloor.floor(), micDc, soundThreshold);
+    Serial.printf("Cry DSP: %u cyc/frame (max %u), %.2f%% of a core\n",
+                  cd.lastCycles(), cd.maxCycles(), cryLoad);
+    Serial.printf("Echo suppression: %u cyc/frame (max %u, in the above), %u%% removed\n",
+                  cd.lastEchoCycles(), cd.maxEchoCycles(), cd.lastEchoPct());
+    if (cryClassifier.loaded()) {
+      Serial.printf("Cry CNN: %u cyc/inference (max %u), %u B PSRAM\n",
+                    cryClassifier.lastCycles(), cryClassifier.maxCycles(),
+                    (unsigned)CryClassifier::arenaSize());
+    }
+    FrameDiff::Snapshot cm;
+    uint32_t grabUs;
+    if (cameraMotion(&cm, &grabUs)) {
+      Serial.printf("Camera motion: %u, grab+decode %u us, diff %u cyc (max %u)\n",
+                    cm.total, grabUs, cm.lastCycles, cm.maxCycles);
+      BreathRate::Estimate br;
+      cameraBreath(&br);
+      Serial.printf("Breathing: %s, %u.%u bpm (quality %u)\n", BreathRate::stateName(br.state),
+                    br.bpmX10 / 10, br.bpmX10 % 10, br.quality);
+    }
   }
 
+  startCloudSong();
   if (mp3->isRunning()) mp3->loop();
   delay(10);
 }
 
+// Every HTTPS call after setup(), in the order loop() asked for them, on
+// core 0 next to the Wi-Fi stack. Events carry the time they happened.
+// Commands and patterns wait in netBatch; whatever else comes sends the
+// batch first. What can't be sent waits in the journal.
+void netTask(void*) {
+  for (;;) {
+    NetEvent e;
+    uint32_t now = millis();
+    if (!netEvents.pop(e, now)) {
+      // all that was queued together is in: send it if it's due
+      if (EventBatch::Reason why = netBatch.due(now)) {
+        sendBatch(why);
+        continue;
+      }
+      // then the journal, back to back until a batch fails
+      if (journal.pending() && (int32_t)(now - journalRetryAt) >= 0) {
+        if (!replayJournal()) journalRetryAt = millis() + JOURNAL_RETRY_MS;
+        continue;
+      }
+      uint32_t left = netBatch.msLeft(now);
+      if (journal.pending() && journalRetryAt - now < left) left = journalRetryAt - now;
+      ulTaskNotifyTake(pdTRUE, left == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(left));
+      continue;
+    }
+    if (e.kind == EV_COMMAND || e.kind == EV_PATTERN) {
+      // one by one without /events, so there's nothing to wait for
+      bool urgent = e.arg || !batchApi;
+      if (!netBatch.add(e, urgent)) {
+        sendBatch(EventBatch::FULL);
+        netBatch.add(e, urgent);
+      }
+      continue;
+    }
+    sendBatch(EventBatch::BARRIER);
+    switch (e.kind) {
+      case EV_SONG:
+        if (AudioFileSourceHTTPStream* src = openCloudSong()) {
+          delete songReady.exchange(src);  // one loop() never picked up
+        }
+        break;
+      case EV_CLIP: uploadCryClip(e.arg, e.id); break;
+      case EV_SUMMARY:
+        summarySent = uploadSleepSummary();
+        summaryBusy = false;
+        break;
+    }
+  }
+}
+
 // Helpers
 void initBleServer() {
   NimBLEDevice::init("BabyMonitor");
@@ -0,0 +1,187 @@
+// Round-trip check and benchmark for lib/ImaAdpcm, the codec cry clips are
+// uploaded in.
+//
+//   adpcm [options]
+//
+// Renders a synthetic nursery trace on the 12-bit, 8 kHz scale the mic ring
+// holds: a quiet room with a fan hum, then cries (a pitched, gliding
+// harmonic stack with a breathy noise floor) at a few levels, the loudest
+// clipping. It goes through adcToPcm16() and encodeBlock() into WAV/IMA
+// blocks, as ClipWavStream sends a clip, and back through decodeBlock().
+//
+// Checks that every code matches the branchy reference encoder of the IMA
+// spec and that the round trip keeps at least --min-snr-db in every
+// segment and overall; exits 1 if not. Prints JSON: SNR per segment and
+// overall, and the encode and decode rates in samples per second of this
+// host.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "ImaAdpcm.h"
+
+using namespace ima_adpcm;
+
+static const int    RATE    = 8000;
+static const int    ADC_MID = 2048;
+static const double PI      = 3.14159265358979323846;
+
+static void usage() {
+  fprintf(stderr,
+    "usage: adpcm [options]\n"
+    "  --seconds N       length of each segment (default 10)\n"
+    "  --min-snr-db DB   fail below this round-trip SNR (default 15)\n"
+    "  --reps N          encode/decode passes for the timing (default 20)\n");
+  exit(2);
+}
+
+struct Segment {
+  const char* name;
+  double      cryAmp;   // peak of the cry, ADC counts; 0 for room only
+};
+
+static const Segment SEGMENTS[] = {
+  { "room",      0    },
+  { "cry_soft",  150  },
+  { "cry_loud",  900  },
+  { "cry_clip",  2600 },   // past the rails: the ADC clips
+};
+
+// Deterministic white noise in [-1, 1).
+static uint32_t rng = 12345;
+static double noise() {
+  rng = rng * 1664525u + 1013904223u;
+  return (int32_t)rng / 2147483648.0;
+}
+
+static void render(const Segment& seg, int n, std::vector<int16_t>& adc) {
+  double phase = 0;
+  for (int i = 0; i < n; i++) {
+    double t   = (double)i / RATE;
+    double v   = 6 * noise() + 4 * sin(2 * PI * 100 * t);   // mic floor, fan hum
+    if (seg.cryAmp > 0) {
+      // 1 s bursts with pauses; the fundamental glides 400 -> 550 Hz
+      double in  = fmod(t, 1.5);
+      double env = in < 1.0 ? sin(PI * in) : 0;
+      double f0  = 400 + 150 * in;
+      phase += 2 * PI * f0 / RATE;
+      double cry = sin(phase) + 0.6 * sin(2 * phase) + 0.35 * sin(3 * phase) + 0.2 * sin(4 * phase);
+      v += env * seg.cryAmp * (cry / 2.15 + 0.1 * noise());
+    }
+    int s = ADC_MID + (int)lround(v);
+    adc.push_back((int16_t)(s < 0 ? 0 : s > 4095 ? 4095 : s));
+  }
+}
+
+// The IMA reference encoder, branches and all.
+static uint8_t referenceSample(State& s, int16_t sample) {
+  int step = STEP[s.index];
+  int diff = sample - s.predictor;
+  uint8_t sign = diff < 0 ? 8 : 0;
+  if (sign) diff = -diff;
+  uint8_t q = 0;
+  int vpdiff = step >> 3;
+  if (diff >= step) { q = 4; diff -= step; vpdiff += step; }
+  step >>= 1;
+  if (diff >= step) { q |= 2; diff -= step; vpdiff += step; }
+  step >>= 1;
+  if (diff >= step) { q |= 1; vpdiff += step; }
+  s.predictor = (int16_t)clamp16(s.predictor + (sign ? -vpdiff : vpdiff));
+  int idx = s.index + INDEX_DELTA[q];
+  s.index = (uint8_t)(idx < 0 ? 0 : idx > 88 ? 88 : idx);
+  return q | sign;
+}
+
+static double snrDb(const int16_t* ref, const int16_t* got, size_t n) {
+  double sig = 0, err = 0;
+  for (size_t i = 0; i < n; i++) {
+    sig += (double)ref[i] * ref[i];
+    err += (double)(ref[i] - got[i]) * (ref[i] - got[i]);
+  }
+  return err > 0 ? 10 * log10(sig / err) : 99;
+}
+
+int main(int argc, char** argv) {
+  double seconds = 10, minSnr = 15;
+  int    reps    = 20;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if      (!strcmp(a, "--seconds"))    seconds = atof(next());
+    else if (!strcmp(a, "--min-snr-db")) minSnr  = atof(next());
+    else if (!strcmp(a, "--reps"))       reps    = atoi(next());
+    else usage();
+  }
+  const int nseg    = sizeof(SEGMENTS) / sizeof(SEGMENTS[0]);
+  // whole blocks per segment, so each segment's SNR is its own blocks'
+  const int blocks  = (int)(seconds * RATE / SAMPLES_PER_BLOCK) > 0 ? (int)(seconds * RATE / SAMPLES_PER_BLOCK) : 1;
+  const int perSeg  = blocks * (int)SAMPLES_PER_BLOCK;
+
+  std::vector<int16_t> adc;
+  for (int k = 0; k < nseg; k++) render(SEGMENTS[k], perSeg, adc);
+  size_t n = adc.size(), nblocks = n / SAMPLES_PER_BLOCK;
+
+  std::vector<int16_t> pcm(n), out(n);
+  std::vector<uint8_t> enc(nblocks * BLOCK_BYTES);
+  adcToPcm16(adc.data(), n, ADC_MID, pcm.data());
+
+  // bit-exact against the reference, block by block as the stream does
+  size_t mismatches = 0;
+  State  s, r;
+  for (size_t b = 0; b < nblocks; b++) {
+    const int16_t* p = &pcm[b * SAMPLES_PER_BLOCK];
+    uint8_t*       o = &enc[b * BLOCK_BYTES];
+    encodeBlock(s, p, o);
+    r.predictor = p[0];
+    for (size_t i = 1; i < SAMPLES_PER_BLOCK; i++) {
+      uint8_t want = referenceSample(r, p[i]);
+      uint8_t got  = (o[4 + (i - 1) / 2] >> ((i - 1) % 2 * 4)) & 0x0F;
+      mismatches += want != got;
+    }
+  }
+  for (size_t b = 0; b < nblocks; b++) decodeBlock(&enc[b * BLOCK_BYTES], &out[b * SAMPLES_PER_BLOCK]);
+
+  // timing: the ADC pass and the encoder together, as a clip is streamed
+  std::vector<int16_t> scratch(SAMPLES_PER_BLOCK);
+  volatile uint8_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < reps; rep++) {
+    State e;
+    for (size_t b = 0; b < nblocks; b++) {
+      adcToPcm16(&adc[b * SAMPLES_PER_BLOCK], SAMPLES_PER_BLOCK, ADC_MID, scratch.data());
+      encodeBlock(e, scratch.data(), &enc[b * BLOCK_BYTES]);
+    }
+    sink ^= enc[rep % enc.size()];
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < reps; rep++) {
+    for (size_t b = 0; b < nblocks; b++) decodeBlock(&enc[b * BLOCK_BYTES], &out[b * SAMPLES_PER_BLOCK]);
+    sink ^= (uint8_t)out[rep % out.size()];
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  double encS = std::chrono::duration<double>(t1 - t0).count();
+  double decS = std::chrono::duration<double>(t2 - t1).count();
+
+  bool ok = mismatches == 0;
+  printf("{\n  \"samples\": %zu, \"blocks\": %zu, \"pcm_bytes\": %zu, \"adpcm_bytes\": %zu,\n",
+         n, nblocks, n * 2, enc.size());
+  printf("  \"snr_db\": {");
+  for (int k = 0; k < nseg; k++) {
+    double db = snrDb(&pcm[k * perSeg], &out[k * perSeg], perSeg);
+    if (db < minSnr) ok = false;
+    printf("%s\"%s\": %.1f", k ? ", " : "", SEGMENTS[k].name, db);
+  }
+  double all = snrDb(pcm.data(), out.data(), n);
+  if (all < minSnr) ok = false;
+  printf(", \"overall\": %.1f},\n", all);
+  printf("  \"reference_mismatches\": %zu, \"min_snr_db\": %.1f,\n", mismatches, minSnr);
+  printf("  \"perf\": {\"encode_msamples_per_s\": %.1f, \"decode_msamples_per_s\": %.1f},\n",
+         n * reps / encS / 1e6, n * reps / decS / 1e6);
+  printf("  \"pass\": %s\n}\n", ok ? "true" : "false");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+// Host benchmark for the camera breathing monitor.
+//
+// Runs a recorded frame sequence through lib/FrameDiff's decimation and
+// lib/BreathRate, the same path the firmware's motion task takes, and
+// prints the estimates, their error against a known rate and the cost per
+// frame and per estimate as JSON.
+//
+//   breath [options] frame0.pgm frame1.pgm ...
+//   breath [options] --raw 160x120 frames.gray
+//   breath [options] --synth 120
+//
+// Frames are 8-bit greyscale: binary PGM (P5) files in order, or one file
+// of raw frames back to back. --synth renders SECONDS of a textured crib
+// with a breathing patch instead, for runs without a recording.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "FrameDiff.h"
+#include "BreathRate.h"
+
+struct Frame {
+  int w = 0, h = 0;
+  std::vector<uint8_t> px;
+};
+
+static void usage() {
+  fprintf(stderr,
+    "usage: breath [options] <frames.pgm...>\n"
+    "  --raw WxH FILE         raw 8-bit frames back to back instead of PGMs\n"
+    "  --synth SECONDS        render a synthetic breathing sequence\n"
+    "  --synth-bpm N          its breathing rate (default 36)\n"
+    "  --synth-amp PX         its chest travel in source pixels (default 1.0)\n"
+    "  --synth-moves N        gross-motion bursts to add (default 0)\n"
+    "  --period-ms N          frame spacing (default 250)\n"
+    "  --roi X,Y,W,H          crib region on the 80x60 frame (default 20,15,40,30)\n"
+    "  --min-bpm N --max-bpm N  search range (default 10..80)\n"
+    "  --hop N                frames between estimates (default 4)\n"
+    "  --quality N            minimum Q8 peak (default 77)\n"
+    "  --move-level N         gross-motion level (default 2)\n"
+    "  --truth BPM            known rate, for the error summary\n"
+    "  --repeat N             run the sequence N times for timing (default 1)\n");
+  exit(2);
+}
+
+static bool readPgm(const char* path, Frame& f) {
+  FILE* fp = fopen(path, "rb");
+  if (!fp) return false;
+  char magic[3] = {};
+  int vals[3], got = 0;
+  bool ok = fscanf(fp, "%2s", magic) == 1 && !strcmp(magic, "P5");
+  while (ok && got < 3) {
+    int c = fgetc(fp);
+    if (c == '#') {
+      while (c != '\n' && c != EOF) c = fgetc(fp);
+    } else if (c >= '0' && c <= '9') {
+      ungetc(c, fp);
+      ok = fscanf(fp, "%d", &vals[got++]) == 1;
+    } else if (c == EOF) {
+      ok = false;
+    }
+  }
+  ok = ok && vals[2] == 255 && fgetc(fp) != EOF;
+  if (ok) {
+    f.w = vals[0];
+    f.h = vals[1];
+    f.px.resize((size_t)f.w * f.h);
+    ok = fread(f.px.data(), 1, f.px.size(), fp) == f.px.size();
+  }
+  fclose(fp);
+  return ok;
+}
+
+static bool readRaw(const char* path, int w, int h, std::vector<Frame>& out) {
+  FILE* fp = fopen(path, "rb");
+  if (!fp) return false;
+  Frame f;
+  f.w = w;
+  f.h = h;
+  f.px.resize((size_t)w * h);
+  while (fread(f.px.data(), 1, f.px.size(), fp) == f.px.size()) out.push_back(f);
+  fclose(fp);
+  return true;
+}
+
+// A 160x120 crib: smooth random texture, a chest patch sliding vertically
+// by `amp` pixels at `bpm`, sensor noise, and optional bursts where the
+// whole scene shifts (the baby turning over).
+static void synth(double seconds, double bpm, double amp, int moves, uint32_t periodMs,
+                  std::vector<Frame>& out) {
+  const int W = 160, H = 120;
+  srand(7);
+  std::vector<float> tex((size_t)(W + 8) * (H + 8));
+  for (float& v : tex) v = (float)(rand() % 256);
+  for (int pass = 0; pass < 3; pass++) {
+    std::vector<float> t2 = tex;
+    for (int y = 1; y < H + 7; y++)
+      for (int x = 1; x < W + 7; x++)
+        t2[y * (W + 8) + x] = (tex[y * (W + 8) + x] * 4 + tex[y * (W + 8) + x - 1] + tex[y * (W + 8) + x + 1] +
+                               tex[(y - 1) * (W + 8) + x] + tex[(y + 1) * (W + 8) + x]) / 8;
+    tex = t2;
+  }
+  auto at = [&](float x, float y) {
+    int xi = (int)x, yi = (int)y;
+    float fx = x - xi, fy = y - yi;
+    const float* p = &tex[(size_t)yi * (W + 8) + xi];
+    return (p[0] * (1 - fx) + p[1] * fx) * (1 - fy) + (p[W + 8] * (1 - fx) + p[W + 9] * fx) * fy;
+  };
+  int n = (int)(seconds * 1000 / periodMs);
+  for (int i = 0; i < n; i++) {
+    double t = i * periodMs / 1000.0;
+    float dy = (float)(amp * 0.5 * (1 - cos(2 * M_PI * bpm / 60 * t)));
+    float jolt = 0;
+    for (int m = 0; m < moves; m++) {
+      double tm = seconds * (m + 1) / (moves + 1);
+      if (t >= tm && t < tm + 2) jolt = 3;
+    }
+    Frame f;
+    f.w = W;
+    f.h = H;
+    f.px.resize((size_t)W * H);
+    for (int y = 0; y < H; y++) {
+      for (int x = 0; x < W; x++) {
+        bool chest = x >= 50 && x < 110 && y >= 40 && y < 90;
+        float v = at(x + 2 + jolt, y + 2 + (chest ? dy : 0) + jolt);
+        v += (rand() % 7) - 3;
+        f.px[(size_t)y * W + x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+      }
+    }
+    out.push_back(std::move(f));
+  }
+}
+
+int main(int argc, char** argv) {
+  BreathRateConfig cfg;
+  std::vector<const char*> files;
+  const char* raw = nullptr;
+  int rawW = 0, rawH = 0, moves = 0, repeat = 1;
+  double synthSec = 0, synthBpm = 36, synthAmp = 1.0, truth = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if (a == "--raw") {
+      if (sscanf(next(), "%dx%d", &rawW, &rawH) != 2) usage();
+      raw = next();
+    }
+    else if (a == "--synth")       synthSec = atof(next());
+    else if (a == "--synth-bpm")   synthBpm = atof(next());
+    else if (a == "--synth-amp")   synthAmp = atof(next());
+    else if (a == "--synth-moves") moves = atoi(next());
+    else if (a == "--period-ms")   cfg.periodMs = atoi(next());
+    else if (a == "--roi") {
+      unsigned x, y, w, h;
+      if (sscanf(next(), "%u,%u,%u,%u", &x, &y, &w, &h) != 4) usage();
+      cfg.x = x; cfg.y = y; cfg.w = w; cfg.h = h;
+    }
+    else if (a == "--min-bpm")     cfg.minBpm = atoi(next());
+    else if (a == "--max-bpm")     cfg.maxBpm = atoi(next());
+    else if (a == "--hop")         cfg.hop = atoi(next());
+    else if (a == "--quality")     cfg.minQuality = atoi(next());
+    else if (a == "--move-level")  cfg.moveLevel = atoi(next());
+    else if (a == "--truth")       truth = atof(next());
+    else if (a == "--repeat")      repeat = atoi(next());
+    else if (a[0] == '-')          usage();
+    else                           files.push_back(argv[i]);
+  }
+
+  std::vector<Frame> frames;
+  if (synthSec > 0) {
+    synth(synthSec, synthBpm, synthAmp, moves, cfg.periodMs, frames);
+    if (!truth) truth = synthBpm;
+  } else if (raw) {
+    if (!readRaw(raw, rawW, rawH, frames)) { fprintf(stderr, "can't read %s\n", raw); return 1; }
+  } else {
+    for (const char* path : files) {
+      Frame f;
+      if (!readPgm(path, f)) { fprintf(stderr, "can't read %s (binary 8-bit PGM expected)\n", path); return 1; }
+      frames.push_back(std::move(f));
+    }
+  }
+  if (frames.empty()) usage();
+
+  static uint16_t store[BreathRate::STORE_BYTES / sizeof(uint16_t)];
+  FrameDiff  diff;
+  BreathRate breath;
+  std::vector<BreathRate::Estimate> ests;
+  double loadNs = 0, addNs = 0, solveNs = 0, solveMax = 0;
+  int solves = 0;
+  for (int r = 0; r < repeat; r++) {
+    breath.begin(cfg, store);
+    ests.clear();
+    for (const Frame& f : frames) {
+      auto t0 = std::chrono::steady_clock::now();
+      diff.load(f.px.data(), f.w, f.h, f.w);
+      auto t1 = std::chrono::steady_clock::now();
+      bool made = breath.add(diff.frame(), FrameDiff::W, FrameDiff::H, FrameDiff::W);
+      loadNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+      addNs  += breath.addCycles();  // ns on the host
+      if (made) {
+        solveNs += breath.lastCycles();
+        solveMax = std::max(solveMax, (double)breath.lastCycles());
+        solves++;
+        ests.push_back(breath.estimate());
+      }
+    }
+  }
+
+  printf("{\n  \"estimates\": [");
+  int breathing = 0;
+  std::vector<double> bpms;
+  double errSum = 0, errMax = 0;
+  for (size_t i = 0; i < ests.size(); i++) {
+    const BreathRate::Estimate& e = ests[i];
+    printf("%s\n    {\"t_ms\": %u, \"state\": \"%s\", \"bpm\": %.1f, \"quality\": %u}", i ? "," : "",
+           e.frame * cfg.periodMs, BreathRate::stateName(e.state), e.bpmX10 / 10.0, e.quality);
+    if (e.state != BreathRate::BREATHING) continue;
+    breathing++;
+    bpms.push_back(e.bpmX10 / 10.0);
+    if (truth > 0) {
+      double err = fabs(e.bpmX10 / 10.0 - truth);
+      errSum += err;
+      errMax = std::max(errMax, err);
+    }
+  }
+  std::sort(bpms.begin(), bpms.end());
+  printf("\n  ],\n  \"summary\": {\"frames\": %zu, \"seconds\": %.1f, \"estimates\": %zu, \"breathing\": %d",
+         frames.size(), frames.size() * cfg.periodMs / 1000.0, ests.size(), breathing);
+  if (!bpms.empty()) printf(", \"median_bpm\": %.1f", bpms[bpms.size() / 2]);
+  if (truth > 0 && breathing) {
+    printf(", \"truth_bpm\": %.1f, \"mean_abs_err\": %.2f, \"max_abs_err\": %.2f", truth, errSum / breathing, errMax);
+  }
+  double nf = (double)frames.size() * repeat;
+  printf("},\n  \"perf\": {\"decimate_ns_per_frame\": %.0f, \"cells_ns_per_frame\": %.0f, "
+         "\"estimate_ns_mean\": %.0f, \"estimate_ns_max\": %.0f, \"store_bytes\": %zu}\n}\n",
+         loadNs / nf, addNs / nf, solves ? solveNs / solves : 0.0, solveMax, BreathRate::STORE_BYTES);
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Accuracy check and benchmark for CryDetector's scalar FFT, the radix-2
+// fallback lib/CryDetector runs wherever esp-dsp isn't available.
+//
+//   fftbench [options]
+//
+// Fixed 8 kHz frames (tones on and between bins, a cry-like harmonic stack,
+// white noise at a few levels, a clipping tone) go through
+// CryDetector::process(). The power spectrum it leaves is compared with a
+// double-precision DFT of the same input: the frame prepared exactly as
+// load() does (mean removed, x8 into Q15, the Q15 Hann window) and scaled
+// by 1/N, as the fixed-point FFT halves every stage. Per frame it reports
+// the spectral SNR (reference energy over the energy of the magnitude
+// error) and the worst bin's magnitude error in Q15 LSBs. Every frame must
+// stay within --max-err-lsb: the rounding of eight halving stages leaves
+// an error of a couple of LSBs whatever the level. Frames at the levels
+// cries are detected at must also keep --min-snr-db; on the quiet ones
+// that same floor is most of the signal, so their SNR is only reported.
+//
+// Then it times process() over the frames: ns per frame and, on x86, TSC
+// ticks per frame. These are this host's numbers, not the ESP32-S3's; the
+// firmware reports its own cycles in the status line (lastCycles()).
+//
+// Prints JSON; exits 1 if a check fails.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+#include "CryDetector.h"
+
+static const int    RATE    = 8000;
+static const int    FRAME   = CryDetector::FRAME;
+static const int    BINS    = FRAME / 2;
+static const int    ADC_MID = 2048;
+static const double PI      = 3.14159265358979323846;
+
+static void usage() {
+  fprintf(stderr,
+    "usage: fftbench [options]\n"
+    "  --min-snr-db DB    fail a loud frame below this spectral SNR (default 38)\n"
+    "  --max-err-lsb N    fail above this bin magnitude error, Q15 (default 4)\n"
+    "  --reps N           passes over the frames for the timing (default 2000)\n");
+  exit(2);
+}
+
+struct Signal {
+  const char* name;
+  double      toneHz;   // 0 for none
+  double      toneAmp;  // peak, ADC counts
+  double      noise;    // white noise, RMS counts
+  double      cry;      // peak of a 430 Hz harmonic stack
+  bool        loud;     // held to --min-snr-db
+};
+
+static const Signal SIGNALS[] = {
+  { "tone_on_bin",   500,    400,  1,   0,   true  },   // bin 16
+  { "tone_off_bin",  515.6,  400,  1,   0,   true  },   // bin 16.5
+  { "tone_quiet",    1000,   20,   1,   0,   false },
+  { "cry",           0,      0,    6,   500, true  },
+  { "noise_low",     0,      0,    6,   0,   false },   // a quiet room
+  { "noise_high",    0,      0,    300, 0,   true  },
+  { "tone_clip",     750,    2600, 0,   0,   true  },   // past the rails
+};
+
+// Deterministic white noise in [-1, 1).
+static uint32_t rng = 12345;
+static double noise() {
+  rng = rng * 1664525u + 1013904223u;
+  return (int32_t)rng / 2147483648.0;
+}
+
+static void render(const Signal& s, int16_t* x) {
+  for (int i = 0; i < FRAME; i++) {
+    double t = (double)i / RATE;
+    double v = s.toneAmp * sin(2 * PI * s.toneHz * t) + s.noise * sqrt(3.0) * noise();
+    for (int h = 1; h <= 4; h++) v += s.cry / (h * 1.5) * sin(2 * PI * 430 * h * t + h);
+    int a = ADC_MID + (int)lround(v);
+    x[i] = (int16_t)(a < 0 ? 0 : a > 4095 ? 4095 : a);
+  }
+}
+
+// The spectrum in double, on the input process() gives the FFT.
+static void reference(const int16_t* x, double* mag) {
+  static int16_t window[FRAME];
+  for (int i = 0; i < FRAME; i++) {
+    window[i] = (int16_t)(32767.0f * 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / FRAME)));
+  }
+  int32_t mean = 0;
+  for (int i = 0; i < FRAME; i++) mean += x[i];
+  mean /= FRAME;
+  double in[FRAME];
+  for (int i = 0; i < FRAME; i++) {
+    int32_t v = (x[i] - mean) << 3;
+    if (v > 32767) v = 32767; else if (v < -32768) v = -32768;
+    in[i] = (v * window[i]) >> 15;
+  }
+  for (int k = 0; k < BINS; k++) {
+    double re = 0, im = 0;
+    for (int i = 0; i < FRAME; i++) {
+      re += in[i] * cos(2 * PI * k * i / FRAME);
+      im -= in[i] * sin(2 * PI * k * i / FRAME);
+    }
+    mag[k] = k ? sqrt(re * re + im * im) / FRAME : 0;   // process() drops DC
+  }
+}
+
+int main(int argc, char** argv) {
+  double minSnr = 38, maxErr = 4;
+  int    reps   = 2000;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if      (!strcmp(a, "--min-snr-db"))  minSnr = atof(next());
+    else if (!strcmp(a, "--max-err-lsb")) maxErr = atof(next());
+    else if (!strcmp(a, "--reps"))        reps   = atoi(next());
+    else usage();
+  }
+
+  const int nsig = sizeof(SIGNALS) / sizeof(SIGNALS[0]);
+  static int16_t frames[sizeof(SIGNALS) / sizeof(SIGNALS[0])][FRAME];
+  CryDetector det;
+  det.begin();
+  bool ok = true;
+
+  printf("{\n  \"frames\": [\n");
+  for (int s = 0; s < nsig; s++) {
+    render(SIGNALS[s], frames[s]);
+    det.process(frames[s]);
+    double ref[BINS], sig = 0, err = 0, worst = 0;
+    reference(frames[s], ref);
+    for (int k = 1; k < BINS; k++) {
+      double got = sqrt((double)det.power()[k]);
+      double d   = got - ref[k];
+      sig  += ref[k] * ref[k];
+      err  += d * d;
+      worst = fmax(worst, fabs(d));
+    }
+    double snr = err > 0 ? 10 * log10(sig / err) : 99;
+    if ((SIGNALS[s].loud && snr < minSnr) || worst > maxErr) ok = false;
+    printf("    {\"frame\": \"%s\", \"loud\": %s, \"snr_db\": %.1f, \"max_err_lsb\": %.2f}%s\n",
+           SIGNALS[s].name, SIGNALS[s].loud ? "true" : "false", snr, worst, s + 1 < nsig ? "," : "");
+  }
+
+  // timing: process() as loop() calls it, frame after frame
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+#if HAVE_TSC
+  uint64_t c0 = __rdtsc();
+#endif
+  for (int rep = 0; rep < reps; rep++) {
+    for (int s = 0; s < nsig; s++) sink += det.process(frames[s]);
+  }
+#if HAVE_TSC
+  uint64_t c1 = __rdtsc();
+#endif
+  auto t1 = std::chrono::steady_clock::now();
+  double n = (double)reps * nsig;
+  printf("  ],\n  \"min_snr_db\": %.1f, \"max_err_lsb\": %.1f,\n", minSnr, maxErr);
+  printf("  \"perf\": {\"frames\": %.0f, \"ns_per_frame\": %.0f", n,
+         std::chrono::duration<double, std::nano>(t1 - t0).count() / n);
+#if HAVE_TSC
+  printf(", \"tsc_per_frame\": %.0f", (c1 - c0) / n);
+#endif
+  printf("},\n  \"pass\": %s\n}\n", ok ? "true" : "false");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+// Reference check for the fixed-point MFCC front end (lib/CryClassifier/Mfcc.h).
+//
+//   mfcc [options]
+//
+// First the constexpr tables: the mel bin map, the log2 mantissa table and
+// the DCT are rebuilt in double with <math.h> and must match to within 1
+// LSB (Q15 weights, Q8 log2, Q15 DCT), every bin on the same filter.
+//
+// Then the features: fixed 8 kHz frames (silence, a mic-noise floor, a
+// tone, a cry-like harmonic stack, a fan hum, white noise, a clipping cry)
+// go through CryDetector as CryWatch runs them, and the power spectrum it
+// leaves is fed both to CryWatch::CryMfcc::compute() and to a double
+// precision MFCC (triangular mel filters, log2(energy + 1), orthonormal
+// DCT-II, scaled to Q8). Every log mel energy and coefficient must be
+// within --tolerance Q8 units (1/256 of a log2 unit, ~0.012 dB) of the
+// reference.
+//
+// Prints JSON: the table errors and, per frame, the worst error of the
+// log mel energies and of the coefficients; exits 1 if a check fails.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "CryDetector.h"
+#include "CryWatch.h"
+
+typedef CryWatch::CryMfcc M;
+
+static const int    RATE    = CryWatch::MFCC_RATE;
+static const int    FRAME   = CryWatch::FRAME;
+static const int    ADC_MID = 2048;
+static const int    F_LO    = 100, F_HI = RATE / 2;   // Mfcc's defaults
+static const double PI      = 3.14159265358979323846;
+
+static void usage() {
+  fprintf(stderr,
+    "usage: mfcc [options]\n"
+    "  --tolerance Q8   allowed feature error, Q8 log2 units (default 8)\n");
+  exit(2);
+}
+
+struct Signal {
+  const char* name;
+  double      noise;    // white noise, ADC counts RMS
+  double      tone;     // peak of a pure 1 kHz tone
+  double      hum;      // peak of a 100 Hz fan hum and its 2nd harmonic
+  double      cry;      // peak of a 450 Hz harmonic stack
+};
+
+static const Signal SIGNALS[] = {
+  { "silence",     0,   0,   0,  0    },
+  { "mic_floor",   6,   0,   0,  0    },
+  { "tone_1k",     2,   300, 0,  0    },
+  { "cry",         6,   0,   0,  500  },
+  { "fan_hum",     6,   0,   60, 0    },
+  { "white_noise", 200, 0,   0,  0    },
+  { "cry_clip",    6,   0,   0,  3000 },   // past the rails
+};
+
+// Deterministic white noise in [-1, 1).
+static uint32_t rng = 12345;
+static double noise() {
+  rng = rng * 1664525u + 1013904223u;
+  return (int32_t)rng / 2147483648.0;
+}
+
+static void render(const Signal& s, int16_t* x) {
+  for (int i = 0; i < FRAME; i++) {
+    double t = (double)i / RATE;
+    double v = s.noise * sqrt(3.0) * noise()
+             + s.tone * sin(2 * PI * 1000 * t)
+             + s.hum * (sin(2 * PI * 100 * t) + 0.5 * sin(2 * PI * 200 * t));
+    for (int h = 1; h <= 4; h++) v += s.cry / (h * 1.5) * sin(2 * PI * 450 * h * t + h);
+    int a = ADC_MID + (int)lround(v);
+    x[i] = (int16_t)(a < 0 ? 0 : a > 4095 ? 4095 : a);
+  }
+}
+
+static double hzToMel(double hz)  { return 2595.0 * log10(1.0 + hz / 700.0); }
+static double melToHz(double mel) { return 700.0 * (pow(10.0, mel / 2595.0) - 1.0); }
+
+// Filterbank edges in FFT bins: N_MELS triangles over N_MELS + 2 edges.
+static double edge[M::N_MELS + 2];
+
+// The textbook MFCC in double, Q8 log2 units.
+static void reference(const uint32_t* power, double* out, double* logMel) {
+  for (int m = 0; m < M::N_MELS; m++) {
+    double e = 0;
+    for (int k = 0; k < M::BINS; k++) {
+      double w = 0;
+      if (k >= edge[m] && k < edge[m + 1])          w = (k - edge[m]) / (edge[m + 1] - edge[m]);
+      else if (k >= edge[m + 1] && k < edge[m + 2]) w = (edge[m + 2] - k) / (edge[m + 2] - edge[m + 1]);
+      e += w * power[k];
+    }
+    logMel[m] = 256 * log2(e + 1);
+  }
+  for (int n = 0; n < M::N_MFCC; n++) {
+    double scale = sqrt((n == 0 ? 1.0 : 2.0) / M::N_MELS), acc = 0;
+    for (int m = 0; m < M::N_MELS; m++) acc += logMel[m] * cos(PI * n * (m + 0.5) / M::N_MELS);
+    out[n] = scale * acc;
+  }
+}
+
+int main(int argc, char** argv) {
+  double tolerance = 8;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if (!strcmp(a, "--tolerance")) tolerance = atof(next());
+    else usage();
+  }
+
+  // tables
+  double lo = hzToMel(F_LO), hi = hzToMel(F_HI);
+  for (int i = 0; i < M::N_MELS + 2; i++) {
+    edge[i] = melToHz(lo + (hi - lo) * i / (M::N_MELS + 1)) * (2 * M::BINS) / RATE;
+  }
+  int    filterMismatches = 0;
+  double weightErr = 0, log2Err = 0, dctErr = 0;
+  for (int k = 0; k < M::BINS; k++) {
+    int    f = -1;
+    double w = 0;
+    for (int i = 0; i < M::N_MELS + 1; i++) {
+      if (k >= edge[i] && k < edge[i + 1]) { f = i; w = 32768 * (k - edge[i]) / (edge[i + 1] - edge[i]); }
+    }
+    if (f != M::binMap.filter[k]) filterMismatches++;
+    else if (f >= 0)              weightErr = fmax(weightErr, fabs(M::binMap.weight[k] - w));
+  }
+  for (int i = 0; i < 256; i++) {
+    log2Err = fmax(log2Err, fabs(M::log2Q8.v[i] - fmin(255, 256 * log2(1 + i / 256.0))));
+  }
+  for (int n = 0; n < M::N_MFCC; n++) {
+    double scale = sqrt((n == 0 ? 1.0 : 2.0) / M::N_MELS);
+    for (int m = 0; m < M::N_MELS; m++) {
+      dctErr = fmax(dctErr, fabs(M::dct.v[n][m] - 32767 * scale * cos(PI * n * (m + 0.5) / M::N_MELS)));
+    }
+  }
+  bool ok = filterMismatches == 0 && weightErr <= 1 && log2Err <= 1 && dctErr <= 1;
+  printf("{\n  \"tables\": {\"filter_mismatches\": %d, \"weight_err_q15\": %.2f, "
+         "\"log2_err_q8\": %.2f, \"dct_err_q15\": %.2f},\n",
+         filterMismatches, weightErr, log2Err, dctErr);
+
+  // features, on the spectrum CryDetector leaves
+  printf("  \"tolerance_q8\": %.1f,\n  \"frames\": [\n", tolerance);
+  const int nsig = sizeof(SIGNALS) / sizeof(SIGNALS[0]);
+  for (int s = 0; s < nsig; s++) {
+    int16_t x[FRAME];
+    render(SIGNALS[s], x);
+    CryDetector det;
+    det.begin();
+    det.process(x);
+
+    int32_t out[M::N_MFCC], logMel[M::N_MELS];
+    double  refOut[M::N_MFCC], refMel[M::N_MELS];
+    M::compute(det.power(), out, logMel);
+    reference(det.power(), refOut, refMel);
+    double melErr = 0, coefErr = 0;
+    for (int m = 0; m < M::N_MELS; m++) melErr  = fmax(melErr,  fabs(logMel[m] - refMel[m]));
+    for (int n = 0; n < M::N_MFCC; n++) coefErr = fmax(coefErr, fabs(out[n] - refOut[n]));
+    if (melErr > tolerance || coefErr > tolerance) ok = false;
+    printf("    {\"frame\": \"%s\", \"c0\": %d, \"c0_ref\": %.1f, \"log_mel_err_q8\": %.2f, \"mfcc_err_q8\": %.2f}%s\n",
+           SIGNALS[s].name, (int)out[0], refOut[0], melErr, coefErr, s + 1 < nsig ? "," : "");
+  }
+  printf("  ],\n  \"pass\": %s\n}\n", ok ? "true" : "false");
+  return ok ? 0 : 1;
+}
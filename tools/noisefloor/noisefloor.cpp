@@ -0,0 +1,245 @@
+// Convergence check for lib/NoiseFloor on room traces, synthetic or
+// recorded.
+//
+//   noisefloor [options] [trace.wav|trace.csv]
+//
+// Renders one continuous 12-bit, 8 kHz mic trace through a night of rooms:
+// a quiet nursery, the same with cries, a fan's tonal hum, a white-noise
+// machine on top, and back to quiet. The mic's bias sits off mid-scale.
+// Every FRAME goes through CryWatch::noiseFrame() into a NoiseFloor begun
+// as the firmware begins it, from 0 as on a fresh device, and its mean
+// into the DcTracker updateNoiseFloor() keeps.
+//
+// Per room, the reference is the --percentile of its room-noise frame
+// variances (cry frames left out: the floor should ignore them). The check
+// is that the floor comes within --tolerance of it within --max-settle-s
+// of the room changing and stays there from then to the end of the room,
+// and that the DC estimate ends within 1 count of the bias. Prints JSON per
+// room: the reference, the floor at the end, the settle time and the worst
+// error after --max-settle-s; exits 1 if a check fails.
+//
+// Given a recorded trace (WAV or CSV, loaded as tools/replay loads it) the
+// whole trace is one room: the reference is the --percentile of its frame
+// variances outside the --labels cry spans, and the same settle and
+// tracking check runs on it, from the --floor a reboot would restore. It
+// also reports the thresholds the floor ends up setting in src/main.cpp:
+// CryWatch's cry band energy and the test-mode sound level.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "CryWatch.h"
+#include "NoiseFloor.h"
+#include "Trace.h"
+
+static const int    FRAME = CryWatch::FRAME;
+static const int    BIAS  = 2088;    // the mic's DC, off the 2048 default
+static const double PI    = 3.14159265358979323846;
+
+// src/main.cpp's test-mode sound check
+static const int SOUND_SIGMA_GAIN = 4;
+static const int SOUND_MIN_MARGIN = 100;
+
+static void usage() {
+  fprintf(stderr,
+    "usage: noisefloor [options] [trace.wav|trace.csv]\n"
+    "  --seconds N        length of each synthetic room (default 240)\n"
+    "  --percentile P     NoiseFloor percentile (default 20, as the firmware)\n"
+    "  --rate-shift S     NoiseFloor rate shift (default 7, as the firmware)\n"
+    "  --tolerance F      allowed relative error of the floor (default 0.25)\n"
+    "  --max-settle-s N   fail if a room takes longer to settle (default 120)\n"
+    " with a trace:\n"
+    "  --labels FILE      cry spans to leave out, CSV start_ms,end_ms\n"
+    "  --rate HZ          sample rate of a CSV trace (8000)\n"
+    "  --floor VAR        noise floor restored at boot (0)\n");
+  exit(2);
+}
+
+struct Room {
+  const char* name;
+  double      noise;    // white noise, ADC counts RMS
+  double      hum;      // 100 Hz fan hum, peak counts
+  double      cryAmp;   // peak of the cries, 0 for none
+};
+
+static const Room ROOMS[] = {
+  { "quiet",       6,  0,  0   },
+  { "quiet_cries", 6,  0,  600 },   // 1 s cry every 8 s: 1/8 of the frames
+  { "fan_hum",     6,  20, 0   },   // step up, tonal
+  { "white_noise", 25, 20, 0   },   // step up again, broadband
+  { "quiet_again", 6,  0,  0   },   // step down
+};
+
+// Deterministic Gaussian noise, unit variance.
+static uint32_t rng = 12345;
+static double uniform() {
+  rng = rng * 1664525u + 1013904223u;
+  return (rng >> 8) / 16777216.0;
+}
+static double gauss() {
+  double u = uniform() + 1e-12, v = uniform();
+  return sqrt(-2 * log(u)) * cos(2 * PI * v);
+}
+
+// One frame of `room` starting at sample `at`; true if a cry is in it.
+static bool render(const Room& room, long at, int16_t* x) {
+  bool cry = false;
+  for (int i = 0; i < FRAME; i++) {
+    double t = (double)(at + i) / RATE;
+    double v = room.noise * gauss() + room.hum * sin(2 * PI * 100 * t);
+    double in = fmod(t, 8.0);
+    if (room.cryAmp > 0 && in < 1.0) {
+      double f0 = 400 + 150 * in;
+      v  += sin(PI * in) * room.cryAmp * sin(2 * PI * f0 * t);
+      cry = true;
+    }
+    int s = BIAS + (int)lround(v);
+    x[i] = (int16_t)(s < 0 ? 0 : s > 4095 ? 4095 : s);
+  }
+  return cry;
+}
+
+struct Result {
+  double   reference;
+  uint32_t floorEnd;
+  double   settleS;    // -1: never settled
+  double   worstAfter; // relative error after maxSettle
+};
+
+// The floor after every frame of a room against the percentile of its
+// quiet frames' variances: settled at the first frame within tolerance;
+// tracking is the worst error once the settle time allowed is over.
+static Result evaluate(const std::vector<uint32_t>& floors, std::vector<uint32_t> quiet, int percentile,
+                       double tolerance, double maxSettle, bool& ok) {
+  const double frameS = (double)FRAME / RATE;
+  const int    frames = (int)floors.size();
+  Result r;
+  std::sort(quiet.begin(), quiet.end());
+  r.reference = quiet.empty() ? 0 : quiet[(quiet.size() - 1) * percentile / 100];
+  r.floorEnd  = floors.empty() ? 0 : floors.back();
+  auto err = [&](uint32_t v) { return r.reference ? fabs(v - r.reference) / r.reference : (v ? 1.0 : 0.0); };
+  int settled = 0;
+  while (settled < frames && err(floors[settled]) > tolerance) settled++;
+  r.settleS    = settled < frames ? settled * frameS : -1;
+  r.worstAfter = 0;
+  for (int f = (int)(maxSettle / frameS); f < frames; f++) r.worstAfter = std::max(r.worstAfter, err(floors[f]));
+  if (r.settleS < 0 || r.settleS > maxSettle || r.worstAfter > tolerance) ok = false;
+  return r;
+}
+
+// A recorded trace as a single room.
+static int runTrace(const char* path, const char* labelPath, uint32_t csvRate, uint32_t floorInit,
+                    int percentile, int rateShift, double tolerance, double maxSettle) {
+  std::vector<int16_t> adc;
+  if (!loadMic(path, csvRate, adc)) {
+    fprintf(stderr, "noisefloor: can't read %s\n", path);
+    return 2;
+  }
+  struct Span { long start, end; };
+  std::vector<Span> labels;
+  if (labelPath && !loadCsv(labelPath, [&](long a, long b) { labels.push_back({ a, b }); })) {
+    fprintf(stderr, "noisefloor: can't read %s\n", labelPath);
+    return 2;
+  }
+
+  CryWatchConfig cfg;
+  CryWatch watch;
+  watch.begin(cfg);
+  NoiseFloor floor;
+  floor.begin(percentile, rateShift);
+  floor.restore(floorInit);
+  DcTracker dc(4);   // as updateNoiseFloor() runs it
+
+  const int frames = (int)(adc.size() / FRAME);
+  std::vector<uint32_t> floors(frames), quiet;
+  int dcNow = ADC_MID;
+  for (int f = 0; f < frames; f++) {
+    dcNow     = dc.update(watch.noiseFrame(&adc[(size_t)f * FRAME], floor));
+    floors[f] = floor.floor();
+    long t0 = (long)f * FRAME * 1000 / RATE, t1 = (long)(f + 1) * FRAME * 1000 / RATE;
+    bool cry = false;
+    for (const Span& l : labels) cry |= t0 <= l.end && t1 >= l.start;
+    if (!cry) quiet.push_back(watch.lastVariance());
+  }
+  bool ok = frames > 0;
+  Result r = evaluate(floors, quiet, percentile, tolerance, maxSettle, ok);
+
+  int margin = SOUND_SIGMA_GAIN * (int)sqrt((double)r.floorEnd);
+  printf("{\n  \"trace\": \"%s\", \"seconds\": %.1f, \"frames\": %d, \"percentile\": %d, \"rate_shift\": %d,\n",
+         path, (double)adc.size() / RATE, frames, percentile, rateShift);
+  printf("  \"tolerance\": %.2f, \"max_settle_s\": %.0f, \"floor_init\": %u,\n", tolerance, maxSettle, floorInit);
+  printf("  \"reference\": %.0f, \"floor\": %u, \"settle_s\": %.1f, \"worst_error\": %.3f,\n",
+         r.reference, r.floorEnd, r.settleS, r.worstAfter);
+  printf("  \"threshold\": {\"cry_band_energy\": %u, \"sound_level\": %d, \"dc\": %d},\n",
+         floor.threshold(cfg.energyPerVar * cfg.energyGain, cfg.minEnergy),
+         dcNow + std::max(margin, SOUND_MIN_MARGIN), dcNow);
+  printf("  \"pass\": %s\n}\n", ok ? "true" : "false");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  double seconds = 240, tolerance = 0.25, maxSettle = 120;
+  int    percentile = 20, rateShift = 7;
+  uint32_t csvRate = RATE, floorInit = 0;
+  const char *tracePath = nullptr, *labelPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if      (!strcmp(a, "--seconds"))      seconds    = atof(next());
+    else if (!strcmp(a, "--percentile"))   percentile = atoi(next());
+    else if (!strcmp(a, "--rate-shift"))   rateShift  = atoi(next());
+    else if (!strcmp(a, "--tolerance"))    tolerance  = atof(next());
+    else if (!strcmp(a, "--max-settle-s")) maxSettle  = atof(next());
+    else if (!strcmp(a, "--labels"))       labelPath  = next();
+    else if (!strcmp(a, "--rate"))         csvRate    = atoi(next());
+    else if (!strcmp(a, "--floor"))        floorInit  = atoi(next());
+    else if (a[0] == '-' || tracePath)     usage();
+    else tracePath = a;
+  }
+  if (percentile < 1 || percentile > 99 || rateShift < 1 || seconds <= 0 || !csvRate) usage();
+  if (tracePath) return runTrace(tracePath, labelPath, csvRate, floorInit, percentile, rateShift, tolerance, maxSettle);
+
+  CryWatch watch;
+  watch.begin(CryWatchConfig());
+  NoiseFloor floor;
+  floor.begin(percentile, rateShift);
+  DcTracker dc(4);   // as updateNoiseFloor() runs it
+
+  const int nroom  = sizeof(ROOMS) / sizeof(ROOMS[0]);
+  const int frames = (int)(seconds * RATE / FRAME);
+  const double frameS = (double)FRAME / RATE;
+  std::vector<Result> results(nroom);
+  int16_t x[FRAME];
+  long    at = 0;
+  int     dcNow = 0;
+  bool    ok = true;
+
+  for (int k = 0; k < nroom; k++) {
+    std::vector<uint32_t> floors(frames), quiet;
+    for (int f = 0; f < frames; f++, at += FRAME) {
+      bool cry = render(ROOMS[k], at, x);
+      dcNow    = dc.update(watch.noiseFrame(x, floor));
+      floors[f] = floor.floor();
+      if (!cry) quiet.push_back(watch.lastVariance());
+    }
+    results[k] = evaluate(floors, quiet, percentile, tolerance, maxSettle, ok);
+  }
+  if (abs(dcNow - BIAS) > 1) ok = false;
+
+  printf("{\n  \"frames_per_room\": %d, \"frame_ms\": %.1f, \"percentile\": %d, \"rate_shift\": %d,\n",
+         frames, frameS * 1000, percentile, rateShift);
+  printf("  \"tolerance\": %.2f, \"max_settle_s\": %.0f,\n  \"rooms\": [\n", tolerance, maxSettle);
+  for (int k = 0; k < nroom; k++) {
+    const Result& r = results[k];
+    printf("    {\"room\": \"%s\", \"reference\": %.0f, \"floor\": %u, \"settle_s\": %.1f, \"worst_error\": %.3f}%s\n",
+           ROOMS[k].name, r.reference, r.floorEnd, r.settleS, r.worstAfter, k + 1 < nroom ? "," : "");
+  }
+  printf("  ],\n  \"dc\": {\"bias\": %d, \"estimate\": %d},\n", BIAS, dcNow);
+  printf("  \"pass\": %s\n}\n", ok ? "true" : "false");
+  return ok ? 0 : 1;
+}
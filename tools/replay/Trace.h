@@ -0,0 +1,121 @@
+#pragma once
+// Recorded-night loading shared by the host tools in this directory: mic
+// traces (WAV or CSV) brought onto the 8 kHz ADC scale the firmware's ring
+// holds, and the two-column CSVs used for PIR edges, cry labels and camera
+// levels.
+//
+// No Arduino dependency: plain Linux.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <vector>
+#include "CryWatch.h"
+#include "ImaAdpcm.h"
+
+static const uint32_t RATE    = CryWatch::MFCC_RATE;
+static const int      ADC_MID = 2048;
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static uint32_t get32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint16_t get16(const uint8_t* p) { return p[0] | p[1] << 8; }
+
+// WAV -> 16-bit PCM, first channel. Returns false on anything unsupported.
+static bool loadWav(const std::vector<uint8_t>& f, std::vector<int16_t>& pcm, uint32_t& rate) {
+  if (f.size() < 12 || memcmp(&f[0], "RIFF", 4) || memcmp(&f[8], "WAVE", 4)) return false;
+  uint16_t format = 0, channels = 0, bits = 0, align = 0;
+  for (size_t p = 12; p + 8 <= f.size();) {
+    uint32_t len = get32(&f[p + 4]);
+    const uint8_t* d = &f[p + 8];
+    size_t avail = f.size() - (p + 8);
+    if (len > avail) len = (uint32_t)avail;
+    if (!memcmp(&f[p], "fmt ", 4) && len >= 16) {
+      format   = get16(d);
+      channels = get16(d + 2);
+      rate     = get32(d + 4);
+      align    = get16(d + 12);
+      bits     = get16(d + 14);
+    } else if (!memcmp(&f[p], "data", 4)) {
+      if (format == 1 && bits == 16 && channels) {
+        for (uint32_t i = 0; i + 2 * channels <= len; i += 2 * channels) pcm.push_back((int16_t)get16(d + i));
+        return true;
+      }
+      if (format == 0x11 && channels == 1 && align == ima_adpcm::BLOCK_BYTES) {
+        int16_t block[ima_adpcm::SAMPLES_PER_BLOCK];
+        for (uint32_t i = 0; i + ima_adpcm::BLOCK_BYTES <= len; i += ima_adpcm::BLOCK_BYTES) {
+          ima_adpcm::decodeBlock(d + i, block);
+          pcm.insert(pcm.end(), block, block + ima_adpcm::SAMPLES_PER_BLOCK);
+        }
+        return true;
+      }
+      return false;
+    }
+    p += 8 + len + (len & 1);
+  }
+  return false;
+}
+
+// Each line's first field; header and comment lines are skipped.
+template <typename F>
+static bool loadCsv(const char* path, F row) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char* p = line;
+    while (*p == ' ' || *p == '\t') p++;
+    if ((*p < '0' || *p > '9') && *p != '-') continue;
+    char* next;
+    long a = strtol(p, &next, 10);
+    long b = 0;
+    while (*next == ',' || *next == ' ' || *next == '\t' || *next == ';') next++;
+    if (*next) b = strtol(next, nullptr, 10);
+    row(a, b);
+  }
+  fclose(f);
+  return true;
+}
+
+// Linear interpolation to RATE; the firmware only ever sees 8 kHz.
+static std::vector<int16_t> resample(const std::vector<int16_t>& in, uint32_t from) {
+  if (from == RATE || in.empty()) return in;
+  std::vector<int16_t> out;
+  uint64_t n = (uint64_t)in.size() * RATE / from;
+  out.reserve(n);
+  for (uint64_t i = 0; i < n; i++) {
+    uint64_t pos = i * from;  // in units of 1/RATE input samples
+    size_t   k   = pos / RATE;
+    int32_t  fr  = pos % RATE;
+    int32_t  a   = in[k], b = k + 1 < in.size() ? in[k + 1] : a;
+    out.push_back((int16_t)(a + (int64_t)(b - a) * fr / (int32_t)RATE));
+  }
+  return out;
+}
+
+// A mic trace as raw ADC samples at RATE: CSV (one sample per line, at
+// `csvRate`) or WAV audio mapped back onto the ADC scale around ADC_MID.
+static bool loadMic(const char* path, uint32_t csvRate, std::vector<int16_t>& adc) {
+  size_t plen = strlen(path);
+  if (plen > 4 && !strcasecmp(path + plen - 4, ".csv")) {
+    if (!loadCsv(path, [&](long s, long) { adc.push_back((int16_t)s); })) return false;
+    adc = resample(adc, csvRate);
+    return true;
+  }
+  std::vector<uint8_t> file;
+  std::vector<int16_t> pcm;
+  uint32_t rate = 0;
+  if (!readFile(path, file) || !loadWav(file, pcm, rate) || !rate) return false;
+  adc = resample(pcm, rate);
+  for (int16_t& s : adc) s = (int16_t)(ADC_MID + s / 16);
+  return true;
+}
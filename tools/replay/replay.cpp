@@ -0,0 +1,350 @@
+// Host replay harness for the firmware's motion -> cry logic.
+//
+// Feeds a recorded mic trace and a PIR edge log through lib/CryWatch and
+// lib/SleepWake, the same code src/main.cpp runs, on a virtual clock
+// derived from the sample count, and prints detections, time-to-detect and
+// false positives as JSON.
+//
+//   replay [options] <mic.wav|mic.csv>
+//
+// Mic traces are WAV (16-bit PCM, or the IMA-ADPCM clips the firmware
+// uploads and serves on /clip) or CSV with one raw 12-bit ADC sample per
+// line. WAV audio is mapped back onto the ADC scale around a 2048 bias and
+// resampled to 8 kHz if needed. The PIR log is CSV "t_ms,level" edges;
+// without one the PIR reads high throughout, so listening windows run back
+// to back. Labels are CSV "start_ms,end_ms" spans of real crying; a
+// detection is a true positive if it lands inside a span, or up to
+// --tolerance-ms (default: the window length) after it.
+//
+// Alongside, lib/WakeScore fuses PIR rises, mic level, confirmed cries and
+// an optional camera motion log (CSV "t_ms,level", FrameDiff::level()) into
+// the alert that gates the firmware's network calls. "calls" compares the
+// HTTPS calls the night costs without that gate, the events it lets
+// through and the requests they take once batched ("saved" is against
+// those), and whether each labelled cry was still alerted.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "CryWatch.h"
+#include "SleepWake.h"
+#include "WakeScore.h"
+#include "Trace.h"
+
+// src/main.cpp's NurseryTiming, as statics the command line can change
+struct ReplayTiming {
+  static uint32_t HOLD_MS;
+  static uint8_t  RISES;
+  static uint32_t RISE_WINDOW_MS;
+  static uint32_t LISTEN_MS;
+  static uint32_t CRY_MS;
+  static int      MAX_LULLABIES;
+  static bool     DEAF_WHILE_PLAYING;
+};
+uint32_t ReplayTiming::HOLD_MS            = 3000;
+uint8_t  ReplayTiming::RISES              = 0;
+uint32_t ReplayTiming::RISE_WINDOW_MS     = 0;
+uint32_t ReplayTiming::LISTEN_MS          = 5000;
+uint32_t ReplayTiming::CRY_MS             = 0;
+int      ReplayTiming::MAX_LULLABIES      = 3;
+bool     ReplayTiming::DEAF_WHILE_PLAYING = false;
+typedef SleepWake<ReplayTiming> Nursery;
+
+struct Edge  { uint32_t t; bool high; };
+struct Label { uint32_t start, end; int64_t detected = -1; int64_t alerted = -1; };
+struct Alert { uint32_t start, end; };
+struct Event { uint32_t t; Nursery::Action type; int label; };
+
+static void usage() {
+  fprintf(stderr,
+    "usage: replay [options] <mic.wav|mic.csv>\n"
+    "  --pir FILE             PIR edge log, CSV t_ms,level\n"
+    "  --camera FILE          camera motion log, CSV t_ms,level\n"
+    "  --labels FILE          cry spans, CSV start_ms,end_ms\n"
+    "  --model FILE           cry_model.bin for the CNN stage\n"
+    "  --rate HZ              sample rate of a CSV trace (8000)\n"
+    "  --floor VAR            noise floor restored at boot (0)\n"
+    "  --tolerance-ms MS      late detections still matching a span\n"
+    "  --pir-high-ms MS  --rises N  --rise-window-ms MS  --window-ms MS\n"
+    "  --cry-ms MS  --max-lullabies N  --persist-ms MS\n"
+    "  --energy-gain N  --min-energy N  --hop N  --prob-threshold Q8  --votes N\n"
+    "  --on-score Q8  --off-score Q8  --alert-hold-ms MS  --fuse-rises N\n"
+    "  --sound-full X  --camera-full LEVEL\n");
+  exit(2);
+}
+
+static const char* name(Nursery::Action a) {
+  switch (a) {
+    case Nursery::WOKE:     return "motion";
+    case Nursery::SOOTHE:   return "cry";
+    case Nursery::ESCALATE: return "cry-escalated";
+    case Nursery::SETTLED:  return "quiet";
+    default:                return "none";
+  }
+}
+
+static bool isCry(Nursery::Action a) { return a == Nursery::SOOTHE || a == Nursery::ESCALATE; }
+
+// HTTPS calls src/main.cpp makes for each event, without the wake score:
+// notification + vibrate + two patterns on motion, notification + pattern
+// on a cry (and vibrate past the last lullaby), a pattern when it settles.
+static uint32_t baselineCalls(Nursery::Action a) {
+  switch (a) {
+    case Nursery::WOKE:     return 4;
+    case Nursery::SOOTHE:   return 2;
+    case Nursery::ESCALATE: return 3;
+    case Nursery::SETTLED:  return 1;
+    default:                return 0;
+  }
+}
+
+// ...and with it: the vibrate and the notification when the alert is
+// raised, nothing when it clears (sleep and awake go up in the night's
+// summary, one call a night, not counted), and the escalation vibrate,
+// which always goes out.
+static const uint32_t RAISE_CALLS = 2, CLEAR_CALLS = 0, ESCALATE_CALLS = 1;
+// Those are urgent, so netTask sends the batch at once: what one loop()
+// pass produces is one request (sendBatch -> deliverBatch).
+
+int main(int argc, char** argv) {
+  CryWatchConfig cfg;
+  WakeScoreConfig fuse;
+  const char *micPath = nullptr, *pirPath = nullptr, *labelPath = nullptr, *modelPath = nullptr;
+  const char *cameraPath = nullptr;
+  uint32_t csvRate = RATE, floorInit = 0;
+  int64_t  tolerance = -1;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    if (a[0] != '-') { micPath = a; continue; }
+    if (i + 1 >= argc) usage();
+    const char* v = argv[++i];
+    uint32_t n = (uint32_t)strtoul(v, nullptr, 10);
+    if      (!strcmp(a, "--pir"))            pirPath   = v;
+    else if (!strcmp(a, "--camera"))         cameraPath = v;
+    else if (!strcmp(a, "--labels"))         labelPath = v;
+    else if (!strcmp(a, "--model"))          modelPath = v;
+    else if (!strcmp(a, "--rate"))           csvRate   = n;
+    else if (!strcmp(a, "--floor"))          floorInit = n;
+    else if (!strcmp(a, "--tolerance-ms"))   tolerance = n;
+    else if (!strcmp(a, "--pir-high-ms"))    ReplayTiming::HOLD_MS        = n;
+    else if (!strcmp(a, "--rises"))          ReplayTiming::RISES          = (uint8_t)n;
+    else if (!strcmp(a, "--rise-window-ms")) ReplayTiming::RISE_WINDOW_MS = n;
+    else if (!strcmp(a, "--window-ms"))      ReplayTiming::LISTEN_MS      = n;
+    else if (!strcmp(a, "--cry-ms"))         ReplayTiming::CRY_MS         = n;
+    else if (!strcmp(a, "--max-lullabies"))  ReplayTiming::MAX_LULLABIES  = (int)n;
+    else if (!strcmp(a, "--persist-ms"))     cfg.persistMs     = n;
+    else if (!strcmp(a, "--energy-gain"))    cfg.energyGain    = n;
+    else if (!strcmp(a, "--min-energy"))     cfg.minEnergy     = n;
+    else if (!strcmp(a, "--hop"))            cfg.classifyHop   = (int)n;
+    else if (!strcmp(a, "--prob-threshold")) cfg.probThreshold = (uint16_t)n;
+    else if (!strcmp(a, "--votes"))          cfg.confirmVotes  = (int)n;
+    else if (!strcmp(a, "--on-score"))       fuse.onScore      = (uint16_t)n;
+    else if (!strcmp(a, "--off-score"))      fuse.offScore     = (uint16_t)n;
+    else if (!strcmp(a, "--alert-hold-ms"))  fuse.holdMs       = n;
+    else if (!strcmp(a, "--fuse-rises"))     fuse.pirRises     = (uint8_t)n;
+    else if (!strcmp(a, "--sound-full"))     fuse.soundFull    = (uint16_t)n;
+    else if (!strcmp(a, "--camera-full"))    fuse.cameraFull   = n;
+    else usage();
+  }
+  if (!micPath) usage();
+  if (tolerance < 0) tolerance = ReplayTiming::LISTEN_MS;
+
+  // the trace, on the ADC scale the firmware's ring holds
+  std::vector<int16_t> adc;
+  if (!loadMic(micPath, csvRate, adc)) {
+    fprintf(stderr, "replay: can't read %s (16-bit PCM or IMA-ADPCM WAV, or CSV)\n", micPath);
+    return 1;
+  }
+
+  std::vector<Edge> edges;
+  if (pirPath && !loadCsv(pirPath, [&](long t, long l) { edges.push_back({ (uint32_t)t, l != 0 }); })) {
+    fprintf(stderr, "replay: can't read %s\n", pirPath);
+    return 1;
+  }
+  std::vector<Edge> camera;  // level in place of the edge's flag
+  std::vector<uint32_t> cameraLevel;
+  if (cameraPath && !loadCsv(cameraPath, [&](long t, long l) {
+        camera.push_back({ (uint32_t)t, false });
+        cameraLevel.push_back((uint32_t)l);
+      })) {
+    fprintf(stderr, "replay: can't read %s\n", cameraPath);
+    return 1;
+  }
+  std::vector<Label> labels;
+  if (labelPath && !loadCsv(labelPath, [&](long s, long e) {
+        Label l;
+        l.start = (uint32_t)s;
+        l.end   = (uint32_t)e;
+        labels.push_back(l);
+      })) {
+    fprintf(stderr, "replay: can't read %s\n", labelPath);
+    return 1;
+  }
+
+  CryClassifier classifier;
+  std::vector<uint8_t> blob, arena(CryClassifier::arenaSize());
+  if (modelPath && (!readFile(modelPath, blob) || !classifier.load(blob.data(), blob.size(), arena.data()))) {
+    fprintf(stderr, "replay: model %s rejected\n", modelPath);
+    return 1;
+  }
+
+  CryWatch watch;
+  cfg.sampleRate = RATE;
+  watch.begin(cfg, &classifier);
+  Nursery nursery;
+  WakeScore wake;
+  wake.begin(fuse);
+  NoiseFloor floor;
+  floor.begin();
+  floor.restore(floorInit);
+
+  // One virtual loop() pass per frame: PIR edges up to the frame's end, the
+  // noise floor and the window both fed the frame, like the two readers.
+  std::vector<Event> events;
+  size_t   nextEdge = 0, nextCamera = 0;
+  std::vector<Alert> alerts;
+  uint32_t callsBase = 0, callsFused = 0, requests = 0;
+  bool     pirLevel = pirPath == nullptr;
+  uint32_t motionAt = 0;
+  uint64_t ttdSum   = 0;
+  uint32_t ttdMax   = 0, truePos = 0, falsePos = 0, motions = 0, quiet = 0;
+  const size_t frames = adc.size() / CryWatch::FRAME;
+  auto wallStart = std::chrono::steady_clock::now();
+
+  for (size_t k = 0; k < frames; k++) {
+    const int16_t* x = &adc[k * CryWatch::FRAME];
+    uint32_t passCalls = callsFused;
+    uint32_t now = (uint32_t)((uint64_t)(k + 1) * CryWatch::FRAME * 1000 / RATE);
+    watch.noiseFrame(x, floor);
+    wake.sound(watch.lastVariance(), floor.floor(), now);
+    while (nextCamera < camera.size() && camera[nextCamera].t <= now) {
+      wake.camera(cameraLevel[nextCamera], camera[nextCamera].t);
+      nextCamera++;
+    }
+    // queued edges at their own times, then the hold at `now`, as loop()
+    // does; the machine ignores them while listening
+    Nursery::Action e = Nursery::NONE;
+    while (nextEdge < edges.size() && edges[nextEdge].t <= now) {
+      const Edge& d = edges[nextEdge++];
+      if (d.high && !pirLevel) wake.pir(d.t);
+      pirLevel = d.high;
+      if (nursery.pir(d.high, d.t) == Nursery::WOKE) e = Nursery::WOKE;
+    }
+    if (nursery.listening() && e == Nursery::NONE) {
+      // the window's audio starts at the motion, as after skipToLatest()
+      e = nursery.cry(watch.frame(x), now);
+    } else {
+      if (nursery.pir(pirLevel, now) == Nursery::WOKE) e = Nursery::WOKE;
+      if (e == Nursery::WOKE) watch.listen();
+    }
+
+    if (isCry(e)) wake.cry(now);
+    WakeScore::Edge we = wake.update(now);
+    if (we == WakeScore::RAISED) {
+      alerts.push_back({ now, UINT32_MAX });
+      callsFused += RAISE_CALLS;
+    } else if (we == WakeScore::CLEARED) {
+      alerts.back().end = now;
+      callsFused += CLEAR_CALLS;
+    }
+    if (wake.alerting()) {
+      for (Label& l : labels) {
+        if (l.alerted < 0 && now >= l.start && now <= l.end + tolerance) l.alerted = now;
+      }
+    }
+    callsBase += baselineCalls(e);
+    if (e == Nursery::ESCALATE) callsFused += ESCALATE_CALLS;
+    if (callsFused != passCalls) requests++;
+    if (e == Nursery::NONE) continue;
+
+    int match = -1;
+    if (e == Nursery::WOKE) motions++;
+    if (e == Nursery::SETTLED) quiet++;
+    if (isCry(e)) {
+      for (size_t i = 0; i < labels.size() && match < 0; i++) {
+        if (now >= labels[i].start && now <= labels[i].end + tolerance) match = (int)i;
+      }
+      if (match < 0) {
+        falsePos++;
+      } else {
+        truePos++;
+        Label& l = labels[match];
+        if (l.detected < 0) {
+          l.detected = now;
+          ttdSum += now - l.start;
+          if (now - l.start > ttdMax) ttdMax = now - l.start;
+        }
+      }
+    }
+    events.push_back({ now, e, match });
+  }
+
+  double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  uint32_t durationMs = (uint32_t)((uint64_t)adc.size() * 1000 / RATE);
+  uint32_t detected = 0, alerted = 0, idleAlerts = 0;
+  for (const Label& l : labels) {
+    detected += l.detected >= 0;
+    alerted  += l.alerted >= 0;
+  }
+  for (const Alert& a : alerts) {
+    bool cry = false;
+    for (const Label& l : labels) cry |= a.start <= l.end + tolerance && a.end >= l.start;
+    idleAlerts += !cry;
+  }
+
+  printf("{\n  \"input\": \"%s\",\n  \"durationMs\": %u,\n  \"frames\": %zu,\n", micPath, durationMs, frames);
+  printf("  \"classifier\": \"%s\",\n", classifier.loaded() ? "cnn" : "spectral");
+  printf("  \"config\": {\"pirHighMs\": %u, \"rises\": %u, \"riseWindowMs\": %u, \"windowMs\": %u, "
+         "\"cryMs\": %u, \"maxLullabies\": %d, \"persistMs\": %u, \"energyGain\": %u, \"minEnergy\": %u, "
+         "\"hop\": %d, \"probThreshold\": %u, \"votes\": %d, \"toleranceMs\": %lld},\n",
+         ReplayTiming::HOLD_MS, ReplayTiming::RISES, ReplayTiming::RISE_WINDOW_MS, ReplayTiming::LISTEN_MS,
+         ReplayTiming::CRY_MS, ReplayTiming::MAX_LULLABIES, cfg.persistMs, cfg.energyGain, cfg.minEnergy,
+         cfg.classifyHop, cfg.probThreshold, cfg.confirmVotes, (long long)tolerance);
+  printf("  \"events\": [");
+  for (size_t i = 0; i < events.size(); i++) {
+    const Event& e = events[i];
+    printf("%s\n    {\"t\": %u, \"type\": \"%s\"", i ? "," : "", e.t, name(e.type));
+    if (e.type == Nursery::WOKE) motionAt = e.t;
+    if (isCry(e.type)) {
+      printf(", \"sinceMotionMs\": %u", e.t - motionAt);
+      if (e.label >= 0) printf(", \"label\": %d, \"ttdMs\": %u", e.label, e.t - labels[e.label].start);
+      else printf(", \"falsePositive\": true");
+    }
+    printf("}");
+  }
+  printf("%s],\n  \"cries\": [", events.empty() ? "" : "\n  ");
+  for (size_t i = 0; i < labels.size(); i++) {
+    const Label& l = labels[i];
+    printf("%s\n    {\"startMs\": %u, \"endMs\": %u, ", i ? "," : "", l.start, l.end);
+    if (l.detected >= 0) printf("\"detectedMs\": %lld, \"ttdMs\": %lld, ", (long long)l.detected, (long long)(l.detected - l.start));
+    else printf("\"detectedMs\": null, \"ttdMs\": null, ");
+    if (l.alerted >= 0) printf("\"alertedMs\": %lld}", (long long)l.alerted);
+    else printf("\"alertedMs\": null}");
+  }
+  printf("%s],\n", labels.empty() ? "" : "\n  ");
+  printf("  \"summary\": {\"motions\": %u, \"quietWindows\": %u, \"detections\": %u, \"truePositives\": %u, "
+         "\"falsePositives\": %u, \"cries\": %zu, \"missed\": %zu, ",
+         motions, quiet, truePos + falsePos, truePos, falsePos, labels.size(), labels.size() - detected);
+  if (detected) printf("\"ttdMeanMs\": %llu, \"ttdMaxMs\": %u},\n", (unsigned long long)(ttdSum / detected), ttdMax);
+  else printf("\"ttdMeanMs\": null, \"ttdMaxMs\": null},\n");
+  printf("  \"alerts\": [");
+  for (size_t i = 0; i < alerts.size(); i++) {
+    printf("%s{\"startMs\": %u, \"endMs\": ", i ? ", " : "", alerts[i].start);
+    if (alerts[i].end == UINT32_MAX) printf("null}");
+    else printf("%u}", alerts[i].end);
+  }
+  printf("],\n  \"calls\": {\"baseline\": %u, \"fused\": %u, \"requests\": %u, \"saved\": %d, \"savedPct\": %.1f, "
+         "\"alerts\": %zu, \"alertsWithoutCry\": %u, \"criesAlerted\": %u, \"criesNotAlerted\": %zu},\n",
+         callsBase, callsFused, requests, (int)callsBase - (int)requests,
+         callsBase ? 100.0 * ((int)callsBase - (int)requests) / callsBase : 0.0,
+         alerts.size(), idleAlerts, alerted, labels.size() - alerted);
+  printf("  \"perf\": {\"wallMs\": %.1f, \"realtimeFactor\": %.0f, \"detectorNsPerFrameMax\": %u}\n}\n",
+         wallMs, wallMs > 0 ? durationMs / wallMs : 0.0, watch.detector().maxCycles());
+  return 0;
+}
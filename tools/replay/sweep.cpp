@@ -0,0 +1,543 @@
+// Parameter sweep and ROC over a corpus of labelled recordings.
+//
+// Runs the detection logic of either firmware over every recording for
+// every combination of a parameter grid, spread over all cores, and prints
+// the ROC (recall against false detections per hour), the detection
+// latency of the best trade-offs and a recommended parameter set as JSON.
+//
+//   sweep [options] corpus.txt
+//
+// corpus.txt lists one recording per line: "mic pir labels", paths
+// relative to the list, "-" for a missing PIR log (PIR high throughout)
+// or label file; '#' starts a comment. Traces and logs are read as by
+// replay.
+//
+// The expensive part of a run, the DSP, does not depend on the swept
+// parameters, so it runs once per recording: per frame the spectral
+// detector's band energy and cry shape, the noise floor, the CNN's cry
+// probability (with --model) and the level device/src/main.cpp's loud
+// check compares. Each combination then only replays SleepWake and the
+// verdict logic (persistence, energy threshold, inference hop and votes)
+// over those features, which is exact for src/main.cpp: the classifier
+// window after listen() holds the same frames as a never-reset one once
+// it is full. The device's loop pass is modelled as one per 32 ms frame,
+// as sampleSoundLevel() and readSound() run it: a burst of reads that the
+// DC tracks, the floor learning from the burst's last read, then one more
+// read compared against them. The sweep plays no lullabies, so the
+// firmware's pause in learning during playback never comes up.
+//
+// Grid axes take "v", "a,b,c" or "lo:hi:step"; unset axes keep the
+// firmware's constants.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CryWatch.h"
+#include "SleepWake.h"
+#include "Trace.h"
+
+// device/src/main.cpp's sound check
+static const int DEVICE_MIN_MARGIN = 100;
+static const int DEVICE_BURST      = 16;   // METER_BURST
+
+// SleepWake timings, per sweep thread
+struct SweepTiming {
+  static thread_local uint32_t HOLD_MS;
+  static thread_local uint8_t  RISES;
+  static thread_local uint32_t RISE_WINDOW_MS;
+  static thread_local uint32_t LISTEN_MS;
+  static thread_local uint32_t CRY_MS;
+  static const int             MAX_LULLABIES      = 1000;  // verdicts only
+  static const bool            DEAF_WHILE_PLAYING = false;
+};
+thread_local uint32_t SweepTiming::HOLD_MS        = 0;
+thread_local uint8_t  SweepTiming::RISES          = 0;
+thread_local uint32_t SweepTiming::RISE_WINDOW_MS = 0;
+thread_local uint32_t SweepTiming::LISTEN_MS      = 0;
+thread_local uint32_t SweepTiming::CRY_MS         = 0;
+typedef SleepWake<SweepTiming> Nursery;
+
+struct Edge  { uint32_t t; bool high; };
+struct Label { uint32_t start, end; };
+
+// What the DSP made of one recording, frame by frame.
+struct Recording {
+  std::string           name;
+  std::vector<Edge>     edges;
+  std::vector<Label>    labels;
+  bool                  pirLog = false;
+  size_t                frames = 0;
+  std::vector<uint32_t> band;      // cry-band energy
+  std::vector<uint8_t>  shape;     // band share and harmonics look like a cry
+  std::vector<uint32_t> floor;     // noise floor after the frame's update
+  std::vector<uint16_t> prob;      // CNN cry probability, Q8, on a full window
+  std::vector<int16_t>  level;     // device: polled sample over its DC
+  std::vector<uint32_t> levelFloor;
+};
+
+enum Axis {
+  HOLD, RISES, RISE_WINDOW, LISTEN, CRY, PERSIST, GAIN, MIN_ENERGY, HOP, PROB, VOTES, DEV_GAIN, N_AXES
+};
+
+struct AxisInfo { const char* flag; const char* constant; };
+static const AxisInfo AXES[N_AXES] = {
+  { "--pir-high-ms",    "PIR_HIGH_MS"        },
+  { "--rises",          "MOTION_THRESHOLD"   },
+  { "--rise-window-ms", "MOTION_WINDOW_MS"   },
+  { "--window-ms",      "CRY_WINDOW_MS"      },
+  { "--cry-ms",         "SOUND_DETECT_MS"    },
+  { "--persist-ms",     "CRY_PERSIST_MS"     },
+  { "--energy-gain",    "NOISE_ENERGY_GAIN"  },
+  { "--min-energy",     "CRY_MIN_ENERGY"     },
+  { "--hop",            "CRY_CLASSIFY_HOP"   },
+  { "--prob-threshold", "CRY_PROB_THRESHOLD" },
+  { "--votes",          "CRY_CONFIRM_VOTES"  },
+  { "--sound-gain",     "SOUND_DEV_GAIN"     },
+};
+
+struct Params { uint32_t v[N_AXES]; };
+
+struct Score {
+  uint32_t detected  = 0;   // labels hit at least once
+  uint32_t falsePos  = 0;
+  uint32_t detections = 0;
+  double   ttdMean   = 0;
+  uint32_t ttdP90    = 0;
+  double   recall    = 0;
+  double   fpPerHour = 0;
+};
+
+static void usage() {
+  fprintf(stderr,
+    "usage: sweep [options] corpus.txt\n"
+    "  --firmware main|device  whose logic and defaults (main)\n"
+    "  --model FILE            cry_model.bin: main's verdict is the CNN's\n"
+    "  --jobs N                threads (all cores)\n"
+    "  --tolerance-ms MS       late detections still matching a label (5000)\n"
+    "  --min-recall R          recall the recommendation must reach (0.9)\n"
+    "  --csv FILE              every combination's scores\n"
+    "  --floor VAR  --rate HZ  as replay\n"
+    " grid axes (v | a,b,c | lo:hi:step):\n"
+    "  --pir-high-ms --rises --rise-window-ms --window-ms --cry-ms\n"
+    "  --persist-ms --energy-gain --min-energy --hop --prob-threshold --votes\n"
+    "  --sound-gain\n");
+  exit(2);
+}
+
+static bool parseAxis(const char* s, std::vector<uint32_t>& out) {
+  out.clear();
+  unsigned lo, hi, step;
+  if (sscanf(s, "%u:%u:%u", &lo, &hi, &step) == 3) {
+    if (!step || hi < lo) return false;
+    for (uint32_t v = lo; v <= hi; v += step) out.push_back(v);
+    return true;
+  }
+  for (const char* p = s; *p;) {
+    char* end;
+    unsigned long v = strtoul(p, &end, 10);
+    if (end == p) return false;
+    out.push_back((uint32_t)v);
+    p = *end == ',' ? end + 1 : end;
+    if (*end && *end != ',') return false;
+  }
+  return !out.empty();
+}
+
+// Run one pool of `jobs` threads over [0, n).
+template <typename F>
+static void parallelFor(size_t n, int jobs, F body) {
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+  for (int j = 0; j < jobs; j++) {
+    pool.emplace_back([&]() {
+      for (size_t i; (i = next++) < n;) body(i);
+    });
+  }
+  for (std::thread& t : pool) t.join();
+}
+
+static void analyse(Recording& r, const std::vector<int16_t>& adc, uint32_t floorInit,
+                    const std::vector<uint8_t>& model) {
+  CryWatchConfig cfg;
+  cfg.sampleRate = RATE;
+  CryWatch watch;  // its noiseFrame() keeps the floor exactly as the firmware
+  watch.begin(cfg);
+  CryDetectorConfig dc;
+  dc.sampleRate    = RATE;
+  dc.minBandEnergy = 0;  // shape only; the threshold is swept
+  CryDetector det;
+  det.begin(dc);
+  NoiseFloor floor;
+  floor.begin();
+  floor.restore(floorInit);
+
+  CryClassifier clf;
+  std::vector<uint8_t> arena;
+  if (!model.empty()) {
+    arena.resize(CryClassifier::arenaSize());
+    clf.load(model.data(), model.size(), arena.data());
+  }
+
+  NoiseFloor devFloor;
+  devFloor.begin();
+  DcTracker devDcTrack(6, ADC_MID);
+  int devDc = ADC_MID;
+
+  r.frames = adc.size() / CryWatch::FRAME;
+  r.band.resize(r.frames);
+  r.shape.resize(r.frames);
+  r.floor.resize(r.frames);
+  r.level.resize(r.frames);
+  r.levelFloor.resize(r.frames);
+  if (clf.loaded()) r.prob.resize(r.frames);
+  for (size_t k = 0; k < r.frames; k++) {
+    const int16_t* x = &adc[k * CryWatch::FRAME];
+    watch.noiseFrame(x, floor);
+    det.process(x);
+    r.band[k]  = det.lastBandEnergy();
+    r.shape[k] = det.lastCryLike();
+    r.floor[k] = floor.floor();
+    if (clf.loaded()) {
+      int32_t coeffs[CryWatch::CryMfcc::N_MFCC];
+      CryWatch::CryMfcc::compute(det.power(), coeffs);
+      clf.push(coeffs);
+      uint16_t p[CryClassifier::N_LABELS] = {};
+      if (clf.ready()) clf.infer(p);
+      r.prob[k] = p[CryClassifier::CRY];
+    }
+    // sampleSoundLevel(): the DC over the burst, the floor on its last
+    // read; then readSound()'s read
+    const int16_t* burst = x + CryWatch::FRAME - 1 - DEVICE_BURST;
+    for (int i = 0; i < DEVICE_BURST; i++) devDc = devDcTrack.update(burst[i]);
+    devFloor.update(abs(burst[DEVICE_BURST - 1] - devDc));
+    r.level[k]      = (int16_t)(x[CryWatch::FRAME - 1] - devDc);
+    r.levelFloor[k] = devFloor.floor();
+  }
+}
+
+// One recording under one parameter set; detections are matched to
+// labels as replay does.
+static void run(const Recording& r, const Params& p, bool device, bool cnn, uint32_t tolerance,
+                std::vector<int64_t>& firstHit, uint32_t& falsePos, uint32_t& detections) {
+  const uint32_t* v = p.v;
+  const uint32_t frameMs = CryWatch::FRAME * 1000 / RATE;
+  const uint32_t persistMax = (v[PERSIST] + frameMs - 1) / frameMs;
+  const uint64_t perVar = (uint64_t)CryWatchConfig().energyPerVar * v[GAIN];
+  Nursery nursery;
+  size_t nextEdge = 0;
+  bool   pirLevel = !r.pirLog;
+  uint32_t persist = 0, hop = 0, filled = 0, votes = 0;
+
+  firstHit.assign(r.labels.size(), -1);
+  for (size_t k = 0; k < r.frames; k++) {
+    uint32_t now = (uint32_t)((uint64_t)(k + 1) * CryWatch::FRAME * 1000 / RATE);
+    Nursery::Action e = Nursery::NONE;
+    while (nextEdge < r.edges.size() && r.edges[nextEdge].t <= now) {
+      const Edge& d = r.edges[nextEdge++];
+      pirLevel = d.high;
+      if (nursery.pir(d.high, d.t) == Nursery::WOKE) e = Nursery::WOKE;
+    }
+    if (nursery.listening() && e == Nursery::NONE) {
+      bool heard;
+      if (device) {
+        int32_t margin = (int32_t)(v[DEV_GAIN] * r.levelFloor[k]);
+        heard = r.level[k] > std::max(margin, (int32_t)DEVICE_MIN_MARGIN);
+      } else if (cnn) {
+        // CryWatch::frame(): infer every `hop` frames once the window is full
+        filled++;
+        heard = false;
+        if (++hop >= v[HOP] && filled >= (uint32_t)CryClassifier::T) {
+          hop   = 0;
+          votes = r.prob[k] >= v[PROB] ? votes + 1 : 0;
+          heard = votes >= v[VOTES];
+        }
+      } else {
+        uint64_t thr = std::max<uint64_t>(std::min<uint64_t>((uint64_t)r.floor[k] * perVar, UINT32_MAX), v[MIN_ENERGY]);
+        bool like = r.shape[k] && r.band[k] >= thr;
+        if (like) {
+          if (persist < persistMax) persist++;
+        } else if (persist > 0) {
+          persist--;
+        }
+        heard = persist >= persistMax;
+      }
+      e = nursery.cry(heard, now);
+    } else {
+      if (nursery.pir(pirLevel, now) == Nursery::WOKE) e = Nursery::WOKE;
+      if (e == Nursery::WOKE) persist = hop = filled = votes = 0;
+    }
+    if (e != Nursery::SOOTHE && e != Nursery::ESCALATE) continue;
+
+    detections++;
+    int match = -1;
+    for (size_t i = 0; i < r.labels.size() && match < 0; i++) {
+      if (now >= r.labels[i].start && now <= r.labels[i].end + tolerance) match = (int)i;
+    }
+    if (match < 0) falsePos++;
+    else if (firstHit[match] < 0) firstHit[match] = now;
+  }
+}
+
+static std::string dirOf(const std::string& path) {
+  size_t s = path.rfind('/');
+  return s == std::string::npos ? "" : path.substr(0, s + 1);
+}
+
+int main(int argc, char** argv) {
+  bool device = false;
+  const char *corpusPath = nullptr, *modelPath = nullptr, *csvPath = nullptr;
+  uint32_t csvRate = RATE, floorInit = 0, tolerance = 5000;
+  double   minRecall = 0.9;
+  int      jobs = (int)std::thread::hardware_concurrency();
+  std::vector<uint32_t> grid[N_AXES];
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    if (a[0] != '-') { corpusPath = a; continue; }
+    if (i + 1 >= argc) usage();
+    const char* v = argv[++i];
+    int axis = -1;
+    for (int x = 0; x < N_AXES; x++) if (!strcmp(a, AXES[x].flag)) axis = x;
+    if (axis >= 0) {
+      if (!parseAxis(v, grid[axis])) usage();
+    }
+    else if (!strcmp(a, "--firmware"))     device    = !strcmp(v, "device");
+    else if (!strcmp(a, "--model"))        modelPath = v;
+    else if (!strcmp(a, "--jobs"))         jobs      = atoi(v);
+    else if (!strcmp(a, "--tolerance-ms")) tolerance = (uint32_t)strtoul(v, nullptr, 10);
+    else if (!strcmp(a, "--min-recall"))   minRecall = atof(v);
+    else if (!strcmp(a, "--csv"))          csvPath   = v;
+    else if (!strcmp(a, "--floor"))        floorInit = (uint32_t)strtoul(v, nullptr, 10);
+    else if (!strcmp(a, "--rate"))         csvRate   = (uint32_t)strtoul(v, nullptr, 10);
+    else usage();
+  }
+  if (!corpusPath) usage();
+  if (jobs < 1) jobs = 1;
+
+  // each firmware's constants where the grid leaves an axis open
+  CryWatchConfig cw;
+  const uint32_t mainDefaults[N_AXES]   = { 3000, 0, 0, 5000, 0, cw.persistMs, cw.energyGain, cw.minEnergy,
+                                            (uint32_t)cw.classifyHop, cw.probThreshold, (uint32_t)cw.confirmVotes, 4 };
+  const uint32_t deviceDefaults[N_AXES] = { 0, 3, 10000, 0, 5000, cw.persistMs, cw.energyGain, cw.minEnergy,
+                                            (uint32_t)cw.classifyHop, cw.probThreshold, (uint32_t)cw.confirmVotes, 4 };
+  for (int x = 0; x < N_AXES; x++) {
+    if (grid[x].empty()) grid[x].push_back(device ? deviceDefaults[x] : mainDefaults[x]);
+  }
+
+  std::vector<uint8_t> model;
+  if (modelPath) {
+    CryClassifier probe;
+    std::vector<uint8_t> arena(CryClassifier::arenaSize());
+    if (!readFile(modelPath, model) || !probe.load(model.data(), model.size(), arena.data())) {
+      fprintf(stderr, "sweep: model %s rejected\n", modelPath);
+      return 1;
+    }
+  }
+  const bool cnn = !model.empty() && !device;
+
+  // the corpus
+  std::vector<Recording> recs;
+  std::vector<std::string> mics;
+  FILE* cf = fopen(corpusPath, "r");
+  if (!cf) {
+    fprintf(stderr, "sweep: can't read %s\n", corpusPath);
+    return 1;
+  }
+  std::string base = dirOf(corpusPath);
+  char line[1024];
+  while (fgets(line, sizeof(line), cf)) {
+    char* hash = strchr(line, '#');
+    if (hash) *hash = 0;
+    char mic[512], pir[512] = "-", lab[512] = "-";
+    if (sscanf(line, "%511s %511s %511s", mic, pir, lab) < 1) continue;
+    auto path = [&](const char* p) { return p[0] == '/' ? std::string(p) : base + p; };
+    Recording r;
+    r.name = mic;
+    if (strcmp(pir, "-")) {
+      r.pirLog = true;
+      if (!loadCsv(path(pir).c_str(), [&](long t, long l) { r.edges.push_back({ (uint32_t)t, l != 0 }); })) {
+        fprintf(stderr, "sweep: can't read %s\n", pir);
+        return 1;
+      }
+    }
+    if (strcmp(lab, "-") && !loadCsv(path(lab).c_str(), [&](long s, long e) {
+          r.labels.push_back({ (uint32_t)s, (uint32_t)e });
+        })) {
+      fprintf(stderr, "sweep: can't read %s\n", lab);
+      return 1;
+    }
+    recs.push_back(std::move(r));
+    mics.push_back(path(mic));
+  }
+  fclose(cf);
+  if (recs.empty()) usage();
+
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<char> loaded(recs.size(), 0);
+  parallelFor(recs.size(), jobs, [&](size_t i) {
+    std::vector<int16_t> adc;
+    if (!loadMic(mics[i].c_str(), csvRate, adc)) return;
+    analyse(recs[i], adc, floorInit, model);
+    loaded[i] = 1;
+  });
+  for (size_t i = 0; i < recs.size(); i++) {
+    if (!loaded[i]) {
+      fprintf(stderr, "sweep: can't read %s\n", mics[i].c_str());
+      return 1;
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  // every combination of the grid
+  std::vector<Params> combos(1);
+  for (int x = 0; x < N_AXES; x++) {
+    std::vector<Params> next;
+    for (const Params& c : combos) {
+      for (uint32_t val : grid[x]) {
+        Params p = c;
+        p.v[x] = val;
+        next.push_back(p);
+      }
+    }
+    combos.swap(next);
+  }
+
+  size_t   labels = 0;
+  uint64_t frames = 0;
+  for (const Recording& r : recs) {
+    labels += r.labels.size();
+    frames += r.frames;
+  }
+  const double hours = frames * (double)CryWatch::FRAME / RATE / 3600.0;
+
+  std::vector<Score> scores(combos.size());
+  parallelFor(combos.size(), jobs, [&](size_t c) {
+    const uint32_t* v = combos[c].v;
+    SweepTiming::HOLD_MS        = v[HOLD];
+    SweepTiming::RISES          = (uint8_t)v[RISES];
+    SweepTiming::RISE_WINDOW_MS = v[RISE_WINDOW];
+    SweepTiming::LISTEN_MS      = v[LISTEN];
+    SweepTiming::CRY_MS         = v[CRY];
+    Score& s = scores[c];
+    std::vector<int64_t> hit;
+    std::vector<uint32_t> ttd;
+    for (const Recording& r : recs) {
+      run(r, combos[c], device, cnn, tolerance, hit, s.falsePos, s.detections);
+      for (size_t i = 0; i < hit.size(); i++) {
+        if (hit[i] >= 0) ttd.push_back((uint32_t)(hit[i] - r.labels[i].start));
+      }
+    }
+    s.detected = (uint32_t)ttd.size();
+    s.recall   = labels ? (double)s.detected / labels : 0;
+    s.fpPerHour = hours > 0 ? s.falsePos / hours : 0;
+    if (!ttd.empty()) {
+      std::sort(ttd.begin(), ttd.end());
+      double sum = 0;
+      for (uint32_t t : ttd) sum += t;
+      s.ttdMean = sum / ttd.size();
+      s.ttdP90  = ttd[(ttd.size() * 9) / 10 < ttd.size() ? (ttd.size() * 9) / 10 : ttd.size() - 1];
+    }
+  });
+  auto t2 = std::chrono::steady_clock::now();
+
+  // ROC: the combinations no other beats on both recall and false alarms
+  std::vector<size_t> order(combos.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (scores[a].fpPerHour != scores[b].fpPerHour) return scores[a].fpPerHour < scores[b].fpPerHour;
+    if (scores[a].recall != scores[b].recall) return scores[a].recall > scores[b].recall;
+    return scores[a].ttdMean < scores[b].ttdMean;
+  });
+  std::vector<size_t> roc;
+  double bestRecall = -1;
+  for (size_t i : order) {
+    if (scores[i].recall > bestRecall) {
+      roc.push_back(i);
+      bestRecall = scores[i].recall;
+    }
+  }
+  // latency: among those reaching minRecall, the fastest for each false-alarm rate
+  std::vector<size_t> latency;
+  double bestTtd = 1e300;
+  for (size_t i : order) {
+    if (scores[i].recall + 1e-9 < minRecall || !scores[i].detected) continue;
+    if (scores[i].ttdMean < bestTtd) {
+      latency.push_back(i);
+      bestTtd = scores[i].ttdMean;
+    }
+  }
+  // recommendation: fewest false alarms at minRecall, then the fastest; if
+  // nothing gets there, the highest recall
+  long rec = latency.empty() ? -1 : (long)latency.front();
+  if (rec < 0 && !roc.empty()) rec = (long)roc.back();
+
+  // only the axes that were swept or matter to this firmware
+  auto relevant = [&](int x) {
+    if (grid[x].size() > 1) return true;
+    if (device) return x == RISES || x == RISE_WINDOW || x == CRY || x == DEV_GAIN || x == HOLD || x == LISTEN;
+    if (cnn) return x == HOLD || x == LISTEN || x == HOP || x == PROB || x == VOTES;
+    return x == HOLD || x == LISTEN || x == PERSIST || x == GAIN || x == MIN_ENERGY;
+  };
+  auto printPoint = [&](size_t i) {
+    const Score& s = scores[i];
+    printf("{\"recall\": %.3f, \"fpPerHour\": %.2f, \"falsePositives\": %u, ", s.recall, s.fpPerHour, s.falsePos);
+    if (s.detected) printf("\"ttdMeanMs\": %.0f, \"ttdP90Ms\": %u, \"params\": {", s.ttdMean, s.ttdP90);
+    else printf("\"ttdMeanMs\": null, \"ttdP90Ms\": null, \"params\": {");
+    bool first = true;
+    for (int x = 0; x < N_AXES; x++) {
+      if (!relevant(x)) continue;
+      printf("%s\"%s\": %u", first ? "" : ", ", AXES[x].constant, combos[i].v[x]);
+      first = false;
+    }
+    printf("}}");
+  };
+
+  double prepMs  = std::chrono::duration<double, std::milli>(t1 - t0).count();
+  double sweepMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+  printf("{\n  \"firmware\": \"%s\",\n  \"verdict\": \"%s\",\n", device ? "device" : "main",
+         device ? "level" : cnn ? "cnn" : "spectral");
+  printf("  \"recordings\": %zu,\n  \"audioHours\": %.2f,\n  \"labels\": %zu,\n  \"combinations\": %zu,\n",
+         recs.size(), hours, labels, combos.size());
+  printf("  \"roc\": [");
+  for (size_t i = 0; i < roc.size(); i++) {
+    printf("%s\n    ", i ? "," : "");
+    printPoint(roc[i]);
+  }
+  printf("\n  ],\n  \"latency\": [");
+  for (size_t i = 0; i < latency.size(); i++) {
+    printf("%s\n    ", i ? "," : "");
+    printPoint(latency[i]);
+  }
+  printf("\n  ],\n  \"minRecall\": %.2f,\n  \"recommended\": ", minRecall);
+  if (rec >= 0) printPoint((size_t)rec);
+  else printf("null");
+  printf(",\n  \"perf\": {\"jobs\": %d, \"analyseMs\": %.0f, \"sweepMs\": %.0f, \"usPerCombination\": %.1f, "
+         "\"audioHoursPerSecond\": %.0f}\n}\n",
+         jobs, prepMs, sweepMs, combos.empty() ? 0.0 : sweepMs * 1000 / combos.size(),
+         sweepMs > 0 ? hours * combos.size() / (sweepMs / 1000) : 0.0);
+
+  if (csvPath) {
+    FILE* f = fopen(csvPath, "w");
+    if (!f) {
+      fprintf(stderr, "sweep: can't write %s\n", csvPath);
+      return 1;
+    }
+    for (int x = 0; x < N_AXES; x++) fprintf(f, "%s,", AXES[x].constant);
+    fprintf(f, "recall,fp_per_hour,false_positives,ttd_mean_ms,ttd_p90_ms\n");
+    for (size_t i = 0; i < combos.size(); i++) {
+      for (int x = 0; x < N_AXES; x++) fprintf(f, "%u,", combos[i].v[x]);
+      fprintf(f, "%.4f,%.3f,%u,%.0f,%u\n", scores[i].recall, scores[i].fpPerHour, scores[i].falsePos,
+              scores[i].ttdMean, scores[i].ttdP90);
+    }
+    fclose(f);
+  }
+  return 0;
+}
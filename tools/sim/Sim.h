@@ -0,0 +1,139 @@
+#pragma once
+// Virtual clock and scripted hardware behind the Arduino/ESP-IDF shims in
+// shim/, so src/main.cpp's setup() and loop() run unmodified on the host.
+//
+// Time only moves when the firmware waits: delay(), a blocking HTTPS call,
+// WiFi association. Each step first delivers everything scheduled up to
+// the new time, in order: PIR pin edges go through the attached interrupt
+// handler, and the ADC DMA conversions due are handed to the sampler task.
+// That task is a real thread, but it runs in lockstep with the clock, so
+// every conversion due is in the ring before delay() returns and a script
+// always gives the same run, however fast or loaded the host.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "esp_camera.h"
+
+namespace sim {
+
+// --- clock -----------------------------------------------------------------
+uint64_t nowUs();                 // virtual µs since boot
+void     sleepUs(uint64_t us);    // what delay() does
+uint64_t sleptNs();               // host time spent inside sleepUs(), for loop costs
+
+// --- scripted inputs ---------------------------------------------------------
+// An analog pin replays `n` samples at `rateHz` from boot, then reads `after`.
+void analogTrace(int pin, const int16_t* samples, size_t n, uint32_t rateHz, int after);
+void analogLevel(int pin, int value);
+// A digital pin changes to `level` at `us`; an attached interrupt fires.
+void digitalAt(uint64_t us, int pin, bool level);
+// GET `uri` on the firmware's WebServer, served by the next handleClient()
+// from `us` on.
+void requestAt(uint64_t us, const std::string& uri);
+
+// --- camera ------------------------------------------------------------------
+// What esp_camera_fb_get() hands out. Each frame has a capture time; a grab
+// returns the newest frame captured by now that has not been handed out,
+// waiting on the clock for the next capture when there is none, and fails
+// once the sequence is over or while the single frame buffer is held.
+class FrameSource {
+public:
+  virtual ~FrameSource() {}
+  virtual size_t   count() const = 0;
+  virtual uint64_t at(size_t i) const = 0;              // capture time, µs since boot
+  virtual bool     frame(size_t i, camera_fb_t& fb) = 0;  // buf, len, size, format
+};
+
+// Recorded frames, one file each: JPEG (.jpg), 8-bit PGM (.pgm) or raw
+// little-endian RGB565 (.rgb565, `w` x `h`). Captured every 1/fps s from
+// boot, or at the times in a CSV of t_ms, one line per frame.
+class FrameFiles : public FrameSource {
+public:
+  bool        load(const std::vector<std::string>& paths, int w = 0, int h = 0);
+  void        pace(double fps) { fps_ = fps; times_.clear(); }
+  bool        pace(const char* timesCsv);
+  const char* error() const { return error_.c_str(); }
+
+  size_t   count() const override { return frames_.size(); }
+  uint64_t at(size_t i) const override;
+  bool     frame(size_t i, camera_fb_t& fb) override;
+
+private:
+  struct Frame {
+    std::vector<uint8_t> data;
+    size_t               width, height;
+    pixformat_t          format;
+  };
+  std::vector<Frame>    frames_;
+  std::vector<uint64_t> times_;
+  double                fps_ = 10;
+  std::string           error_;
+};
+
+struct CameraStats {
+  uint32_t grabs;      // frames handed out
+  uint32_t skipped;    // captured but never grabbed: the reader was slower
+  uint32_t held;       // grabs refused with the buffer still held
+  uint32_t waitedMs;   // virtual time grabs spent waiting for a capture
+};
+void        camera(FrameSource* src);  // nullptr: no camera fitted
+CameraStats cameraStats();
+
+// --- environment -------------------------------------------------------------
+struct Net {
+  uint32_t wifiMs   = 2000;   // association time after WiFi.begin()
+  uint32_t httpMs   = 300;    // each HTTPS request blocks its caller this long...
+  uint32_t tlsMs    = 600;    // ...after this if it opens a connection: TCP + full TLS...
+  uint32_t resumeMs = 150;    // ...or this, resuming a TLS session
+  uint32_t sessionS = 3600;   // the server resumes sessions this old
+  uint32_t idleMs   = 60000;  // the server closes connections idle this long
+  int      code     = 200;    // status every request gets...
+  std::vector<std::pair<std::string, int>> codeAt;  // ...but those to URLs ending in these
+  std::vector<std::pair<uint32_t, uint32_t>> offline;  // [from, to) s: the server can't be reached
+  uint32_t songMs   = 180000; // length of the cloud lullaby
+  uint32_t ntpMs    = 1000;   // configTime() to a synced clock
+  int64_t  epoch    = 1704146400;  // UTC at boot: 2024-01-01 22:00
+};
+Net&  net();
+void  fsRoot(const char* dir);   // LittleFS; none means begin() fails
+void  serialTo(FILE* f);         // serial monitor; nullptr drops it
+
+// --- what the firmware did -----------------------------------------------------
+struct Request {            // outbound HTTP(S)
+  uint64_t    us;
+  std::string method, url, body;  // body only when short and textual
+  size_t      bytes;
+  int         code;
+  bool        connect;        // opened a connection first...
+  bool        resumed;        // ...resuming a TLS session
+};
+struct Served {             // inbound, on WebServer
+  uint64_t    us;
+  std::string uri;
+  int         code;
+  size_t      bytes;
+};
+const std::vector<Request>& requests();
+const std::vector<Served>&  served();
+
+// Flush stdio and leave without unwinding the sampler thread.
+[[noreturn]] void exit(int code);
+
+// --- shim internals ----------------------------------------------------------
+Request  http(const char* method, const std::string& url, const std::string& body, size_t bytes,
+              bool connect, bool resumed, int code = 0);   // code: a failure instead of the server's
+bool     pendingRequest(std::string& uri);
+void     servedRequest(const std::string& uri, int code, size_t bytes);
+bool     offline();   // now, per net().offline
+int      analogAt(int pin, uint64_t us);
+int      digitalLevel(int pin);
+void     attachIsr(int pin, void (*fn)(void*), void* arg, int mode);
+const char* fsPath();
+void     serialWrite(const uint8_t* buf, size_t n);
+
+}  // namespace sim
@@ -0,0 +1,204 @@
+// esp_camera on the host: frame buffers come from the installed
+// sim::FrameSource, captured on the virtual clock, and FrameFiles reads a
+// recorded sequence from disk.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <mutex>
+#include "Sim.h"
+#include "esp_camera.h"
+
+namespace {
+
+// The driver is configured for one frame buffer, grabbed when empty.
+std::mutex        mu;
+sim::FrameSource* source = nullptr;
+camera_fb_t       fb;
+bool              held   = false;
+size_t            next   = 0;   // first frame not yet handed out or skipped
+sim::CameraStats  stats  = {};
+
+bool endsWith(const std::string& s, const char* tail) {
+  size_t n = strlen(tail);
+  return s.size() >= n && strcasecmp(s.c_str() + s.size() - n, tail) == 0;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  out.resize(n > 0 ? n : 0);
+  bool ok = n > 0 && fread(out.data(), 1, n, f) == (size_t)n;
+  fclose(f);
+  return ok;
+}
+
+// Size from the first start-of-frame marker (baseline, extended or
+// progressive), the way the decoder would find it.
+bool jpegSize(const std::vector<uint8_t>& d, size_t& w, size_t& h) {
+  if (d.size() < 4 || d[0] != 0xFF || d[1] != 0xD8) return false;
+  size_t i = 2;
+  while (i + 4 <= d.size()) {
+    if (d[i] != 0xFF) return false;
+    uint8_t m   = d[i + 1];
+    size_t  len = (d[i + 2] << 8) | d[i + 3];
+    if (m >= 0xC0 && m <= 0xC2) {
+      if (i + 9 > d.size()) return false;
+      h = (d[i + 5] << 8) | d[i + 6];
+      w = (d[i + 7] << 8) | d[i + 8];
+      return w && h;
+    }
+    i += 2 + len;
+  }
+  return false;
+}
+
+// Binary PGM, maxval below 256: the header is stripped, leaving the pixels.
+bool pgm(std::vector<uint8_t>& d, size_t& w, size_t& h) {
+  if (d.size() < 2 || d[0] != 'P' || d[1] != '5') return false;
+  size_t i = 2;
+  long   field[3];
+  for (int k = 0; k < 3; k++) {
+    for (;;) {
+      while (i < d.size() && isspace(d[i])) i++;
+      if (i < d.size() && d[i] == '#') { while (i < d.size() && d[i] != '\n') i++; continue; }
+      break;
+    }
+    if (i >= d.size() || !isdigit(d[i])) return false;
+    field[k] = 0;
+    while (i < d.size() && isdigit(d[i])) field[k] = field[k] * 10 + (d[i++] - '0');
+  }
+  i++;   // the single whitespace before the pixels
+  w = field[0];
+  h = field[1];
+  if (field[2] > 255 || !w || !h || d.size() < i + w * h) return false;
+  d.erase(d.begin(), d.begin() + i);
+  d.resize(w * h);
+  return true;
+}
+
+}  // namespace
+
+namespace sim {
+
+bool FrameFiles::load(const std::vector<std::string>& paths, int w, int h) {
+  frames_.clear();
+  for (const std::string& p : paths) {
+    Frame f;
+    if (!readFile(p, f.data)) { error_ = "can't read " + p; return false; }
+    bool ok;
+    if (endsWith(p, ".jpg") || endsWith(p, ".jpeg")) {
+      f.format = PIXFORMAT_JPEG;
+      ok = jpegSize(f.data, f.width, f.height);
+    } else if (endsWith(p, ".pgm")) {
+      f.format = PIXFORMAT_GRAYSCALE;
+      ok = pgm(f.data, f.width, f.height);
+    } else if (endsWith(p, ".rgb565")) {
+      f.format = PIXFORMAT_RGB565;
+      f.width  = w;
+      f.height = h;
+      ok = w > 0 && h > 0 && f.data.size() == (size_t)w * h * 2;
+    } else {
+      error_ = p + ": not .jpg, .pgm or .rgb565";
+      return false;
+    }
+    if (!ok) { error_ = p + ": bad or unsized frame"; return false; }
+    frames_.push_back(std::move(f));
+  }
+  return true;
+}
+
+bool FrameFiles::pace(const char* timesCsv) {
+  FILE* f = fopen(timesCsv, "r");
+  if (!f) { error_ = std::string("can't read ") + timesCsv; return false; }
+  times_.clear();
+  char line[128];
+  while (fgets(line, sizeof line, f)) {
+    char* end;
+    double ms = strtod(line, &end);
+    if (end != line) times_.push_back((uint64_t)(ms * 1000));
+  }
+  fclose(f);
+  return true;
+}
+
+uint64_t FrameFiles::at(size_t i) const {
+  if (!times_.empty()) return i < times_.size() ? times_[i] : UINT64_MAX;
+  return (uint64_t)(i * 1e6 / fps_);
+}
+
+bool FrameFiles::frame(size_t i, camera_fb_t& out) {
+  if (i >= frames_.size()) return false;
+  Frame& f   = frames_[i];
+  out.buf    = f.data.data();
+  out.len    = f.data.size();
+  out.width  = f.width;
+  out.height = f.height;
+  out.format = f.format;
+  return true;
+}
+
+void camera(FrameSource* src) {
+  std::lock_guard<std::mutex> lk(mu);
+  source = src;
+  held   = false;
+  next   = 0;
+  stats  = {};
+}
+
+CameraStats cameraStats() {
+  std::lock_guard<std::mutex> lk(mu);
+  return stats;
+}
+
+}  // namespace sim
+
+sensor_t* esp_camera_sensor_get() {
+  // opaque to the firmware; only null-checked
+  static char sensor;
+  return source ? (sensor_t*)&sensor : nullptr;
+}
+
+camera_fb_t* esp_camera_fb_get() {
+  std::unique_lock<std::mutex> lk(mu);
+  if (!source) return nullptr;
+  if (held) { stats.held++; return nullptr; }
+  size_t n = source->count();
+  if (next >= n) return nullptr;
+
+  uint64_t due = source->at(next);
+  if (due == UINT64_MAX) return nullptr;
+  uint64_t t = sim::nowUs();
+  if (due > t) {
+    // nothing captured yet: the driver waits for the next frame
+    lk.unlock();
+    sim::sleepUs(due - t);
+    lk.lock();
+    stats.waitedMs += (uint32_t)((due - t) / 1000);
+    t = sim::nowUs();
+  }
+  // the newest frame captured by now; older ones were overwritten
+  size_t i = next;
+  while (i + 1 < n && source->at(i + 1) <= t) i++;
+  stats.skipped += (uint32_t)(i - next);
+  next = i + 1;
+
+  if (!source->frame(i, fb)) return nullptr;
+  uint64_t at = source->at(i);
+  fb.timestamp.tv_sec  = (time_t)(at / 1000000);
+  fb.timestamp.tv_usec = (suseconds_t)(at % 1000000);
+  held = true;
+  stats.grabs++;
+  return &fb;
+}
+
+void esp_camera_fb_return(camera_fb_t* f) {
+  std::lock_guard<std::mutex> lk(mu);
+  if (f == &fb) held = false;
+}
@@ -0,0 +1,17 @@
+// Host stand-ins for what src/app_httpd.cpp gives src/main.cpp. There is no
+// esp_http_server: /audio and /motion are not served, and motion and
+// breathing report nothing, as before the camera task has started.
+#include <Arduino.h>
+#include "SampleRing.h"
+#include "FrameDiff.h"
+#include "BreathRate.h"
+
+void startAudioStream(const SampleRing*, uint32_t, const volatile int*) {}
+
+void startCameraMotion(uint32_t, uint8_t, uint8_t) {}
+
+bool cameraMotion(FrameDiff::Snapshot*, uint32_t*) { return false; }
+
+bool cameraBreath(BreathRate::Estimate*) { return false; }
+
+void cameraHeatClear() {}
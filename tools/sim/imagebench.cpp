@@ -0,0 +1,236 @@
+// Times the image pipeline on a recorded frame sequence, for regression
+// tracking of the camera path.
+//
+//   imagebench [options] frame...
+//
+// Frames (.jpg, .pgm or raw .rgb565) play through the sim camera, captured
+// at --fps or at the times in --times, and are grabbed every --interval-ms
+// the way the motion task grabs them (0: every frame, waiting for each
+// capture). Each grab runs the stages src/app_httpd.cpp runs on it:
+//
+//   grab    esp_camera_fb_get()
+//   stream  the /stream multipart framing of a JPEG frame into a sink
+//   motion  FrameDiff::load() and process(), heat map included, on a
+//           grayscale frame
+//   breath  BreathRate::add() on FrameDiff's working frame
+//
+// JPEG decoding (esp_jpg_decode), frame2jpg and face detection are
+// esp32-camera and esp-dl code with no host build, so JPEG frames stop
+// after `stream` and other formats skip it. Prints JSON: per stage, the
+// frames it ran on, host ms/frame (mean and max) and heap allocations and
+// bytes per frame.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Sim.h"
+#include "FrameDiff.h"
+#include "BreathRate.h"
+
+// Every heap allocation goes through here, counted; glibc's own entry
+// points do the work.
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+
+static std::atomic<uint64_t> allocCount{0}, allocBytes{0};
+
+extern "C" void* malloc(size_t n) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  allocBytes.fetch_add(n, std::memory_order_relaxed);
+  return __libc_malloc(n);
+}
+
+extern "C" void* calloc(size_t k, size_t n) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  allocBytes.fetch_add(k * n, std::memory_order_relaxed);
+  return __libc_calloc(k, n);
+}
+
+extern "C" void* realloc(void* p, size_t n) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  allocBytes.fetch_add(n, std::memory_order_relaxed);
+  return __libc_realloc(p, n);
+}
+
+// as in src/app_httpd.cpp
+#define PART_BOUNDARY "123456789000000000000987654321"
+static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
+static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %d.%06d\r\n\r\n";
+
+struct Stage {
+  const char* name;
+  uint32_t    frames = 0;
+  double      ns     = 0;
+  double      maxNs  = 0;
+  uint64_t    allocs = 0;
+  uint64_t    bytes  = 0;
+};
+
+// Times one stage's run on one frame.
+class Timed {
+public:
+  explicit Timed(Stage& s)
+    : s_(s), allocs_(allocCount), bytes_(allocBytes), slept_(sim::sleptNs()),
+      t0_(std::chrono::steady_clock::now()) {}
+  ~Timed() {
+    if (dropped_) return;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0_).count()
+              - (double)(sim::sleptNs() - slept_);
+    s_.frames++;
+    s_.ns += ns;
+    if (ns > s_.maxNs) s_.maxNs = ns;
+    s_.allocs += allocCount - allocs_;
+    s_.bytes  += allocBytes - bytes_;
+  }
+  void drop() { dropped_ = true; }   // nothing to time after all
+
+private:
+  Stage&   s_;
+  bool     dropped_ = false;
+  uint64_t allocs_, bytes_, slept_;
+  std::chrono::steady_clock::time_point t0_;
+};
+
+// What httpd_resp_send_chunk() would put on the socket.
+static std::vector<uint8_t> sink;
+
+static void send(const void* buf, size_t n) {
+  const uint8_t* p = (const uint8_t*)buf;
+  sink.insert(sink.end(), p, p + n);
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: imagebench [options] frame...\n"
+    "  --size WxH             size of raw .rgb565 frames\n"
+    "  --fps N                capture rate (default 10)\n"
+    "  --times FILE           capture times instead, CSV t_ms per frame\n"
+    "  --interval-ms N        grab spacing, as the motion task (default 0: every frame)\n"
+    "  --noise N              FrameDiff noise threshold (default 12)\n");
+  exit(2);
+}
+
+static const char* formatName(pixformat_t f) {
+  switch (f) {
+    case PIXFORMAT_JPEG:      return "JPEG";
+    case PIXFORMAT_GRAYSCALE: return "GRAYSCALE";
+    case PIXFORMAT_RGB565:    return "RGB565";
+    default:                  return "other";
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> paths;
+  const char* timesPath = nullptr;
+  int         w = 0, h = 0, noise = 12;
+  double      fps = 10;
+  uint32_t    intervalMs = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if      (!strcmp(a, "--fps"))         fps        = atof(next());
+    else if (!strcmp(a, "--times"))       timesPath  = next();
+    else if (!strcmp(a, "--interval-ms")) intervalMs = atoi(next());
+    else if (!strcmp(a, "--noise"))       noise      = atoi(next());
+    else if (!strcmp(a, "--size")) {
+      if (sscanf(next(), "%dx%d", &w, &h) != 2) usage();
+    }
+    else if (a[0] == '-') usage();
+    else                  paths.push_back(a);
+  }
+  if (paths.empty() || fps <= 0) usage();
+
+  static sim::FrameFiles frames;
+  if (!frames.load(paths, w, h) || (timesPath && !frames.pace(timesPath))) {
+    fprintf(stderr, "%s\n", frames.error());
+    return 1;
+  }
+  if (!timesPath) frames.pace(fps);
+  sim::camera(&frames);
+
+  FrameDiff diff;
+  diff.begin(noise, 1);
+  static uint16_t heat[FrameDiff::W * FrameDiff::H];
+  diff.heatmap(heat);
+  BreathRate       breath;
+  BreathRateConfig cfg;
+  std::vector<uint16_t> store(BreathRate::STORE_BYTES / sizeof(uint16_t));
+  if (intervalMs) {
+    cfg.periodMs = intervalMs;
+    cfg.hop      = (1000 + intervalMs / 2) / intervalMs;
+  }
+  breath.begin(cfg, store.data());
+  sink.reserve(256 * 1024);
+
+  Stage grab{"grab"}, stream{"stream"}, motion{"motion"}, est{"breath"};
+  pixformat_t format = PIXFORMAT_JPEG;
+  size_t      width = 0, height = 0;
+  double      len = 0;
+  auto wall0 = std::chrono::steady_clock::now();
+
+  for (;;) {
+    if (intervalMs) sim::sleepUs((uint64_t)intervalMs * 1000);
+    camera_fb_t* fb;
+    {
+      Timed t(grab);
+      fb = esp_camera_fb_get();
+      if (!fb) t.drop();
+    }
+    if (!fb) break;   // the sequence is over
+    format = fb->format;
+    width  = fb->width;
+    height = fb->height;
+    len   += fb->len;
+
+    if (fb->format == PIXFORMAT_JPEG) {
+      Timed t(stream);
+      char part_buf[128];
+      sink.clear();
+      send(_STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
+      size_t hlen = snprintf(part_buf, sizeof part_buf, _STREAM_PART, (unsigned)fb->len,
+                             (int)fb->timestamp.tv_sec, (int)fb->timestamp.tv_usec);
+      send(part_buf, hlen);
+      send(fb->buf, fb->len);
+    }
+    if (fb->format == PIXFORMAT_GRAYSCALE) {
+      {
+        Timed t(motion);
+        diff.load(fb->buf, fb->width, fb->height, fb->width);
+        diff.process();
+      }
+      Timed t(est);
+      breath.add(diff.frame(), FrameDiff::W, FrameDiff::H, FrameDiff::W);
+    }
+    esp_camera_fb_return(fb);
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+
+  sim::CameraStats cs = sim::cameraStats();
+  printf("{\n  \"frames\": {\"files\": %zu, \"format\": \"%s\", \"width\": %zu, \"height\": %zu, \"bytes_mean\": %.0f},\n",
+         frames.count(), formatName(format), width, height, cs.grabs ? len / cs.grabs : 0.0);
+  printf("  \"camera\": {\"grabs\": %u, \"skipped\": %u, \"held\": %u, \"waited_ms\": %u, \"virtual_s\": %.1f, \"wall_s\": %.3f},\n",
+         cs.grabs, cs.skipped, cs.held, cs.waitedMs, sim::nowUs() / 1e6, wall);
+  printf("  \"stages\": {");
+  const Stage* stages[] = { &grab, &stream, &motion, &est };
+  for (size_t i = 0; i < sizeof stages / sizeof *stages; i++) {
+    const Stage& s = *stages[i];
+    double n = s.frames ? s.frames : 1;
+    printf("%s\n    \"%s\": {\"frames\": %u, \"ms_mean\": %.4f, \"ms_max\": %.4f, "
+           "\"allocs_per_frame\": %.2f, \"bytes_per_frame\": %.0f}",
+           i ? "," : "", s.name, s.frames, s.ns / n / 1e6, s.maxNs / 1e6, s.allocs / n, s.bytes / n);
+  }
+  const BreathRate::Estimate& e = breath.estimate();
+  printf("\n  },\n  \"motion\": {\"frames\": %u, \"last_total\": %u, \"heat_peak\": %u, \"heat_halvings\": %u},\n",
+         diff.frames(), diff.total(), diff.heatPeak(), diff.heatHalvings());
+  printf("  \"breath\": {\"state\": \"%s\", \"bpm\": %.1f, \"quality\": %u}\n}\n",
+         BreathRate::stateName(e.state), e.bpmX10 / 10.0, e.quality);
+  sim::exit(0);
+}
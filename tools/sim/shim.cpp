@@ -0,0 +1,667 @@
+// The virtual clock, scripted pins and the Arduino/ESP-IDF shims on top of
+// them. See Sim.h.
+#include "Sim.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <WebServer.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <AudioFileSourceHTTPStream.h>
+#include <AudioGeneratorMP3.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "hal/gpio_ll.h"
+#include "driver/adc.h"
+
+namespace {
+
+// --- clock and lockstep ------------------------------------------------------
+// Task threads block only in wait(), until a virtual time. The main thread
+// moves the clock from one wake-up to the next, and at each one waits until
+// every task it woke has blocked again, so a task sees esp_timer time as it
+// would on the chip and the whole run is deterministic.
+const uint64_t                NEVER = UINT64_MAX;
+std::mutex                    mu;
+std::condition_variable       cv;
+std::atomic<uint64_t>         now{0};
+int                           running = 0;
+std::vector<const uint64_t*>  waiting;   // wake times of blocked tasks
+uint64_t                      sleptNs = 0;
+
+bool settled() {
+  if (running) return false;
+  for (const uint64_t* at : waiting) if (*at <= now) return false;
+  return true;
+}
+
+uint64_t nextWake() {
+  uint64_t next = NEVER;
+  for (const uint64_t* at : waiting) next = std::min(next, *at);
+  return next;
+}
+
+// Called by task threads with `mu` held. `at` may move while blocked (the
+// ADC's depends on its start time), so it is kept by address.
+void wait(std::unique_lock<std::mutex>& lk, const uint64_t& at) {
+  running--;
+  waiting.push_back(&at);
+  cv.notify_all();
+  cv.wait(lk, [&] { return at <= now; });
+  waiting.erase(std::find(waiting.begin(), waiting.end(), &at));
+  running++;
+}
+
+std::thread::id mainThread = std::this_thread::get_id();
+
+// A task's notification state; its TaskHandle_t.
+struct Task {
+  uint64_t wakeAt   = NEVER;
+  uint32_t notified = 0;
+};
+thread_local Task* self = nullptr;
+
+// --- scripted pins -----------------------------------------------------------
+struct Analog {
+  const int16_t* samples = nullptr;
+  size_t         n       = 0;
+  uint32_t       rate    = 0;
+  int            level   = 0;   // after the trace, or throughout without one
+};
+std::map<int, Analog> analog;
+std::map<int, int>    digital;
+
+struct Isr { void (*fn)(void*); void* arg; int mode; };
+std::map<int, Isr> isrs;
+
+struct Edge { int pin; bool level; };
+std::multimap<uint64_t, Edge>        edges;
+std::multimap<uint64_t, std::string> inbound;
+
+// --- ADC continuous driver ---------------------------------------------------
+struct Adc {
+  bool     configured = false;
+  bool     started    = false;
+  uint64_t startUs    = 0;
+  uint32_t freqHz     = 0;
+  uint64_t taken      = 0;   // conversions read so far
+  std::vector<adc_digi_pattern_config_t> pattern;
+} adc;
+
+// Conversion k of the pattern completes at startUs + k / freq.
+uint64_t adcAt(uint64_t k) {
+  return adc.startUs + (k * 1000000 + adc.freqHz - 1) / adc.freqHz;
+}
+
+// --- recorded activity ---------------------------------------------------------
+sim::Net                  netCfg;
+std::string               fsDir;
+FILE*                     serialOut = stderr;
+bool                      lineStart = true;
+std::vector<sim::Request> requestLog;
+std::vector<sim::Served>  servedLog;
+
+std::map<std::string, std::map<std::string, std::string>> nvs;
+
+}  // namespace
+
+namespace sim {
+
+uint64_t nowUs()   { return now; }
+uint64_t sleptNs() { return ::sleptNs; }
+
+void sleepUs(uint64_t us) {
+  if (std::this_thread::get_id() != mainThread) {
+    // another task: wait for the main thread to bring the clock here
+    std::unique_lock<std::mutex> lk(mu);
+    uint64_t until = now + us;
+    wait(lk, until);
+    return;
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t target = now + us;
+  std::unique_lock<std::mutex> lk(mu);
+  for (;;) {
+    uint64_t next = std::min(nextWake(), target);
+    if (!edges.empty() && edges.begin()->first < next) {
+      // an edge: the ISR runs at its own time, as on the chip
+      auto e = edges.begin();
+      if (e->first > now) now = e->first;
+      int  pin  = e->second.pin;
+      bool rise = e->second.level && !digital[pin];
+      bool fall = !e->second.level && digital[pin];
+      digital[pin] = e->second.level;
+      edges.erase(e);
+      auto isr = isrs.find(pin);
+      if (isr != isrs.end() && ((rise && isr->second.mode != FALLING) || (fall && isr->second.mode != RISING))) {
+        lk.unlock();
+        isr->second.fn(isr->second.arg);
+        lk.lock();
+      }
+      continue;
+    }
+    if (next > now) now = next;
+    cv.notify_all();
+    cv.wait(lk, settled);
+    if (now >= target) break;
+  }
+  lk.unlock();
+  ::sleptNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void analogTrace(int pin, const int16_t* samples, size_t n, uint32_t rateHz, int after) {
+  Analog& a = analog[pin];
+  a.samples = samples;
+  a.n       = n;
+  a.rate    = rateHz;
+  a.level   = after;
+}
+
+void analogLevel(int pin, int value) {
+  analog[pin] = Analog();
+  analog[pin].level = value;
+}
+
+void digitalAt(uint64_t us, int pin, bool level) { edges.insert({ us, { pin, level } }); }
+void requestAt(uint64_t us, const std::string& uri) { inbound.insert({ us, uri }); }
+
+int analogAt(int pin, uint64_t us) {
+  auto it = analog.find(pin);
+  if (it == analog.end()) return 0;
+  const Analog& a = it->second;
+  uint64_t i = a.rate ? us * a.rate / 1000000 : 0;
+  int v = i < a.n ? a.samples[i] : a.level;
+  return v < 0 ? 0 : v > 4095 ? 4095 : v;
+}
+
+int digitalLevel(int pin) { return digital[pin]; }
+
+void attachIsr(int pin, void (*fn)(void*), void* arg, int mode) {
+  if (fn) isrs[pin] = { fn, arg, mode };
+  else    isrs.erase(pin);
+}
+
+Net&        net()                   { return netCfg; }
+void        fsRoot(const char* dir) { fsDir = dir ? dir : ""; }
+const char* fsPath()                { return fsDir.c_str(); }
+void        serialTo(FILE* f)       { serialOut = f; }
+
+void serialWrite(const uint8_t* buf, size_t n) {
+  if (!serialOut) return;
+  for (size_t i = 0; i < n; i++) {
+    if (buf[i] == '\r') continue;
+    if (lineStart) {
+      uint64_t ms = now / 1000;
+      fprintf(serialOut, "%02u:%02u:%02u.%03u ", (unsigned)(ms / 3600000), (unsigned)(ms / 60000 % 60),
+              (unsigned)(ms / 1000 % 60), (unsigned)(ms % 1000));
+    }
+    fputc(buf[i], serialOut);
+    lineStart = buf[i] == '\n';
+  }
+}
+
+Request http(const char* method, const std::string& url, const std::string& body, size_t bytes,
+             bool connect, bool resumed, int code) {
+  int status = code ? code : netCfg.code;
+  for (const auto& c : netCfg.codeAt) {
+    size_t n = c.first.size();
+    if (!code && url.size() >= n && !url.compare(url.size() - n, n, c.first)) status = c.second;
+  }
+  requestLog.push_back({ now, method, url, body, bytes, status, connect, resumed });
+  Request r = requestLog.back();
+  if (!code) sleepUs((uint64_t)netCfg.httpMs * 1000);
+  return r;
+}
+
+bool offline() {
+  for (const auto& w : netCfg.offline) {
+    if (now >= (uint64_t)w.first * 1000000 && now < (uint64_t)w.second * 1000000) return true;
+  }
+  return false;
+}
+
+bool pendingRequest(std::string& uri) {
+  if (inbound.empty() || inbound.begin()->first > now) return false;
+  uri = inbound.begin()->second;
+  inbound.erase(inbound.begin());
+  return true;
+}
+
+void servedRequest(const std::string& uri, int code, size_t bytes) {
+  servedLog.push_back({ now, uri, code, bytes });
+}
+
+const std::vector<Request>& requests() { return requestLog; }
+const std::vector<Served>&  served()   { return servedLog; }
+
+void exit(int code) {
+  fflush(stdout);
+  fflush(stderr);
+  if (serialOut) fflush(serialOut);
+  _exit(code);
+}
+
+}  // namespace sim
+
+// --- Arduino core ----------------------------------------------------------------
+HardwareSerial Serial;
+EspClass       ESP;
+WiFiClass      WiFi;
+LittleFSFS     LittleFS;
+gpio_dev_t     GPIO;
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  sim::serialWrite(buf, n);
+  return n;
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char    small[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(small, sizeof(small), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, n);
+  std::string big(n + 1, '\0');
+  va_start(ap, fmt);
+  vsnprintf(&big[0], big.size(), fmt, ap);
+  va_end(ap);
+  return write((const uint8_t*)big.data(), n);
+}
+
+void EspClass::restart() {
+  Serial.println("[SIM] ESP.restart()");
+  sim::exit(3);
+}
+
+unsigned long millis() { return (unsigned long)(uint32_t)(sim::nowUs() / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)sim::nowUs(); }
+void delay(uint32_t ms) { sim::sleepUs((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { sim::sleepUs(us); }
+void yield() {}
+static uint64_t syncedAt = UINT64_MAX;
+
+void configTime(long, int, const char*, const char*, const char*) {
+  syncedAt = sim::nowUs() + (uint64_t)sim::net().ntpMs * 1000;
+}
+
+time_t simTime(time_t* t) {
+  uint64_t us = sim::nowUs();
+  time_t   s  = (time_t)(us / 1000000) + (us >= syncedAt ? (time_t)sim::net().epoch : 0);
+  if (t) *t = s;
+  return s;
+}
+
+void     pinMode(uint8_t, uint8_t) {}
+int      digitalRead(uint8_t pin) { return sim::digitalLevel(pin); }
+void     digitalWrite(uint8_t, uint8_t) {}
+uint16_t analogRead(uint8_t pin) { return (uint16_t)sim::analogAt(pin, sim::nowUs()); }
+void     analogReadResolution(uint8_t) {}
+void     analogSetAttenuation(adc_attenuation_t) {}
+void     attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode) { sim::attachIsr(pin, fn, arg, mode); }
+void     detachInterrupt(uint8_t pin) { sim::attachIsr(pin, nullptr, nullptr, 0); }
+
+// --- ESP-IDF -------------------------------------------------------------------------
+int64_t esp_timer_get_time() { return (int64_t)sim::nowUs(); }
+
+uint32_t esp_cpu_get_ccount() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  Task* task = new Task;
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    running++;  // until it first blocks, the clock waits for it
+  }
+  std::thread([fn, arg, task] {
+    self = task;
+    fn(arg);
+    std::lock_guard<std::mutex> lk(mu);
+    running--;
+    cv.notify_all();
+  }).detach();
+  if (handle) *handle = task;
+  return pdPASS;
+}
+
+void       vTaskDelay(TickType_t ticks) { sim::sleepUs((uint64_t)ticks * 1000); }
+TickType_t xTaskGetTickCount() { return (TickType_t)(sim::nowUs() / 1000); }
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  std::unique_lock<std::mutex> lk(mu);
+  Task* t = self;
+  if (!t->notified && ticks) {
+    t->wakeAt = ticks == portMAX_DELAY ? NEVER : now + (uint64_t)ticks * 1000;
+    wait(lk, t->wakeAt);
+    t->wakeAt = NEVER;
+  }
+  uint32_t n = t->notified;
+  t->notified = clearOnExit ? 0 : n ? n - 1 : 0;
+  return n;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+  std::lock_guard<std::mutex> lk(mu);
+  Task* t = (Task*)handle;
+  t->notified++;
+  // not now: the notifier runs on until it sleeps, as on the other core
+  if (t->wakeAt > now + 1) t->wakeAt = now + 1;
+  return pdPASS;
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t*) { return ESP_OK; }
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* cfg) {
+  if (!cfg->pattern_num || !cfg->sample_freq_hz) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lk(mu);
+  adc.pattern.assign(cfg->adc_pattern, cfg->adc_pattern + cfg->pattern_num);
+  adc.freqHz     = cfg->sample_freq_hz;
+  adc.configured = true;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_start() {
+  std::lock_guard<std::mutex> lk(mu);
+  if (!adc.configured) return ESP_ERR_INVALID_STATE;
+  adc.started = true;
+  adc.startUs = now;
+  adc.taken   = 0;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_stop() {
+  std::lock_guard<std::mutex> lk(mu);
+  adc.started = false;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize() {
+  adc_digi_stop();
+  adc.configured = false;
+  return ESP_OK;
+}
+
+// ADC1 channel c is GPIO c+1 on the S3.
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length, uint32_t* outLength, uint32_t) {
+  uint32_t want = length / SOC_ADC_DIGI_RESULT_BYTES;
+  std::unique_lock<std::mutex> lk(mu);
+  uint64_t at = adc.started ? adcAt(adc.taken + want) : NEVER;
+  wait(lk, at);
+  adc_digi_output_data_t* out = (adc_digi_output_data_t*)buf;
+  for (uint32_t i = 0; i < want; i++) {
+    uint64_t k = adc.taken + i;
+    const adc_digi_pattern_config_t& p = adc.pattern[k % adc.pattern.size()];
+    out[i].val           = 0;
+    out[i].type2.data    = sim::analogAt(p.channel + 1, adcAt(k));
+    out[i].type2.channel = p.channel;
+    out[i].type2.unit    = p.unit;
+  }
+  adc.taken += want;
+  *outLength = want * SOC_ADC_DIGI_RESULT_BYTES;
+  return ESP_OK;
+}
+
+// --- WiFi / HTTP -------------------------------------------------------------------
+wl_status_t WiFiClass::begin(const char*, const char*) {
+  begun_ = true;
+  upAt_  = sim::nowUs() + (uint64_t)sim::net().wifiMs * 1000;
+  return status();
+}
+
+bool WiFiClass::disconnect(bool) {
+  begun_ = false;
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  if (!begun_) return WL_IDLE_STATUS;
+  return sim::nowUs() >= upAt_ ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+  if (!insecure_ && !ca_) return 0;   // nothing to verify the server with
+  sim::sleepUs((uint64_t)sim::net().tlsMs * 1000);
+  return WiFiClient::connect(host, port, timeoutMs);
+}
+
+int HTTPClient::connect() {
+  if (client_->open_ && sim::offline()) {
+    client_->open_ = false;   // nothing comes back; the client gives up on it
+    return HTTPC_ERROR_CONNECTION_LOST;
+  }
+  if (client_->open_ && sim::nowUs() - client_->lastUs_ >= (uint64_t)sim::net().idleMs * 1000) {
+    client_->open_ = false;   // the server closed it; the client finds out now
+    return HTTPC_ERROR_CONNECTION_LOST;
+  }
+  if (client_->open_) return 0;
+  // https://host[:port]/path
+  size_t from = url_.indexOf("://") + 3, to = from;
+  while (to < url_.length() && url_[to] != '/' && url_[to] != ':') to++;
+  uint16_t port = to < url_.length() && url_[to] == ':' ? atoi(url_.c_str() + to + 1) : 443;
+  return client_->connect(url_.substring(from, to).c_str(), port, 5000) ? 0 : HTTPC_ERROR_CONNECTION_REFUSED;
+}
+
+void HTTPClient::done() {
+  client_->open_   = true;
+  client_->lastUs_ = sim::nowUs();
+}
+
+int HTTPClient::send(const char* type, const char* body, size_t size) {
+  bool text  = size <= 1024 && memchr(body, 0, size) == nullptr;
+  bool fresh = !client_->open_;
+  int  lost  = connect();
+  sim::Request r = sim::http(type, url_.c_str(), text ? std::string(body, size) : std::string(), size,
+                             fresh, fresh && client_->resumed_, lost);
+  if (lost) return lost;
+  done();
+  response_ = r.code >= 200 && r.code < 300 && url_.endsWith("/users/login") ? "{\"token\":\"sim\"}" : "";
+  return r.code;
+}
+
+int HTTPClient::sendRequest(const char* type, Stream* stream, size_t size) {
+  bool fresh = !client_->open_;
+  int  lost  = connect();
+  if (lost) {
+    sim::http(type, url_.c_str(), std::string(), size, fresh, false, lost);
+    return lost;
+  }
+  // drain it, so a generated body (a clip being encoded) costs what it would
+  char   chunk[1024];
+  size_t total = 0, n;
+  while (total < size && (n = stream->readBytes(chunk, sizeof(chunk))) > 0) total += n;
+  sim::Request r = sim::http(type, url_.c_str(), std::string(), total, fresh, fresh && client_->resumed_);
+  done();
+  response_ = "";
+  return r.code;
+}
+
+bool AudioFileSourceHTTPStream::open(const char* url) {
+  // its own connection, every time
+  sim::sleepUs((uint64_t)sim::net().tlsMs * 1000);
+  sim::Request r = sim::http("GET", url, std::string(), 0, true, false,
+                             sim::offline() ? HTTPC_ERROR_CONNECTION_REFUSED : 0);
+  open_ = r.code >= 200 && r.code < 300;
+  return open_;
+}
+
+// --- WebServer --------------------------------------------------------------------------
+void WebServer::handleClient() {
+  std::string req;
+  while (begun_ && sim::pendingRequest(req)) {
+    size_t q = req.find('?');
+    uri_ = req.substr(0, q).c_str();
+    args_.clear();
+    for (size_t p = q; p != std::string::npos && p + 1 < req.size(); ) {
+      size_t amp = req.find('&', p + 1);
+      std::string kv = req.substr(p + 1, amp == std::string::npos ? std::string::npos : amp - p - 1);
+      size_t eq = kv.find('=');
+      args_.push_back({ kv.substr(0, eq).c_str(), eq == std::string::npos ? "" : kv.substr(eq + 1).c_str() });
+      p = amp;
+    }
+    code_  = 0;
+    bytes_ = 0;
+    bool found = false;
+    for (const Route& r : routes_) {
+      if (r.uri == uri_ && (r.method == HTTP_ANY || r.method == HTTP_GET)) {
+        r.fn();
+        found = true;
+        break;
+      }
+    }
+    if (!found && notFound_) notFound_();
+    else if (!found)         send(404, "text/plain", "Not found");
+    sim::servedRequest(req, code_, bytes_);
+  }
+}
+
+String WebServer::arg(const String& name) const {
+  for (const Arg& a : args_) if (a.name == name) return a.value;
+  return String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+  for (const Arg& a : args_) if (a.name == name) return true;
+  return false;
+}
+
+// --- Preferences ---------------------------------------------------------------------
+bool Preferences::put(const char* key, const std::string& value) {
+  if (ns_.empty() || readOnly_) return false;
+  nvs[ns_][key] = value;
+  return true;
+}
+
+bool Preferences::get(const char* key, std::string& value) {
+  auto ns = nvs.find(ns_);
+  if (ns == nvs.end()) return false;
+  auto it = ns->second.find(key);
+  if (it == ns->second.end()) return false;
+  value = it->second;
+  return true;
+}
+
+bool Preferences::clear() {
+  if (ns_.empty() || readOnly_) return false;
+  nvs.erase(ns_);
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (ns_.empty() || readOnly_) return false;
+  return nvs[ns_].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+  std::string v;
+  return get(key, v);
+}
+
+String Preferences::getString(const char* key, const String& def) {
+  std::string v;
+  return get(key, v) ? String(v) : def;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t def) {
+  std::string v;
+  return get(key, v) ? (int32_t)strtol(v.c_str(), nullptr, 10) : def;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t def) {
+  std::string v;
+  return get(key, v) ? (uint32_t)strtoul(v.c_str(), nullptr, 10) : def;
+}
+
+// --- LittleFS -------------------------------------------------------------------------
+bool LittleFSFS::begin(bool, const char*, uint8_t, const char*) {
+  mounted_ = *sim::fsPath() != 0;
+  return mounted_;
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+  const char* host = !strcmp(mode, "r") ? "rb" : !strcmp(mode, "w") ? "wb" : !strcmp(mode, "a") ? "ab" : nullptr;
+  if (!mounted_ || !host) return File();
+  return File(fopen((std::string(sim::fsPath()) + path).c_str(), host));
+}
+
+bool LittleFSFS::remove(const char* path) {
+  return mounted_ && ::remove((std::string(sim::fsPath()) + path).c_str()) == 0;
+}
+
+bool LittleFSFS::exists(const char* path) {
+  File f = open(path);
+  bool ok = f;
+  f.close();
+  return ok;
+}
+
+String File::readString() {
+  String s;
+  char   buf[256];
+  size_t n;
+  while (f_ && (n = fread(buf, 1, sizeof(buf) - 1, f_)) > 0) {
+    buf[n] = 0;
+    s += buf;
+  }
+  return s;
+}
+
+size_t File::size() {
+  if (!f_) return 0;
+  long at = ftell(f_);
+  fseek(f_, 0, SEEK_END);
+  long end = ftell(f_);
+  fseek(f_, at, SEEK_SET);
+  return (size_t)end;
+}
+
+int File::available() {
+  return f_ ? (int)(size() - ftell(f_)) : 0;
+}
+
+// --- audio ------------------------------------------------------------------------------
+bool AudioGeneratorMP3::begin(AudioFileSource* source, AudioOutput* output) {
+  if (!source || !output || !source->isOpen()) return false;
+  src_ = source;
+  out_ = output;
+  out_->SetRate(44100);
+  out_->SetChannels(2);
+  out_->begin();
+  startUs_ = sim::nowUs();
+  played_  = 0;
+  running_ = true;
+  return true;
+}
+
+bool AudioGeneratorMP3::loop() {
+  if (!running_) return false;
+  uint64_t elapsed = sim::nowUs() - startUs_;
+  uint64_t songUs  = (uint64_t)sim::net().songMs * 1000;
+  uint64_t due     = (elapsed < songUs ? elapsed : songUs) * 44100 / 1000000;
+  int16_t  silence[2] = { 0, 0 };
+  for (; played_ < due; played_++) {
+    if (!out_->ConsumeSample(silence)) break;
+  }
+  if (elapsed >= songUs) stop();
+  return running_;
+}
+
+bool AudioGeneratorMP3::stop() {
+  if (running_ && out_) out_->stop();
+  running_ = false;
+  return true;
+}
@@ -0,0 +1,184 @@
+#pragma once
+// Host stand-in for the Arduino-ESP32 core: only what src/main.cpp and the
+// libraries it links use, on tools/sim's virtual clock.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR   // zeroed like any global: every run is a power-on
+#define BIT(nr) (1UL << (nr))
+
+#define LOW     0x0
+#define HIGH    0x1
+#define INPUT   0x01
+#define OUTPUT  0x03
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+// --- String ------------------------------------------------------------------
+class String {
+public:
+  String(const char* s = "") : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  String(int v)           : s_(std::to_string(v)) {}
+  String(unsigned v)      : s_(std::to_string(v)) {}
+  String(long v)          : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(double v, unsigned decimals = 2) {
+    char b[32];
+    snprintf(b, sizeof(b), "%.*f", decimals, v);
+    s_ = b;
+  }
+
+  const char* c_str()  const { return s_.c_str(); }
+  unsigned    length() const { return (unsigned)s_.size(); }
+  bool        reserve(unsigned n) { s_.reserve(n); return true; }
+  bool        isEmpty() const { return s_.empty(); }
+
+  bool concat(const String& s) { s_ += s.s_; return true; }
+  bool concat(const char* s)   { if (!s) return false; s_ += s; return true; }
+  bool concat(char c)          { s_ += c; return true; }
+  String& operator+=(const String& s) { s_ += s.s_; return *this; }
+  String& operator+=(const char* s)   { concat(s); return *this; }
+  String& operator+=(char c)          { s_ += c; return *this; }
+
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b)   { String r(a); r.concat(b); return r; }
+  friend String operator+(const char* a, const String& b)   { return String(std::string(a) + b.s_); }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o)   const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* o)   const { return !(*this == o); }
+  bool operator<(const String& o)  const { return s_ < o.s_; }
+  char  operator[](unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+  char& operator[](unsigned i)       { return s_[i]; }
+
+  int indexOf(char c, unsigned from = 0) const {
+    size_t p = s_.find(c, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int indexOf(const char* s, unsigned from = 0) const {
+    size_t p = s_.find(s, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  String substring(unsigned from, unsigned to = ~0u) const {
+    if (from > s_.size()) return String();
+    return String(s_.substr(from, to > s_.size() ? std::string::npos : to - from));
+  }
+  bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  bool endsWith(const String& p) const {
+    return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+  }
+  long  toInt()   const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+private:
+  std::string s_;
+};
+
+// --- Print / Stream ------------------------------------------------------------
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    size_t k = 0;
+    while (n--) k += write(*buf++);
+    return k;
+  }
+  virtual void flush() {}
+
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s)    { return write(s); }
+  size_t print(const String& s)  { return write(s.c_str()); }
+  size_t print(char c)           { return write((uint8_t)c); }
+  size_t print(int v)            { return printf("%d", v); }
+  size_t print(unsigned v)       { return printf("%u", v); }
+  size_t print(long v)           { return printf("%ld", v); }
+  size_t print(unsigned long v)  { return printf("%lu", v); }
+  size_t print(double v, int d = 2) { return printf("%.*f", d, v); }
+  size_t println()               { return write("\r\n"); }
+  template <typename T> size_t println(const T& v) { return print(v) + println(); }
+  size_t println(double v, int d) { return print(v, d) + println(); }
+  size_t printf(const char* fmt, ...);
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual size_t readBytes(char* buf, size_t len) {
+    size_t n = 0;
+    for (int c; n < len && (c = read()) >= 0; ) buf[n++] = (char)c;
+    return n;
+  }
+  size_t readBytes(uint8_t* buf, size_t len) { return readBytes((char*)buf, len); }
+  void setTimeout(unsigned long) {}
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end() {}
+  operator bool() const { return true; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  [[noreturn]] void restart();
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getFreeHeap()   { return 320 * 1024; }
+  uint32_t getFreePsram()  { return 8 * 1024 * 1024; }
+};
+extern EspClass ESP;
+
+// --- time ------------------------------------------------------------------------
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+// --- pins ------------------------------------------------------------------------
+typedef enum { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db } adc_attenuation_t;
+
+void     pinMode(uint8_t pin, uint8_t mode);
+int      digitalRead(uint8_t pin);
+void     digitalWrite(uint8_t pin, uint8_t level);
+uint16_t analogRead(uint8_t pin);
+void     analogReadResolution(uint8_t bits);
+void     analogSetAttenuation(adc_attenuation_t atten);
+void     attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode);
+void     detachInterrupt(uint8_t pin);
+#define  digitalPinToInterrupt(p) (p)
+// ESP32-S3: GPIO1..10 are ADC1 channels 0..9, GPIO11..20 ADC2's
+inline int8_t digitalPinToAnalogChannel(uint8_t pin) {
+  return pin >= 1 && pin <= 20 ? (int8_t)(pin - 1) : -1;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "AudioFileSource.h"
+
+class AudioFileSourceBuffer : public AudioFileSource {
+public:
+  AudioFileSourceBuffer(AudioFileSource* in, uint32_t bufferBytes) : src_(in) { (void)bufferBytes; }
+  bool     close() override { return src_ && src_->close(); }
+  bool     isOpen() override { return src_ && src_->isOpen(); }
+  uint32_t getSize() override { return src_ ? src_->getSize() : 0; }
+
+private:
+  AudioFileSource* src_;
+};
@@ -0,0 +1,15 @@
+#pragma once
+// open() is one logged GET (see HTTPClient.h); it succeeds on a 2xx.
+#include "AudioFileSource.h"
+
+class AudioFileSourceHTTPStream : public AudioFileSource {
+public:
+  AudioFileSourceHTTPStream() {}
+  explicit AudioFileSourceHTTPStream(const char* url) { open(url); }
+  bool open(const char* url) override;
+  bool close() override { open_ = false; return true; }
+  bool isOpen() override { return open_; }
+
+private:
+  bool open_ = false;
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include "AudioFileSource.h"
+#include "AudioOutput.h"
+
+class AudioGenerator {
+public:
+  virtual ~AudioGenerator() {}
+  virtual bool begin(AudioFileSource* source, AudioOutput* output) = 0;
+  virtual bool loop() = 0;
+  virtual bool stop() = 0;
+  virtual bool isRunning() = 0;
+};
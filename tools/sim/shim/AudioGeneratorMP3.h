@@ -0,0 +1,20 @@
+#pragma once
+// "Plays" an open source for sim::net().songMs of virtual time: loop()
+// pushes silence at 44.1 kHz for the time since its last call, so the
+// output sees the real sample count and pacing.
+#include "AudioGenerator.h"
+
+class AudioGeneratorMP3 : public AudioGenerator {
+public:
+  bool begin(AudioFileSource* source, AudioOutput* output) override;
+  bool loop() override;
+  bool stop() override;
+  bool isRunning() override { return running_; }
+
+private:
+  AudioFileSource* src_     = nullptr;
+  AudioOutput*     out_     = nullptr;
+  bool             running_ = false;
+  uint64_t         startUs_ = 0;
+  uint64_t         played_  = 0;  // samples
+};
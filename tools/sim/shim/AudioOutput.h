@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+class AudioOutput {
+public:
+  virtual ~AudioOutput() {}
+  virtual bool SetRate(int hz) { hertz = hz; return true; }
+  virtual bool SetBitsPerSample(int bits) { bps = bits; return true; }
+  virtual bool SetChannels(int chan) { channels = chan; return true; }
+  virtual bool SetGain(float f) { gainF2P6 = (uint8_t)(f * (1 << 6)); return true; }
+  virtual bool begin() { return true; }
+  virtual bool ConsumeSample(int16_t sample[2]) { (void)sample; return false; }
+  virtual bool stop() { return true; }
+
+protected:
+  uint16_t hertz    = 44100;
+  uint8_t  bps      = 16;
+  uint8_t  channels = 2;
+  uint8_t  gainF2P6 = 1 << 6;
+};
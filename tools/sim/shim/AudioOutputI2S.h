@@ -0,0 +1,13 @@
+#pragma once
+// Samples go nowhere; there is no acoustic path back to the mic trace.
+#include "AudioOutput.h"
+
+class AudioOutputI2S : public AudioOutput {
+public:
+  bool SetPinout(int bclkPin, int wclkPin, int doutPin) { (void)bclkPin; (void)wclkPin; (void)doutPin; return true; }
+  bool SetOutputModeMono(bool mono) { mono_ = mono; return true; }
+  bool ConsumeSample(int16_t sample[2]) override { (void)sample; return true; }
+
+private:
+  bool mono_ = false;
+};
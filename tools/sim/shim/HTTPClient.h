@@ -0,0 +1,65 @@
+#pragma once
+// Every request is logged with its virtual time, blocks its caller for
+// sim::net().httpMs (after the client's connect() when it has to connect
+// first) and gets sim::net().code. A login gets a token back; other responses are empty.
+// With reuse on, the connection stays open after end(); a request on one
+// the server has since dropped fails with HTTPC_ERROR_CONNECTION_LOST.
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+
+#define HTTP_CODE_OK               200
+#define HTTP_CODE_NO_CONTENT       204
+#define HTTP_CODE_BAD_REQUEST      400
+#define HTTP_CODE_UNAUTHORIZED     401
+#define HTTP_CODE_NOT_FOUND        404
+#define HTTPC_ERROR_CONNECTION_REFUSED   (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED   (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED  (-3)
+#define HTTPC_ERROR_NOT_CONNECTED        (-4)
+#define HTTPC_ERROR_CONNECTION_LOST      (-5)
+#define HTTPC_ERROR_READ_TIMEOUT         (-11)
+
+class HTTPClient {
+public:
+  bool begin(WiFiClient& client, const String& url) {
+    client_ = &client;
+    url_    = url;
+    headers_.clear();
+    response_ = String();
+    return true;
+  }
+  bool begin(const String& url) { return begin(own_, url); }
+  void end() { if (client_ && !reuse_) client_->stop(); }
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setTimeout(uint16_t ms) { (void)ms; }
+  void addHeader(const String& name, const String& value) { headers_.push_back(name + ": " + value); }
+
+  int GET()                                  { return sendRequest("GET"); }
+  int POST(const String& payload)            { return sendRequest("POST", payload); }
+  int POST(uint8_t* payload, size_t size)    { return send("POST", (const char*)payload, size); }
+  int PUT(const String& payload)             { return sendRequest("PUT", payload); }
+  int PUT(uint8_t* payload, size_t size)     { return send("PUT", (const char*)payload, size); }
+  int sendRequest(const char* type, const String& payload = String()) {
+    return send(type, payload.c_str(), payload.length());
+  }
+  int sendRequest(const char* type, uint8_t* payload, size_t size) {
+    return send(type, (const char*)payload, size);
+  }
+  int sendRequest(const char* type, Stream* stream, size_t size);
+
+  String getString() { return response_; }
+  int    getSize()   { return (int)response_.length(); }
+
+private:
+  int  send(const char* type, const char* body, size_t size);
+  int  connect();   // 0, or the error a dropped connection gives
+  void done();
+
+  WiFiClient          own_;
+  WiFiClient*         client_ = &own_;
+  bool                reuse_  = true;   // as the ESP32 core's
+  String              url_;
+  std::vector<String> headers_;
+  String              response_;
+};
@@ -0,0 +1,34 @@
+#pragma once
+// LittleFS mounted on a host directory (sim::fsRoot). What the firmware
+// writes lands there, kept across runs as the flash keeps it across boots.
+#include <Arduino.h>
+
+class File {
+public:
+  File(FILE* f = nullptr) : f_(f) {}
+  operator bool() const { return f_ != nullptr; }
+  size_t size();
+  size_t read(uint8_t* buf, size_t len) { return f_ ? fread(buf, 1, len, f_) : 0; }
+  size_t write(const uint8_t* buf, size_t len) { return f_ ? fwrite(buf, 1, len, f_) : 0; }
+  void   flush() { if (f_) fflush(f_); }
+  String readString();
+  int    available();
+  void   close() { if (f_) fclose(f_); f_ = nullptr; }
+
+private:
+  FILE* f_;
+};
+
+class LittleFSFS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = "spiffs");
+  void end() { mounted_ = false; }
+  File open(const char* path, const char* mode = "r");
+  bool exists(const char* path);
+  bool remove(const char* path);
+
+private:
+  bool mounted_ = false;
+};
+extern LittleFSFS LittleFS;
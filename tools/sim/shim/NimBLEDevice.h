@@ -0,0 +1,69 @@
+#pragma once
+// Enough of NimBLE-Arduino to build BLE provisioning; nothing advertises.
+#include <stdint.h>
+#include <string>
+
+typedef enum {
+  ESP_PWR_LVL_N12, ESP_PWR_LVL_N9, ESP_PWR_LVL_N6, ESP_PWR_LVL_N3, ESP_PWR_LVL_N0,
+  ESP_PWR_LVL_P3, ESP_PWR_LVL_P6, ESP_PWR_LVL_P9,
+} esp_power_level_t;
+
+namespace NIMBLE_PROPERTY {
+enum : uint16_t { READ = 0x0002, WRITE_NR = 0x0004, WRITE = 0x0008, NOTIFY = 0x0010, INDICATE = 0x0020 };
+}
+
+class NimBLEUUID {
+public:
+  NimBLEUUID(const char* uuid = "") : s_(uuid) {}
+  const std::string& toString() const { return s_; }
+
+private:
+  std::string s_;
+};
+typedef NimBLEUUID BLEUUID;
+
+class NimBLECharacteristic;
+class NimBLECharacteristicCallbacks {
+public:
+  virtual ~NimBLECharacteristicCallbacks() {}
+  virtual void onWrite(NimBLECharacteristic* chr) { (void)chr; }
+};
+
+class NimBLECharacteristic {
+public:
+  void        setCallbacks(NimBLECharacteristicCallbacks* cb) { cb_ = cb; }
+  std::string getValue() const { return value_; }
+  void        setValue(const std::string& v) { value_ = v; }
+
+private:
+  std::string                    value_;
+  NimBLECharacteristicCallbacks* cb_ = nullptr;
+};
+
+class NimBLEService {
+public:
+  NimBLECharacteristic* createCharacteristic(const NimBLEUUID& uuid, uint32_t properties) {
+    (void)uuid; (void)properties;
+    return new NimBLECharacteristic();
+  }
+  bool start() { return true; }
+};
+
+class NimBLEServer {
+public:
+  NimBLEService* createService(const NimBLEUUID& uuid) { (void)uuid; return new NimBLEService(); }
+};
+
+class NimBLEAdvertising {
+public:
+  void addServiceUUID(const NimBLEUUID& uuid) { (void)uuid; }
+  bool start() { return true; }
+};
+
+class NimBLEDevice {
+public:
+  static void               init(const std::string& name) { (void)name; }
+  static void               setPower(esp_power_level_t level) { (void)level; }
+  static NimBLEServer*      createServer() { static NimBLEServer s; return &s; }
+  static NimBLEAdvertising* getAdvertising() { static NimBLEAdvertising a; return &a; }
+};
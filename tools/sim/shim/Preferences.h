@@ -0,0 +1,30 @@
+#pragma once
+// NVS namespaces kept in memory for the run; a reboot is a new run.
+#include <Arduino.h>
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false) { ns_ = name; readOnly_ = readOnly; return true; }
+  void end() { ns_.clear(); }
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t   putString(const char* key, const String& value) { return put(key, value.c_str()) ? value.length() : 0; }
+  size_t   putInt(const char* key, int32_t value)    { return put(key, std::to_string(value)) ? 4 : 0; }
+  size_t   putUInt(const char* key, uint32_t value)  { return put(key, std::to_string(value)) ? 4 : 0; }
+  size_t   putULong(const char* key, uint32_t value) { return putUInt(key, value); }
+  size_t   putBool(const char* key, bool value)      { return put(key, value ? "1" : "0") ? 1 : 0; }
+  String   getString(const char* key, const String& def = String());
+  int32_t  getInt(const char* key, int32_t def = 0);
+  uint32_t getUInt(const char* key, uint32_t def = 0);
+  uint32_t getULong(const char* key, uint32_t def = 0) { return getUInt(key, def); }
+  bool     getBool(const char* key, bool def = false)  { return getInt(key, def) != 0; }
+
+private:
+  bool put(const char* key, const std::string& value);
+  bool get(const char* key, std::string& value);
+
+  std::string ns_;
+  bool        readOnly_ = false;
+};
@@ -0,0 +1,55 @@
+#pragma once
+// Serves the GETs a sim script schedules with sim::requestAt(), one batch
+// per handleClient(); what each handler sent is logged with its time.
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS } HTTPMethod;
+
+class WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit WebServer(int port = 80) : port_(port) {}
+  void begin() { begun_ = true; }
+  void close() { begun_ = false; }
+  void handleClient();
+
+  void on(const String& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn) {
+    routes_.push_back({ uri, method, fn });
+  }
+  void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+
+  String uri() const { return uri_; }
+  String arg(const String& name) const;
+  bool   hasArg(const String& name) const;
+  int    args() const { return (int)args_.size(); }
+
+  void setContentLength(size_t len) { (void)len; }
+  void sendHeader(const String& name, const String& value, bool first = false) {
+    (void)name; (void)value; (void)first;
+  }
+  void send(int code, const char* type = nullptr, const String& content = String()) {
+    (void)type;
+    code_   = code;
+    bytes_ += content.length();
+  }
+  void send(int code, const String& type, const String& content) { send(code, type.c_str(), content); }
+  void sendContent(const char* content, size_t size) { (void)content; bytes_ += size; }
+  void sendContent(const String& content) { bytes_ += content.length(); }
+
+private:
+  struct Route { String uri; HTTPMethod method; THandlerFunction fn; };
+  struct Arg   { String name, value; };
+
+  int                port_;
+  bool               begun_ = false;
+  std::vector<Route> routes_;
+  THandlerFunction   notFound_;
+  String             uri_;
+  std::vector<Arg>   args_;
+  int                code_  = 0;
+  size_t             bytes_ = 0;
+};
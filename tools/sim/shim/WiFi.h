@@ -0,0 +1,71 @@
+#pragma once
+// Station mode only: associates wifiMs of virtual time after begin().
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS    = 0,
+  WL_NO_SSID_AVAIL  = 1,
+  WL_CONNECTED      = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED   = 6,
+} wl_status_t;
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : a_{a, b, c, d} {}
+  String toString() const {
+    char s[16];
+    snprintf(s, sizeof(s), "%u.%u.%u.%u", a_[0], a_[1], a_[2], a_[3]);
+    return String(s);
+  }
+  uint8_t operator[](int i) const { return a_[i]; }
+
+private:
+  uint8_t a_[4];
+};
+
+// A connection is a virtual-time handshake; the server drops it once idle
+// for sim::net().idleMs, which the client only learns on its next request.
+// A plain TCP connect costs nothing; see WiFiClientSecure.
+class WiFiClient {
+public:
+  virtual ~WiFiClient() {}
+  virtual int connect(const char* host, uint16_t port) { return connect(host, port, 0); }
+  virtual int connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    (void)host; (void)port; (void)timeoutMs;
+    open_ = true;
+    resumed_ = false;
+    return 1;
+  }
+  virtual int connect(IPAddress ip, uint16_t port) { return connect(ip, port, 0); }
+  virtual int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    return connect(ip.toString().c_str(), port, timeoutMs);
+  }
+  void    stop() { open_ = false; }
+  uint8_t connected() { return open_; }
+
+protected:
+  bool     open_    = false;
+  bool     resumed_ = false;   // the last connect resumed a TLS session
+
+private:
+  friend class HTTPClient;
+  uint64_t lastUs_ = 0;   // end of the last request on it
+};
+
+class WiFiClass {
+public:
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr);
+  bool        disconnect(bool wifiOff = false);
+  bool        setSleep(bool enabled) { sleep_ = enabled; return true; }
+  bool        getSleep() const { return sleep_; }
+  wl_status_t status();
+  IPAddress   localIP() { return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+  int8_t      RSSI() { return -55; }
+
+private:
+  bool     begun_ = false;
+  bool     sleep_ = false;
+  uint64_t upAt_  = 0;
+};
+extern WiFiClass WiFi;
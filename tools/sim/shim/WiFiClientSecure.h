@@ -0,0 +1,20 @@
+#pragma once
+// No TLS, only its cost: a connect is a full handshake of sim::net().tlsMs
+// on the virtual clock, and fails without a CA (or setInsecure()).
+#include <WiFi.h>
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure()                   { insecure_ = true; }
+  void setCACert(const char* rootCA)   { ca_ = rootCA; }
+  void setCertificate(const char* pem) { (void)pem; }
+  void setPrivateKey(const char* pem)  { (void)pem; }
+  void setHandshakeTimeout(unsigned long) {}
+
+  using WiFiClient::connect;
+  int connect(const char* host, uint16_t port, int32_t timeoutMs) override;
+
+private:
+  bool        insecure_ = false;
+  const char* ca_       = nullptr;
+};
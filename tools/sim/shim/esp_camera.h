@@ -0,0 +1,35 @@
+#pragma once
+// Frames come from the sim::FrameSource installed with sim::camera(); with
+// none, esp_camera_sensor_get() is null and esp_camera_fb_get() fails, as
+// on a board whose camera init failed.
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/time.h>
+#include "esp_err.h"
+
+typedef enum {
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_YUV420,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888,
+  PIXFORMAT_RAW,
+  PIXFORMAT_RGB444,
+  PIXFORMAT_RGB555,
+} pixformat_t;
+
+typedef struct {
+  uint8_t*       buf;
+  size_t         len;
+  size_t         width;
+  size_t         height;
+  pixformat_t    format;
+  struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct _sensor sensor_t;
+
+sensor_t*    esp_camera_sensor_get();
+camera_fb_t* esp_camera_fb_get();
+void         esp_camera_fb_return(camera_fb_t* fb);
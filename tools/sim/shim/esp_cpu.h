@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// Host nanoseconds, so cycle counts read as ns like the libraries' cycleNow()
+uint32_t esp_cpu_get_ccount();
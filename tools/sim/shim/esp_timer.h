@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// µs since boot on the virtual clock
+int64_t esp_timer_get_time();
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void*    TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE             1
+#define pdFALSE            0
+#define pdPASS             pdTRUE
+#define pdFAIL             pdFALSE
+#define portMAX_DELAY      (TickType_t)0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
@@ -0,0 +1,15 @@
+#pragma once
+// Tasks are host threads. The only one the firmware blocks for is the mic
+// sampler, held in lockstep with the virtual clock by the ADC shim; any
+// other task must not block on anything but vTaskDelay() or
+// ulTaskNotifyTake(). A notification wakes its task a microsecond of
+// virtual time later, once the notifier next sleeps.
+#include "FreeRTOS.h"
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core);
+void       vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+uint32_t   ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+
+typedef int gpio_num_t;
+typedef struct { int unused; } gpio_dev_t;
+extern gpio_dev_t GPIO;
+
+int digitalRead(uint8_t pin);
+static inline int gpio_ll_get_level(gpio_dev_t*, gpio_num_t num) { return digitalRead((uint8_t)num); }
@@ -0,0 +1,9 @@
+#pragma once
+// time() on the virtual clock: seconds since boot until configTime() has
+// synced, then sim::net().epoch onward, so runs don't depend on the date.
+#include_next <time.h>
+
+#ifdef __cplusplus
+time_t simTime(time_t* t);
+#define time(t) simTime(t)
+#endif
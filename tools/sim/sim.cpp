@@ -0,0 +1,215 @@
+// Runs src/main.cpp's setup() and loop() on the host, against the shims in
+// shim/ and a virtual clock driven by a recorded night.
+//
+//   sim [options] <mic.wav|mic.csv>
+//
+// The mic trace (the replay tool's formats: WAV, or CSV raw 12-bit ADC
+// samples) plays into the mic pin from boot, through the real MicSampler
+// and its DMA task; the PIR log (CSV "t_ms,level") drives the PIR pin
+// through the real PirEdges interrupt handler. Every HTTPS call the
+// firmware makes is logged with its virtual time and blocks loop() for
+// --http-ms, after --tls-ms (--resume-ms resuming a TLS session) when it
+// opens a connection, as a slow network would. API calls need api_ca.pem
+// in --fs. A whole night runs in well under a minute, so the output can be
+// compared before and after a change, and the binary can be run under perf
+// or gprof to profile loop() itself.
+//
+// Prints JSON: the run's virtual and wall time, loop() cost on the host
+// (time inside delay() excluded), mic delivery, the app call counters and
+// every request made and served.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "Sim.h"
+#include "MicSampler.h"
+#include "WakeScore.h"
+#include "../replay/Trace.h"
+
+#define CAMERA_MODEL_XIAO_ESP32S3
+#include "pins_layout.h"
+
+void setup();
+void loop();
+
+// src/main.cpp's globals, for the summary
+extern MicSampler   mic;
+extern SampleReader cryReader;
+extern WakeScore    wakeScore;
+extern uint32_t     appCalls, clipCount;
+
+static void usage() {
+  fprintf(stderr,
+    "usage: sim [options] <mic.wav|mic.csv>\n"
+    "  --pir FILE             PIR edge log, CSV t_ms,level\n"
+    "  --seconds N            virtual run length (default: the mic trace's)\n"
+    "  --csv-rate HZ          sample rate of a CSV mic trace (default 8000)\n"
+    "  --battery-mv MV        battery voltage on the divider (default 3900)\n"
+    "  --get MS,URI           request URI from the firmware's WebServer at MS (repeatable)\n"
+    "  --fs DIR               LittleFS contents: cry_model.bin, api_ca.pem; written to (default: none)\n"
+    "  --http-ms MS           time each HTTPS request blocks (default 300)\n"
+    "  --tls-ms MS            and the connect + TLS handshake before it (default 600)\n"
+    "  --resume-ms MS         ...when it resumes a TLS session instead (default 150)\n"
+    "  --session-s S          how long the server resumes sessions (default 3600)\n"
+    "  --idle-ms MS           server's keep-alive timeout (default 60000)\n"
+    "  --http-code N          status every request gets (default 200)\n"
+    "  --http-code-at PATH,N  ...but N for URLs ending in PATH (repeatable)\n"
+    "  --offline FROM,TO      server unreachable from FROM to TO s (repeatable)\n"
+    "  --wifi-ms MS           WiFi association time (default 2000)\n"
+    "  --song-s S             length of the cloud lullaby (default 180)\n"
+    "  --epoch S              UTC at boot, once NTP syncs (default 2024-01-01 22:00)\n"
+    "  --serial FILE          serial monitor output (default stderr)\n"
+    "  --quiet                drop the serial output\n");
+  exit(2);
+}
+
+static void jsonString(const std::string& s) {
+  putchar('"');
+  for (unsigned char c : s) {
+    if (c == '"' || c == '\\') printf("\\%c", c);
+    else if (c < 0x20)         printf("\\u%04x", c);
+    else                       putchar(c);
+  }
+  putchar('"');
+}
+
+int main(int argc, char** argv) {
+  const char* micPath = nullptr;
+  const char* pirPath = nullptr;
+  uint32_t    csvRate = RATE, batteryMv = 3900;
+  double      seconds = 0;
+  std::vector<std::pair<uint32_t, std::string>> gets;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if      (!strcmp(a, "--pir"))        pirPath   = next();
+    else if (!strcmp(a, "--seconds"))    seconds   = atof(next());
+    else if (!strcmp(a, "--csv-rate"))   csvRate   = atoi(next());
+    else if (!strcmp(a, "--battery-mv")) batteryMv = atoi(next());
+    else if (!strcmp(a, "--fs"))         sim::fsRoot(next());
+    else if (!strcmp(a, "--http-ms"))    sim::net().httpMs = atoi(next());
+    else if (!strcmp(a, "--tls-ms"))     sim::net().tlsMs    = atoi(next());
+    else if (!strcmp(a, "--resume-ms"))  sim::net().resumeMs = atoi(next());
+    else if (!strcmp(a, "--session-s"))  sim::net().sessionS = atoi(next());
+    else if (!strcmp(a, "--idle-ms"))    sim::net().idleMs   = atoi(next());
+    else if (!strcmp(a, "--http-code"))  sim::net().code     = atoi(next());
+    else if (!strcmp(a, "--wifi-ms"))    sim::net().wifiMs = atoi(next());
+    else if (!strcmp(a, "--song-s"))     sim::net().songMs = atoi(next()) * 1000;
+    else if (!strcmp(a, "--epoch"))      sim::net().epoch  = atoll(next());
+    else if (!strcmp(a, "--quiet"))      sim::serialTo(nullptr);
+    else if (!strcmp(a, "--serial")) {
+      FILE* f = fopen(next(), "w");
+      if (!f) { fprintf(stderr, "can't write %s\n", argv[i]); return 1; }
+      sim::serialTo(f);
+    }
+    else if (!strcmp(a, "--get")) {
+      const char* v = next();
+      const char* comma = strchr(v, ',');
+      if (!comma) usage();
+      gets.push_back({ (uint32_t)atol(v), comma + 1 });
+    }
+    else if (!strcmp(a, "--offline")) {
+      const char* v = next();
+      const char* comma = strchr(v, ',');
+      if (!comma) usage();
+      sim::net().offline.push_back({ (uint32_t)atol(v), (uint32_t)atol(comma + 1) });
+    }
+    else if (!strcmp(a, "--http-code-at")) {
+      const char* v = next();
+      const char* comma = strchr(v, ',');
+      if (!comma) usage();
+      sim::net().codeAt.push_back({ std::string(v, comma - v), atoi(comma + 1) });
+    }
+    else if (a[0] == '-') usage();
+    else                  micPath = a;
+  }
+  if (!micPath) usage();
+
+  static std::vector<int16_t> adc;
+  if (!loadMic(micPath, csvRate, adc)) {
+    fprintf(stderr, "can't read %s (16-bit PCM or IMA-ADPCM WAV, or CSV)\n", micPath);
+    return 1;
+  }
+  if (pirPath && !loadCsv(pirPath, [&](long t, long l) {
+        sim::digitalAt((uint64_t)t * 1000, MOTION_SENSOR_PIN, l != 0);
+      })) {
+    fprintf(stderr, "can't read %s\n", pirPath);
+    return 1;
+  }
+  sim::analogTrace(SOUND_SENSOR_PIN, adc.data(), adc.size(), RATE, ADC_MID);
+  // the divider halves the cell; 12 bits over 3.3 V
+  sim::analogLevel(BAT_ADC_PIN, (int)(batteryMv / 2 * 4095 / 3300));
+  for (auto& g : gets) sim::requestAt((uint64_t)g.first * 1000, g.second);
+  uint64_t endUs = (uint64_t)(seconds > 0 ? seconds * 1e6 : adc.size() * 1e6 / RATE);
+
+  auto wall0 = std::chrono::steady_clock::now();
+  setup();
+  uint64_t setupUs = sim::nowUs();
+
+  std::vector<uint32_t> loopNs;
+  loopNs.reserve((endUs - setupUs) / 10000 + 1);
+  uint32_t worst = 0;
+  uint64_t worstUs = 0;
+  while (sim::nowUs() < endUs) {
+    uint64_t at    = sim::nowUs();
+    uint64_t slept = sim::sleptNs();
+    auto     t0    = std::chrono::steady_clock::now();
+    loop();
+    auto     ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    uint32_t own   = (uint32_t)(ns - (int64_t)(sim::sleptNs() - slept));
+    loopNs.push_back(own);
+    if (own > worst) { worst = own; worstUs = at; }
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+
+  double sum = 0;
+  for (uint32_t v : loopNs) sum += v;
+  auto pct = [&](double p) -> uint32_t {
+    if (loopNs.empty()) return 0;
+    size_t k = (size_t)(p * (loopNs.size() - 1));
+    std::nth_element(loopNs.begin(), loopNs.begin() + k, loopNs.end());
+    return loopNs[k];
+  };
+  uint32_t p50 = pct(0.50), p99 = pct(0.99);
+
+  MicSampler::Stats ms = mic.stats();
+  printf("{\n  \"run\": {\"virtual_s\": %.1f, \"wall_s\": %.2f, \"speedup\": %.0f, \"setup_ms\": %llu, \"loops\": %zu},\n",
+         sim::nowUs() / 1e6, wall, sim::nowUs() / 1e6 / wall, (unsigned long long)(setupUs / 1000), loopNs.size());
+  printf("  \"loop_ns\": {\"mean\": %.0f, \"p50\": %u, \"p99\": %u, \"max\": %u, \"max_at_ms\": %llu},\n",
+         loopNs.empty() ? 0.0 : sum / loopNs.size(), p50, p99, worst, (unsigned long long)(worstUs / 1000));
+  printf("  \"mic\": {\"samples\": %u, \"dropped\": %u, \"cry_reader_overruns\": %u},\n",
+         ms.totalSamples, ms.droppedSamples, cryReader.overruns());
+  printf("  \"calls\": {\"sent\": %u, \"alerts\": %u, \"clips\": %u},\n",
+         appCalls, wakeScore.raised(), clipCount);
+  printf("  \"requests\": [");
+  const std::vector<sim::Request>& reqs = sim::requests();
+  for (size_t i = 0; i < reqs.size(); i++) {
+    const sim::Request& r = reqs[i];
+    printf("%s\n    {\"t_ms\": %llu, \"method\": \"%s\", \"url\": ", i ? "," : "",
+           (unsigned long long)(r.us / 1000), r.method.c_str());
+    jsonString(r.url);
+    printf(", \"code\": %d, \"bytes\": %zu, \"connect\": %s, \"resumed\": %s", r.code, r.bytes,
+           r.connect ? "true" : "false", r.resumed ? "true" : "false");
+    if (!r.body.empty()) {
+      printf(", \"body\": ");
+      jsonString(r.body);
+    }
+    printf("}");
+  }
+  printf("\n  ],\n  \"served\": [");
+  const std::vector<sim::Served>& srv = sim::served();
+  for (size_t i = 0; i < srv.size(); i++) {
+    printf("%s\n    {\"t_ms\": %llu, \"uri\": ", i ? "," : "", (unsigned long long)(srv[i].us / 1000));
+    jsonString(srv[i].uri);
+    printf(", \"code\": %d, \"bytes\": %zu}", srv[i].code, srv[i].bytes);
+  }
+  printf("\n  ]\n}\n");
+  sim::exit(0);
+}
@@ -0,0 +1,28 @@
+// TlsClient's handshake on the virtual clock, for lib/ApiLink/TlsClient.cpp
+// off the ESP32. A full handshake costs sim::net().tlsMs, a resumed one
+// resumeMs. The cached session is the virtual time the server issued it,
+// and the server resumes it for sessionS. While sim::offline() connects
+// time out.
+#include <string.h>
+#include "Sim.h"
+#include "TlsClient.h"
+
+int TlsClient::handshake(const char* host, uint16_t port, int32_t timeoutMs, bool& resumed) {
+  (void)host; (void)port;
+  if (sim::offline()) {
+    sim::sleepUs((uint64_t)(timeoutMs > 0 ? timeoutMs : 5000) * 1000);   // the SYN goes unanswered
+    return 0;
+  }
+  uint64_t now    = sim::nowUs();
+  uint64_t issued = 0;
+  if (cache_ && cache_->len == sizeof(issued)) memcpy(&issued, cache_->session, sizeof(issued));
+  resumed = cache_ && cache_->len == sizeof(issued) && now - issued < (uint64_t)sim::net().sessionS * 1000000;
+  sim::sleepUs((uint64_t)(resumed ? sim::net().resumeMs : sim::net().tlsMs) * 1000);
+  if (cache_ && !resumed) {
+    memcpy(cache_->session, &now, sizeof(now));
+    cache_->len = sizeof(now);
+  }
+  open_    = true;
+  resumed_ = resumed;
+  return 1;
+}
@@ -0,0 +1,372 @@
+// Times full against resumed TLS handshakes on a local stand-in for the
+// API server: what lib/ApiLink/TlsClient's session cache saves.
+//
+//   tlsbench [options]
+//
+// A server thread on 127.0.0.1 plays the API server: TLS 1.2, which is what
+// the device's mbedtls speaks, a P-256 ECDSA certificate made at start (or
+// --cert/--key), and both session IDs and tickets. The client offers the
+// device's suites and curves in its order and verifies the server against
+// the certificate as CA, as TlsClient does. Each connection is a TCP
+// connect, the handshake and one small request and response, made --n
+// times in each mode:
+//
+//   full    no session to offer
+//   ticket  the previous connection's session, resumed from its ticket
+//   id      the same with tickets off: resumed from the server's cache
+//
+// --rtt-ms delays every turn of the conversation by a round trip, as the
+// nursery Wi-Fi would, so the round trips resumption saves show next to
+// the crypto. --serve runs the stand-in server alone, for a device pointed
+// at it; --connect benchmarks another server instead (with --ca).
+//
+// Prints JSON: per mode, the handshake time (TCP connect included) mean,
+// p50, p95 and max, the round trips and bytes of a whole connection, and
+// how many handshakes were resumed. The host's OpenSSL is at both ends:
+// the numbers compare the modes; the device's own are on its "TLS:" status
+// line.
+//
+// No Arduino dependency: plain Linux, see the Makefile.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+
+// TlsClient's CIPHERSUITES and CURVES, in OpenSSL's names
+static const char* CIPHERS =
+  "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+  "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384:"
+  "ECDHE-ECDSA-AES128-SHA256:ECDHE-RSA-AES128-SHA256";
+static const char* GROUPS = "P-256:X25519:P-384";
+
+static const char REQUEST[]  = "GET /api/ping HTTP/1.1\r\nHost: localhost\r\n\r\n";
+static const char RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+
+static void usage() {
+  fprintf(stderr,
+    "usage: tlsbench [options]\n"
+    "  --n N                  connections per mode (default 50)\n"
+    "  --rtt-ms MS            round trip added to every turn (default 0)\n"
+    "  --cert FILE --key FILE server certificate and key, PEM (default: a fresh P-256 one)\n"
+    "  --serve PORT           run the stand-in server only, until killed\n"
+    "  --connect HOST:PORT    benchmark this server instead, verified with --ca\n"
+    "  --ca FILE              CA for --connect, PEM\n");
+  exit(2);
+}
+
+[[noreturn]] static void fail(const char* what) {
+  fprintf(stderr, "%s\n", what);
+  ERR_print_errors_fp(stderr);
+  exit(1);
+}
+
+// --- the conversation, counted -------------------------------------------------
+// A filter BIO under the client's SSL: counts bytes each way, and sleeps a
+// round trip whenever a read follows a write, i.e. the client waits on the
+// server's answer.
+struct Wire {
+  uint32_t rttUs;
+  bool     wrote;
+  uint32_t trips;
+  uint64_t out, in;
+};
+
+static void roundTrip(Wire* w) {
+  if (w->rttUs) std::this_thread::sleep_for(std::chrono::microseconds(w->rttUs));
+  w->trips++;
+}
+
+static int wireWrite(BIO* b, const char* buf, size_t n, size_t* done) {
+  Wire* w = (Wire*)BIO_get_data(b);
+  int   r = BIO_write_ex(BIO_next(b), buf, n, done);
+  BIO_clear_retry_flags(b);
+  BIO_copy_next_retry(b);
+  if (r) {
+    w->wrote = true;
+    w->out  += *done;
+  }
+  return r;
+}
+
+static int wireRead(BIO* b, char* buf, size_t n, size_t* done) {
+  Wire* w = (Wire*)BIO_get_data(b);
+  if (w->wrote) {
+    roundTrip(w);
+    w->wrote = false;
+  }
+  int r = BIO_read_ex(BIO_next(b), buf, n, done);
+  BIO_clear_retry_flags(b);
+  BIO_copy_next_retry(b);
+  if (r) w->in += *done;
+  return r;
+}
+
+static long wireCtrl(BIO* b, int cmd, long num, void* ptr) {
+  return BIO_ctrl(BIO_next(b), cmd, num, ptr);
+}
+
+static int wireCreate(BIO* b) {
+  BIO_set_init(b, 1);
+  return 1;
+}
+
+static BIO_METHOD* wireMethod() {
+  static BIO_METHOD* m = nullptr;
+  if (!m) {
+    m = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_FILTER, "wire");
+    BIO_meth_set_write_ex(m, wireWrite);
+    BIO_meth_set_read_ex(m, wireRead);
+    BIO_meth_set_ctrl(m, wireCtrl);
+    BIO_meth_set_create(m, wireCreate);
+  }
+  return m;
+}
+
+// --- the stand-in server --------------------------------------------------------
+static void makeCert(EVP_PKEY** key, X509** cert) {
+  *key = EVP_EC_gen("P-256");
+  *cert = X509_new();
+  if (!*key || !*cert) fail("can't make a key");
+  X509_set_version(*cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(*cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(*cert), -3600);
+  X509_gmtime_adj(X509_getm_notAfter(*cert), 86400);
+  X509_set_pubkey(*cert, *key);
+  X509_NAME* name = X509_get_subject_name(*cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+  X509_set_issuer_name(*cert, name);
+  X509V3_CTX v3;
+  X509V3_set_ctx_nodb(&v3);
+  X509V3_set_ctx(&v3, *cert, *cert, nullptr, nullptr, 0);
+  const char* exts[][2] = { { "basicConstraints", "critical,CA:TRUE" },
+                            { "subjectAltName", "DNS:localhost,IP:127.0.0.1" } };
+  for (auto& e : exts) {
+    X509_EXTENSION* ext = X509V3_EXT_conf(nullptr, &v3, e[0], e[1]);
+    if (!ext) fail("can't make the certificate");
+    X509_add_ext(*cert, ext, -1);
+    X509_EXTENSION_free(ext);
+  }
+  if (!X509_sign(*cert, *key, EVP_sha256())) fail("can't sign the certificate");
+}
+
+static SSL_CTX* serverCtx(const char* certPath, const char* keyPath, X509** cert) {
+  SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_set_session_id_context(ctx, (const unsigned char*)"tlsbench", 8);
+  SSL_CTX_set1_groups_list(ctx, GROUPS);
+  if (certPath) {
+    if (SSL_CTX_use_certificate_chain_file(ctx, certPath) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx, keyPath, SSL_FILETYPE_PEM) != 1) {
+      fail("can't load --cert/--key");
+    }
+    *cert = SSL_CTX_get0_certificate(ctx);
+    X509_up_ref(*cert);
+  } else {
+    EVP_PKEY* key;
+    makeCert(&key, cert);
+    SSL_CTX_use_certificate(ctx, *cert);
+    SSL_CTX_use_PrivateKey(ctx, key);
+    EVP_PKEY_free(key);
+  }
+  return ctx;
+}
+
+static int listenOn(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0), one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a = {};
+  a.sin_family      = AF_INET;
+  a.sin_addr.s_addr = port ? htonl(INADDR_ANY) : htonl(INADDR_LOOPBACK);
+  a.sin_port        = htons(port);
+  if (bind(fd, (sockaddr*)&a, sizeof(a)) || listen(fd, 16)) fail("can't listen");
+  return fd;
+}
+
+// One connection at a time: the handshake, a request, the response.
+static void serve(SSL_CTX* ctx, int lfd, bool log) {
+  for (int fd; (fd = accept(lfd, nullptr, nullptr)) >= 0; ) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    SSL* ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    auto t0 = std::chrono::steady_clock::now();
+    char buf[1024];
+    if (SSL_accept(ssl) == 1) {
+      if (log) {
+        fprintf(stderr, "%s %s, %.1f ms\n", SSL_session_reused(ssl) ? "resumed" : "full",
+                SSL_get_cipher_name(ssl),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+      }
+      if (SSL_read(ssl, buf, sizeof(buf)) > 0) SSL_write(ssl, RESPONSE, sizeof(RESPONSE) - 1);
+      SSL_shutdown(ssl);
+    } else if (log) {
+      ERR_print_errors_fp(stderr);
+    }
+    SSL_free(ssl);
+    close(fd);
+  }
+}
+
+// --- the client -------------------------------------------------------------------
+struct Mode {
+  Mode(const char* n) : name(n) {}
+  const char*         name;
+  std::vector<double> ms;
+  uint32_t            resumed = 0, trips = 0;
+  uint64_t            out = 0, in = 0;
+  std::string         cipher;
+};
+
+static int dial(const std::string& host, const std::string& port) {
+  addrinfo hints = {}, *ai;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &ai)) fail("can't resolve the server");
+  int fd = socket(ai->ai_family, SOCK_STREAM, 0);
+  if (connect(fd, ai->ai_addr, ai->ai_addrlen)) fail("can't connect");
+  freeaddrinfo(ai);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+// One connection; `session` is offered if set and replaced by the new one.
+static void connection(SSL_CTX* ctx, const std::string& host, const std::string& port, uint32_t rttUs,
+                       SSL_SESSION** session, Mode& m) {
+  Wire wire = { rttUs, false, 0, 0, 0 };
+  auto t0   = std::chrono::steady_clock::now();
+  int  fd   = dial(host, port);
+  roundTrip(&wire);   // SYN, SYN-ACK
+  SSL* ssl  = SSL_new(ctx);
+  BIO* bio  = BIO_new(wireMethod());
+  BIO_set_data(bio, &wire);
+  BIO_push(bio, BIO_new_socket(fd, BIO_CLOSE));
+  SSL_set_bio(ssl, bio, bio);
+  SSL_set_tlsext_host_name(ssl, host.c_str());
+  SSL_set1_host(ssl, host.c_str());
+  if (*session) SSL_set_session(ssl, *session);
+  if (SSL_connect(ssl) != 1) fail("handshake failed");
+  m.ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+  m.resumed += SSL_session_reused(ssl);
+  m.cipher   = SSL_get_cipher_name(ssl);
+
+  char buf[1024];
+  SSL_write(ssl, REQUEST, sizeof(REQUEST) - 1);
+  while (SSL_read(ssl, buf, sizeof(buf)) > 0) {}
+  if (*session) SSL_SESSION_free(*session);
+  *session = SSL_get1_session(ssl);
+  SSL_shutdown(ssl);
+  m.trips += wire.trips;
+  m.out   += wire.out;
+  m.in    += wire.in;
+  SSL_free(ssl);
+}
+
+static SSL_CTX* clientCtx(X509* ca, const char* caPath, bool tickets) {
+  SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_cipher_list(ctx, CIPHERS);
+  SSL_CTX_set1_groups_list(ctx, GROUPS);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+  if (!tickets) SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+  if (ca) X509_STORE_add_cert(SSL_CTX_get_cert_store(ctx), ca);
+  else if (SSL_CTX_load_verify_locations(ctx, caPath, nullptr) != 1) fail("can't load --ca");
+  return ctx;
+}
+
+static double pct(std::vector<double> v, double p) {
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+int main(int argc, char** argv) {
+  int         n = 50, servePort = -1;
+  uint32_t    rttMs = 0;
+  const char *certPath = nullptr, *keyPath = nullptr, *caPath = nullptr, *target = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    auto next = [&]() -> const char* { if (++i >= argc) usage(); return argv[i]; };
+    if      (!strcmp(a, "--n"))       n         = atoi(next());
+    else if (!strcmp(a, "--rtt-ms"))  rttMs     = atoi(next());
+    else if (!strcmp(a, "--cert"))    certPath  = next();
+    else if (!strcmp(a, "--key"))     keyPath   = next();
+    else if (!strcmp(a, "--serve"))   servePort = atoi(next());
+    else if (!strcmp(a, "--connect")) target    = next();
+    else if (!strcmp(a, "--ca"))      caPath    = next();
+    else usage();
+  }
+  if (n < 1 || !certPath != !keyPath || !target != !caPath || (target && servePort >= 0)) usage();
+
+  std::string host = "localhost", port;
+  X509*       ca   = nullptr;
+  if (target) {
+    const char* colon = strrchr(target, ':');
+    if (!colon) usage();
+    host = std::string(target, colon - target);
+    port = colon + 1;
+  } else {
+    SSL_CTX* sctx = serverCtx(certPath, keyPath, &ca);
+    int      lfd  = listenOn(servePort > 0 ? servePort : 0);
+    if (servePort >= 0) {
+      fprintf(stderr, "serving on port %d\n", servePort);
+      serve(sctx, lfd, true);
+      return 0;
+    }
+    sockaddr_in a;
+    socklen_t   len = sizeof(a);
+    getsockname(lfd, (sockaddr*)&a, &len);
+    port = std::to_string(ntohs(a.sin_port));
+    std::thread(serve, sctx, lfd, false).detach();
+  }
+
+  Mode modes[] = { { "full" }, { "ticket" }, { "id" } };
+  for (Mode& m : modes) {
+    bool     tickets = strcmp(m.name, "id") != 0;
+    SSL_CTX* ctx     = clientCtx(ca, caPath, tickets);
+    SSL_SESSION* session = nullptr;
+    if (strcmp(m.name, "full")) {
+      Mode warmup = { "warmup" };
+      connection(ctx, host, port, rttMs * 1000, &session, warmup);   // a session to start from
+    }
+    for (int i = 0; i < n; i++) {
+      connection(ctx, host, port, rttMs * 1000, &session, m);
+      if (!strcmp(m.name, "full")) {
+        SSL_SESSION_free(session);
+        session = nullptr;
+      }
+    }
+    if (session) SSL_SESSION_free(session);
+    SSL_CTX_free(ctx);
+  }
+
+  printf("{\n  \"server\": \"%s:%s\", \"stand_in\": %s, \"rtt_ms\": %u, \"n\": %d,\n  \"modes\": {",
+         host.c_str(), port.c_str(), target ? "false" : "true", rttMs, n);
+  for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); i++) {
+    const Mode& m = modes[i];
+    double sum = 0;
+    for (double v : m.ms) sum += v;
+    printf("%s\n    \"%s\": {\"resumed\": %u, \"cipher\": \"%s\", \"ms_mean\": %.2f, \"ms_p50\": %.2f, "
+           "\"ms_p95\": %.2f, \"ms_max\": %.2f, \"round_trips\": %.1f, \"bytes_out\": %.0f, \"bytes_in\": %.0f}",
+           i ? "," : "", m.name, m.resumed, m.cipher.c_str(), sum / n, pct(m.ms, 0.5), pct(m.ms, 0.95),
+           pct(m.ms, 1.0), (double)m.trips / n, (double)m.out / n, (double)m.in / n);
+  }
+  printf("\n  }\n}\n");
+  return 0;
+}